@@ -0,0 +1,53 @@
+// AlignedAllocator.h
+// A minimal standard allocator that returns storage aligned for SIMD loads.
+
+#ifndef AlignedAllocator_h__
+#define AlignedAllocator_h__
+
+#include <cstddef>
+#include <new>
+
+namespace Geometry {
+
+// Alignment used by all batch containers.  32 bytes covers AVX; 64 would
+// also cover AVX-512 and a full cache line.
+const std::size_t simdAlignment = 64;
+
+////////////////////////////////////////////////////////////
+//
+// class AlignedAllocator
+//
+// Allocates arrays of T on an Alignment byte boundary so that batch kernels
+// can use aligned vector loads.  Intended for use with std::vector.
+
+template <typename T, std::size_t Alignment = simdAlignment>
+class AlignedAllocator {
+public:
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+	// Creators
+	AlignedAllocator() {}
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+	// Modifiers
+	T* allocate(std::size_t n) {
+		return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+	}
+	void deallocate(T* p, std::size_t) {
+		::operator delete(p, std::align_val_t(Alignment));
+	}
+};
+
+template <typename T, typename U, std::size_t A>
+bool operator==(const AlignedAllocator<T, A>&, const AlignedAllocator<U, A>&) { return true; }
+
+template <typename T, typename U, std::size_t A>
+bool operator!=(const AlignedAllocator<T, A>&, const AlignedAllocator<U, A>&) { return false; }
+
+} // namespace Geometry
+
+#endif // AlignedAllocator_h__
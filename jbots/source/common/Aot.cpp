@@ -0,0 +1,448 @@
+// Aot.cpp
+// Translates robot programs ahead of time into C++, built by the system
+// compiler into plug-ins for the Cpu's compiled tier.
+
+#include "Aot.h"
+
+#include <cstdio>           // fopen(), rename(), remove()
+#include <cstdlib>          // system()
+#include <vector>
+
+#if JBOTS_AOT
+#include <dlfcn.h>
+#include <unistd.h>         // getpid()
+#endif
+
+namespace Vm {
+
+namespace {
+
+// What the generated code starts with: the Machine and Intrinsic as Module
+// and Bytecode.h declare them, and the arithmetic of binary<>(), one function per operator.
+const char* const prelude = R"plugin(// Generated from a robot program by jbots; do not edit.
+
+#include <cstdint>
+
+namespace Vm {
+class Host;
+}
+
+namespace Plugin {
+
+typedef std::int32_t Word;
+typedef std::uint32_t U;
+typedef Word (*Trampoline)(Vm::Host* host, std::uint32_t& random, const Word* args);
+
+struct Intrinsic {
+	const char* name;
+	int arity;
+	Trampoline call;
+};
+
+struct Machine {
+	Word* stack;
+	int pc;
+	int sp;
+	int csp;
+	int mark;
+	Word tos;
+	long long cycles;
+	Vm::Host* host;
+	std::uint32_t* random;
+	const Intrinsic* intrinsics;
+};
+
+inline Word add(const Word x, const Word y) { return static_cast<Word>(static_cast<U>(x) + static_cast<U>(y)); }
+inline Word sub(const Word x, const Word y) { return static_cast<Word>(static_cast<U>(x) - static_cast<U>(y)); }
+inline Word mul(const Word x, const Word y) { return static_cast<Word>(static_cast<U>(x) * static_cast<U>(y)); }
+inline Word div(const Word x, const Word y) { return y == 0 ? 0 : y == -1 ? static_cast<Word>(0 - static_cast<U>(x)) : x / y; }
+inline Word mod(const Word x, const Word y) { return y == 0 || y == -1 ? 0 : x % y; }
+inline Word shl(const Word x, const Word y) { return static_cast<Word>(static_cast<U>(x) << (y & 31)); }
+inline Word shr(const Word x, const Word y) { return x >> (y & 31); }
+inline Word band(const Word x, const Word y) { return x & y; }
+inline Word bor(const Word x, const Word y) { return x | y; }
+inline Word bxor(const Word x, const Word y) { return x ^ y; }
+inline Word land(const Word x, const Word y) { return x != 0 && y != 0; }
+inline Word lor(const Word x, const Word y) { return x != 0 || y != 0; }
+inline Word lt(const Word x, const Word y) { return x < y; }
+inline Word le(const Word x, const Word y) { return x <= y; }
+inline Word eq(const Word x, const Word y) { return x == y; }
+inline Word ne(const Word x, const Word y) { return x != y; }
+inline Word ge(const Word x, const Word y) { return x >= y; }
+inline Word gt(const Word x, const Word y) { return x > y; }
+
+} // namespace Plugin
+
+)plugin";
+
+// The prelude's names for the operators, in BinOp's order.
+const char* const operators[Instruction::binops] = {
+	"", "add", "sub", "mul", "div", "mod", "shl", "shr", "band", "bor", "bxor",
+	"land", "lor", "lt", "le", "eq", "ne", "ge", "gt"
+};
+
+// What the Cpu makes of an instruction when it threads it; anything it
+// cannot run restarts main().
+enum Kind {
+	nop, fetchLocal, fetchExternal, storeLocal, storeExternal, updateLocal, updateExternal,
+	constant, binop, call, callIntrinsic, retsub, branch, chop, frame, restart
+};
+
+struct Decoded {
+	Kind kind;
+	Word operand;   // as Cpu::Threaded's
+	int extra;      // an operator, or a call's locals
+};
+
+Decoded decode(const Image& image, const Instruction& in) {
+	const int end = static_cast<int>(image.code.size());
+	const bool isExternal = (in.operand & external) != 0;
+	const Word offset = in.operand & ~external;
+	const bool variable = isExternal ? offset >= 0 && offset < image.externals
+	                                 : in.operand >= 0 && in.operand < maxVariables;
+	Decoded d = { restart, offset, 0 };
+	switch (in.op) {
+	case Instruction::nop:
+		d.kind = nop;
+		break;
+	case Instruction::fetch:
+		if (variable)
+			d.kind = isExternal ? fetchExternal : fetchLocal;
+		break;
+	case Instruction::store:
+		if (variable && in.opcode == Instruction::assign)
+			d.kind = isExternal ? storeExternal : storeLocal;
+		else if (variable && in.opcode < Instruction::binops) {
+			d.kind = isExternal ? updateExternal : updateLocal;
+			d.extra = in.opcode;
+		}
+		break;
+	case Instruction::constant:
+		d.kind = constant;
+		d.operand = in.operand;
+		break;
+	case Instruction::binop:
+		if (in.opcode > Instruction::assign && in.opcode < Instruction::binops) {
+			d.kind = binop;
+			d.extra = in.opcode;
+		}
+		break;
+	case Instruction::fcall:
+		if (in.operand >= 0 && in.operand < static_cast<Word>(image.links.size())) {
+			const Link& link = image.links[in.operand];
+			if (link.entry >= 0 && link.entry < end && link.locals >= 0 && link.locals <= maxVariables) {
+				d.kind = call;
+				d.operand = link.entry;
+				d.extra = link.locals;
+			}
+		} else if (in.operand < 0 && -1 - in.operand < Intrinsic::count) {
+			d.kind = callIntrinsic;
+			d.operand = -1 - in.operand;
+		}
+		break;
+	case Instruction::retsub:
+		d.kind = retsub;
+		break;
+	case Instruction::branch:
+		if (in.operand >= 0 && in.operand <= end) {
+			d.kind = branch;
+			d.operand = in.operand;
+		}
+		break;
+	case Instruction::chop:
+		d.kind = chop;
+		break;
+	case Instruction::frame:
+		d.kind = frame;
+		break;
+	}
+	return d;
+}
+
+// Whether control never falls through to the next instruction, or falls
+// through only when a branch is not taken.
+bool ends(const Kind kind) {
+	return kind == call || kind == retsub || kind == branch || kind == restart;
+}
+
+////////////////////////////////////////////////////////////
+//
+// class Writer
+//
+// Appends the generated code a line at a time.
+
+class Writer {
+private:
+	std::string& m_out;
+
+public:
+	explicit Writer(std::string& out) : m_out(out) {}
+
+	Writer& operator<<(const char* text) { m_out += text; return *this; }
+	Writer& operator<<(const std::string& text) { m_out += text; return *this; }
+	Writer& operator<<(const long long n) { m_out += std::to_string(n); return *this; }
+};
+
+// One instruction, as the Cpu's handler for it does it.  Straight through
+// a block, its cycles were taken on the way in, and 'refund' are given back
+// if it stops early; otherwise 'refund' is negative, and the instruction
+// takes its own cycle.
+void instruction(Writer& w, const Decoded& d, const int pc, const int refund) {
+	const std::string over = refund > 0 ? "{ cycles += " + std::to_string(refund) + "; goto overflow; }"
+	                                    : std::string("goto overflow;");
+	const std::string push = "if (sp + 1 >= csp) " + over + "\n\t*sp++ = tos;\n\ttos = ";
+	if (refund < 0)
+		w << "\tif (!cycles) { pc = " << pc << "; goto stop; }\n\t--cycles;\n";
+	switch (d.kind) {
+	case nop:
+		break;
+	case fetchLocal:
+		w << "\t" << push << "mark[" << d.operand << "];\n";
+		break;
+	case fetchExternal:
+		w << "\t" << push << "base[" << d.operand << "];\n";
+		break;
+	case storeLocal:
+		w << "\tmark[" << d.operand << "] = tos;\n";
+		break;
+	case storeExternal:
+		w << "\tbase[" << d.operand << "] = tos;\n";
+		break;
+	case updateLocal:
+		w << "\ttos = mark[" << d.operand << "] = " << operators[d.extra] << "(mark[" << d.operand << "], tos);\n";
+		break;
+	case updateExternal:
+		w << "\ttos = base[" << d.operand << "] = " << operators[d.extra] << "(base[" << d.operand << "], tos);\n";
+		break;
+	case constant:
+		w << "\t" << push << d.operand << ";\n";
+		break;
+	case binop:
+		w << "\t--sp; tos = " << operators[d.extra] << "(*sp, tos);\n";
+		break;
+	case call:
+		// the arguments, pushed since the FRAME, become the first locals
+		w << "\t*sp = tos;\n\t{\n"
+		  << "\t\tWord* const args = base + *csp + 1;\n"
+		  << "\t\tWord* const top = args + " << d.extra << ";\n"
+		  << "\t\tif (top + 2 >= csp) " << over << "\n"
+		  << "\t\tfor (Word* p = sp + 1; p < top; ++p) *p = 0;\n"
+		  << "\t\t*--csp = " << pc + 1 << ";\n"
+		  << "\t\t*--csp = static_cast<Word>(mark - base);\n"
+		  << "\t\tmark = args;\n\t\tsp = top;\n\t}\n"
+		  << "\tgoto b" << d.operand << ";\n";
+		break;
+	case callIntrinsic:
+		w << "\t*sp = tos;\n\t{\n"
+		  << "\t\tWord* const args = base + *csp++ + 1;\n"
+		  << "\t\tWord padded[2] = { 0, 0 };\n"
+		  << "\t\tconst Word* argv = args;\n"
+		  << "\t\tif (sp + 1 - args < " << intrinsics[d.operand].arity << ") {\n"
+		  << "\t\t\tfor (Word* p = args; p <= sp; ++p) padded[p - args] = *p;\n"
+		  << "\t\t\targv = padded;\n\t\t}\n"
+		  << "\t\ttos = m->intrinsics[" << d.operand << "].call(m->host, *m->random, argv);\n"
+		  << "\t\tsp = args;\n\t}\n";
+		break;
+	case retsub:
+		w << "\tmark = base + *csp++;\n\tpc = *csp++;\n\tsp = base + *csp++ + 1;\n\tgoto dispatch;\n";
+		break;
+	case branch:
+		w << "\t{ const Word condition = tos; tos = *--sp; if (!condition) goto b" << d.operand << "; }\n";
+		break;
+	case chop:
+		w << "\ttos = *--sp;\n";
+		break;
+	case frame:
+		w << "\tif (csp - 1 <= sp) " << over << "\n\t*--csp = static_cast<Word>(sp - base);\n";
+		break;
+	case restart:
+		w << "\tm->cycles = cycles;\n\treturn " << Module::restart << ";\n";
+		break;
+	}
+}
+
+#if JBOTS_AOT
+
+// Wrapped in single quotes for the shell.
+std::string quoted(const std::string& text) {
+	std::string q = "'";
+	for (std::size_t i = 0; i < text.size(); ++i)
+		q += text[i] == '\'' ? std::string("'\\''") : std::string(1, text[i]);
+	return q + "'";
+}
+
+bool write(const std::string& path, const std::string& text) {
+	std::FILE* const file = std::fopen(path.c_str(), "wb");
+	if (!file)
+		return false;
+	const bool written = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+	return std::fclose(file) == 0 && written;
+}
+
+#endif // JBOTS_AOT
+
+} // namespace
+
+////////////////////////////////////////////////////////////
+// transpile()
+
+// Each basic block is written twice.  Entered at the top with the cycles
+// for all of it, it takes them at once and runs straight through; entered
+// anywhere else, or short of cycles, each instruction takes its own and
+// may stop.  Both fall into the next block's top, and calls and branches
+// go to their targets' tops.  Returns go through a switch on the pc, as
+// does resuming where the last run stopped.
+void transpile(const Image& image, std::string& source) {
+	const int end = static_cast<int>(image.code.size());
+	std::vector<Decoded> decoded(end + 1);
+	for (int pc = 0; pc < end; ++pc)
+		decoded[pc] = decode(image, image.code[pc]);
+	decoded[end].kind = restart; // as if main() had returned
+
+	std::vector<bool> starts;
+	entries(image, starts);
+	starts[0] = true;
+	for (int pc = 0; pc < end; ++pc)
+		if (ends(decoded[pc].kind))
+			starts[pc + 1] = true;
+
+	source = prelude;
+	Writer w(source);
+	w << "namespace Plugin {\n\n"
+	  << "int run(Machine* const m) {\n"
+	  << "\tWord* const base = m->stack;\n"
+	  << "\tWord* sp = base + m->sp;\n"
+	  << "\tWord* csp = base + m->csp;\n"
+	  << "\tWord* mark = base + m->mark;\n"
+	  << "\tWord tos = m->tos;\n"
+	  << "\tlong long cycles = m->cycles;\n"
+	  << "\tint pc = m->pc;\n\n"
+	  << "dispatch:\n\tswitch (pc) {\n";
+	for (int pc = 0; pc <= end; ++pc)
+		w << "\tcase " << pc << ": goto " << (starts[pc] ? "b" : "s") << pc << ";\n";
+	w << "\tdefault: goto s" << end << ";\n\t}\n";
+
+	for (int start = 0; start <= end; ) {
+		int next = start + 1;
+		while (next <= end && !starts[next])
+			++next;
+		const int cost = next - start;
+		w << "\nb" << start << ":\n"
+		  << "\tif (cycles < " << cost << ") goto s" << start << ";\n"
+		  << "\tcycles -= " << cost << ";\n";
+		for (int pc = start; pc < next; ++pc)
+			instruction(w, decoded[pc], pc, next - pc - 1);
+		if (!ends(decoded[next - 1].kind) || decoded[next - 1].kind == branch)
+			w << "\tgoto b" << next << ";\n";
+		for (int pc = start; pc < next; ++pc) {
+			w << "s" << pc << ":\n";
+			instruction(w, decoded[pc], pc, -1);
+		}
+		start = next;
+	}
+
+	w << "\noverflow:\n"
+	  << "\tm->cycles = cycles;\n"
+	  << "\treturn " << Module::overflow << ";\n"
+	  << "\nstop:\n"
+	  << "\tm->pc = pc;\n"
+	  << "\tm->sp = static_cast<int>(sp - base);\n"
+	  << "\tm->csp = static_cast<int>(csp - base);\n"
+	  << "\tm->mark = static_cast<int>(mark - base);\n"
+	  << "\tm->tos = tos;\n"
+	  << "\tm->cycles = 0;\n"
+	  << "\treturn " << Module::stopped << ";\n}\n\n"
+	  << "} // namespace Plugin\n\n"
+	  << "extern \"C\" int jbots_abi() { return " << Module::abi << "; }\n"
+	  << "extern \"C\" int jbots_run(Plugin::Machine* m) { return Plugin::run(m); }\n";
+}
+
+#if JBOTS_AOT
+
+////////////////////////////////////////////////////////////
+// class Module
+
+bool Module::open(const std::string& path) {
+	close();
+	m_handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if (!m_handle)
+		return false;
+	typedef int (*Abi)();
+	const Abi version = reinterpret_cast<Abi>(dlsym(m_handle, "jbots_abi"));
+	const Run run = reinterpret_cast<Run>(dlsym(m_handle, "jbots_run"));
+	if (!version || !run || version() != abi) {
+		close();
+		return false;
+	}
+	m_run = run;
+	return true;
+}
+
+void Module::close() {
+	if (m_handle)
+		dlclose(m_handle);
+	m_handle = 0;
+	m_run = 0;
+}
+
+#else // !JBOTS_AOT
+
+bool Module::open(const std::string&) { return false; }
+void Module::close() {}
+
+#endif // JBOTS_AOT
+
+////////////////////////////////////////////////////////////
+// class Aot
+
+const char* const Aot::defaultCommand = "c++ -O2 -shared -fPIC";
+
+// 64-bit FNV-1a, of the command as well as the source.
+std::string Aot::hash(const std::string& source) const {
+	std::uint64_t h = 14695981039346656037ull;
+	const std::string keys[2] = { m_command + '\n', source };
+	for (int k = 0; k < 2; ++k)
+		for (std::size_t i = 0; i < keys[k].size(); ++i)
+			h = (h ^ static_cast<unsigned char>(keys[k][i])) * 1099511628211ull;
+	char name[17];
+	std::snprintf(name, sizeof name, "%016llx", static_cast<unsigned long long>(h));
+	return name;
+}
+
+#if JBOTS_AOT
+
+const Module* Aot::load(const Image& image) {
+	std::string source;
+	transpile(image, source);
+	const std::string name = hash(source);
+	Module& module = m_modules[name];
+	if (module.loaded())
+		return &module;
+
+	const std::string path = m_directory + "/" + name;
+	if (module.open(path + ".so"))
+		return &module;
+
+	// built under names of this process's own, then renamed into place, so
+	// that processes building the same robot at once do not see each
+	// other's half-written files
+	const std::string own = path + "." + std::to_string(static_cast<long>(getpid()));
+	const bool built = write(own + ".cpp", source) &&
+	                   std::system((m_command + " -o " + quoted(own + ".so") + " " + quoted(own + ".cpp")).c_str()) == 0 &&
+	                   std::rename((own + ".cpp").c_str(), (path + ".cpp").c_str()) == 0 &&
+	                   std::rename((own + ".so").c_str(), (path + ".so").c_str()) == 0;
+	if (built && module.open(path + ".so"))
+		return &module;
+	std::remove((own + ".cpp").c_str());
+	std::remove((own + ".so").c_str());
+	m_modules.erase(name);
+	return 0;
+}
+
+#else // !JBOTS_AOT
+
+const Module* Aot::load(const Image&) { return 0; }
+
+#endif // JBOTS_AOT
+
+} // namespace Vm
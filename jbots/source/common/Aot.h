@@ -0,0 +1,130 @@
+// Aot.h
+// Translates robot programs ahead of time into C++, built by the system
+// compiler into plug-ins for the Cpu's compiled tier.
+
+#ifndef Aot_h__
+#define Aot_h__
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "Bytecode.h"
+
+// Plug-ins are loaded with dlopen(); define JBOTS_AOT to 0 to leave them
+// out anywhere.
+#if !defined(JBOTS_AOT)
+#if defined(__unix__) || defined(__APPLE__)
+#define JBOTS_AOT 1
+#else
+#define JBOTS_AOT 0
+#endif
+#endif
+
+namespace Vm {
+
+////////////////////////////////////////////////////////////
+//
+// class Module
+//
+// One robot program, translated and loaded.  A plug-in exports
+//
+//	extern "C" int jbots_abi();                 // Module::abi
+//	extern "C" int jbots_run(Module::Machine*);
+//
+// jbots_run() runs the Machine until its cycles are spent, main() has to
+// be entered again or the stack has overflowed, says which, and leaves the
+// registers where it stopped.  It keeps no state of its own, so one Module
+// serves any number of Cpus at once.
+
+class Module {
+public:
+	static const int abi = 1;
+
+	// The Cpu's registers, as offsets into its stack like the Cpu keeps
+	// them; generated code knows the layout.
+	struct Machine {
+		Word* stack;
+		int pc;
+		int sp;
+		int csp;
+		int mark;
+		Word tos;
+		long long cycles;
+		Host* host;
+		std::uint32_t* random;
+		const Intrinsic* intrinsics;
+	};
+
+	enum Status { stopped, restart, overflow };
+
+	typedef int (*Run)(Machine* machine);
+
+private:
+	void* m_handle;
+	Run m_run;
+
+	Module(const Module&);
+	Module& operator=(const Module&);
+
+public:
+	// Creators
+	Module() : m_handle(0), m_run(0) {}
+	~Module() { close(); }
+
+	// Accessors
+	bool loaded() const { return m_run != 0; }
+	Run run() const { return m_run; }
+
+	// Modifiers
+	// Loads the plug-in at 'path', closing any other.  Returns false, and is
+	// left closed, if it cannot be loaded or was built for another abi.
+	bool open(const std::string& path);
+	void close();
+};
+
+// Sets 'source' to a plug-in for 'image', in C++ that needs nothing but the
+// standard library.  The same image always gives the same source.
+void transpile(const Image& image, std::string& source);
+
+////////////////////////////////////////////////////////////
+//
+// class Aot
+//
+// Builds and loads Modules, keeping every plug-in it builds in a directory
+// named by the hash of its source and the command that built it, so that
+// a robot is only compiled once however many matches, or processes, play
+// it.  The command gets the output then the source appended, as in
+// "c++ -O2 -shared -fPIC -o robot.so robot.cpp".
+
+class Aot {
+public:
+	static const char* const defaultCommand;
+
+private:
+	std::string m_directory;
+	std::string m_command;
+	std::map<std::string, Module> m_modules; // by hash
+
+public:
+	// Creators
+	explicit Aot(const std::string& directory, const std::string& command = defaultCommand)
+		: m_directory(directory), m_command(command) {}
+
+	// Accessors
+	// Whether this build and platform can load plug-ins at all.
+	static bool available() { return JBOTS_AOT != 0; }
+	const std::string& directory() const { return m_directory; }
+	// The file name, less its extension, of the plug-in for 'source'.
+	std::string hash(const std::string& source) const;
+
+	// Modifiers
+	// The Module for 'image', loaded from the directory, or built there if
+	// it is missing or stale.  0 if it could not be built or loaded; the
+	// Module lives as long as the Aot.
+	const Module* load(const Image& image);
+};
+
+} // namespace Vm
+
+#endif // Aot_h__
@@ -0,0 +1,166 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <dirent.h>         // opendir()
+#include <unistd.h>         // rmdir()
+
+#include "../Shared/Aot.h"
+#include "../Shared/Compiler.h"
+#include "../Shared/Cpu.h"
+#include "../Shared/SampleRobots.h"
+#include "../Shared/Tiers.test.h"
+
+namespace {
+
+// An empty directory, for a test that must start without any plug-ins.
+// Only this user can write to it, so nobody else can plant a plug-in there
+// for the test to load.
+std::string temporary() {
+	char name[] = "/tmp/jbots-aot-XXXXXX";
+	return mkdtemp(name) ? name : "";
+}
+
+// A temporary() directory that is removed, with whatever was built in it,
+// when it goes out of scope.  Declare it before the Aot that uses it.
+class Scratch {
+private:
+	std::string m_path;
+
+	Scratch(const Scratch&);
+	Scratch& operator=(const Scratch&);
+
+public:
+	Scratch() : m_path(temporary()) {}
+	~Scratch() {
+		if (DIR* const directory = opendir(m_path.c_str())) {
+			while (const dirent* const entry = readdir(directory))
+				if (entry->d_name[0] != '.')
+					std::remove((m_path + "/" + entry->d_name).c_str());
+			closedir(directory);
+		}
+		rmdir(m_path.c_str());
+	}
+
+	const std::string& path() const { return m_path; }
+};
+
+}
+
+using TierTest::agree;
+
+SUITE(AotTestSuite) {
+
+TEST(TranspilesTheSameImageTheSameWay) {
+	Vm::Image sniper, rook;
+	CHECK(Vm::compile(Vm::Samples::sniper, sniper));
+	CHECK(Vm::compile(Vm::Samples::rook, rook));
+	std::string first, second, other;
+	Vm::transpile(sniper, first);
+	Vm::transpile(sniper, second);
+	Vm::transpile(rook, other);
+	CHECK(first == second);
+	CHECK(first != other);
+	CHECK(first.find("extern \"C\" int jbots_run(") != std::string::npos);
+
+	Vm::Aot aot("/tmp");
+	CHECK(aot.hash(first) == aot.hash(second));
+	CHECK(aot.hash(first) != aot.hash(other));
+	CHECK(Vm::Aot("/tmp", "c++ -O1 -shared -fPIC").hash(first) != aot.hash(first));
+}
+
+TEST(CachesPluginsBySourceHash) {
+	Vm::Image image;
+	CHECK(Vm::compile(Vm::Samples::rabbit, image));
+	std::string source;
+	Vm::transpile(image, source);
+	const std::string directory = temporary();
+	const std::string path = directory + "/" + Vm::Aot(directory).hash(source);
+	{
+		Vm::Aot aot(directory);
+		const Vm::Module* const module = aot.load(image);
+		if (!Vm::Aot::available()) {
+			CHECK(!module);
+			return;
+		}
+		CHECK(module && module->loaded());
+		CHECK(aot.load(image) == module);
+	}
+
+	// another Aot, as in another process, loads what is there without
+	// building it: here with a command that builds nothing, and so a hash
+	// of its own
+	const std::string renamed = directory + "/" + Vm::Aot(directory, "false").hash(source);
+	CHECK(std::rename((path + ".so").c_str(), (renamed + ".so").c_str()) == 0);
+	{
+		Vm::Aot again(directory, "false");
+		CHECK(again.load(image) != 0);
+	}
+	CHECK(std::remove((renamed + ".so").c_str()) == 0);
+	CHECK(!Vm::Aot(directory, "false").load(image));
+
+	std::remove((path + ".cpp").c_str());
+	CHECK(rmdir(directory.c_str()) == 0);
+}
+
+TEST(OperatorsMatchTheStackTier) {
+	const Scratch cache;
+	Vm::Aot aot(cache.path());
+	for (int o = 0; o < TierTest::operatorCount; ++o) {
+		Vm::Image image;
+		CHECK(Vm::compile(TierTest::operatorProgram(o), image));
+		const Vm::Module* const module = aot.load(image);
+		CHECK(module || !Vm::Aot::available());
+		if (!module)
+			return;
+		CHECK(agree(image, *module, 5000, 1));
+		CHECK(agree(image, *module, 5000, 200));
+	}
+}
+
+TEST(SamplesMatchTheStackTier) {
+	const char* const robots[] = { Vm::Samples::rabbit, Vm::Samples::counter, Vm::Samples::rook, Vm::Samples::sniper };
+	const Scratch cache;
+	Vm::Aot aot(cache.path());
+	for (int r = 0; r < 4; ++r) {
+		Vm::Image image;
+		CHECK(Vm::compile(robots[r], image));
+		const Vm::Module* const module = aot.load(image);
+		CHECK(module || !Vm::Aot::available());
+		if (!module)
+			continue;
+		CHECK(agree(image, *module, 200000, 1));
+		// stopping anywhere, inside a block or not
+		CHECK(agree(image, *module, 20000, 5000));
+	}
+}
+
+TEST(OverflowsAndRestartsWhereTheStackTierDoes) {
+	// recursion until the stack is full, with frames of every size, and a
+	// main() that returns
+	const Scratch cache;
+	Vm::Aot aot(cache.path());
+	std::string locals = "a";
+	for (int k = 0; k < 8; ++k, locals += ", v" + std::to_string(k)) {
+		Vm::Image image;
+		CHECK(Vm::compile(
+			"int depth, x;\n"
+			"main() { x = x + 1; if (x & 1) return; depth = 0; x = f(1); }\n"
+			"f(n) int n; { int " + locals + "; depth = n;\n"
+			"  a = 1 + (2 + (3 + (4 + (5 + damage())))) + sqrt(6 + n) * 3;\n"
+			"  return (f(n + 1) + a); }\n", image));
+		const Vm::Module* const module = aot.load(image);
+		CHECK(module || !Vm::Aot::available());
+		if (!module)
+			continue;
+		Vm::Cpu cpu(image, *module);
+		cpu.run(100000);
+		CHECK(cpu.overflows() > 0);
+		CHECK(agree(image, *module, 100000, 1));
+		CHECK(agree(image, *module, 100000, 3000));
+	}
+}
+
+}
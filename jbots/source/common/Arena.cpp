@@ -0,0 +1,181 @@
+// Arena.cpp
+// The world that Server::Bot queries and acts on.
+
+#include "Arena.h"
+
+#include <cmath>
+
+#include "Blast.h"
+
+namespace Server {
+
+namespace {
+
+// An angle to the nearest whole degree, within +/- 359; 0 for NaN and
+// infinities.
+int wholeDegrees(const Geometry::Angle& angle) {
+	const double d = std::fmod(angle.as_d(), 360.0);
+	return d == d ? static_cast<int>(std::floor(d + 0.5)) : 0;
+}
+
+} // namespace
+
+static_assert(Arena::maxResolution == ScanTable::maxResolution, "scan() limits what its ScanTable can see");
+
+////////////////////////////////////////////////////////////
+// class Arena
+
+Arena::Arena(const std::size_t robots, const int reloadTicks)
+	: m_bodies(robots), m_grid(size, size), m_missiles(robots, reloadTicks), m_scans(robots), m_moved(0),
+	  m_capacity(robots)
+{
+	m_drives.reserve(robots);
+	m_damage.reserve(robots);
+	m_alive.reserve(robots);
+	m_cold.reserve(robots);
+	m_nearby.reserve(robots);
+	m_contacts.reserve(robots);
+	m_collided.reserve(robots);
+	m_blastX.reserve(m_missiles.capacity());
+	m_blastY.reserve(m_missiles.capacity());
+}
+
+double Arena::scan(const Id self, const Geometry::Angle& direction,
+                   const Geometry::Angle& resolution)
+{
+	if (!alive(self))
+		return 0.0;
+	++m_cold[self].stats.scans;
+	return m_scans.scan(self, m_moved, Geometry::points(m_bodies),
+	                    wholeDegrees(direction), wholeDegrees(resolution), m_alive.data());
+}
+
+Arena::Id Arena::enter(const Geometry::Point& position, const Geometry::Angle& facing,
+                       const std::string& name)
+{
+	if (robots() == m_capacity)
+		return none;
+	const Id robot = m_bodies.add(Geometry::Entity(position, facing, 0.0));
+	m_drives.push_back(Geometry::Drive::crobots(fullSpeed));
+	m_damage.push_back(0);
+	m_alive.push_back(1);
+	m_cold.push_back(Cold());
+	m_cold.back().name = name;
+	m_grid.insert(robot, position);
+	++m_moved;
+	return robot;
+}
+
+void Arena::place(const Id robot, const Geometry::Point& position) {
+	m_bodies[robot].setPosition(position);
+	if (alive(robot))
+		m_grid.update(robot, position);
+	++m_moved;
+}
+
+void Arena::leave(const Id robot) {
+	m_alive[robot] = 0;
+	m_bodies[robot].setSpeed(0.0);
+	m_drives[robot].stop();
+	m_grid.remove(robot);
+	++m_moved;
+}
+
+bool Arena::launch(const Id owner, const Geometry::Angle& direction, const double range) {
+	if (!alive(owner))
+		return false;
+	const double r = range < 0.0 ? 0.0 : range > cannonRange ? cannonRange : range;
+	if (!m_missiles.valid(m_missiles.fire(owner, position(owner), direction, r)))
+		return false;
+	++m_cold[owner].stats.shots;
+	return true;
+}
+
+void Arena::drive(const Id robot, const Geometry::Angle& heading, const double speed) {
+	if (alive(robot))
+		m_drives[robot].set(heading, speed / 100.0 * fullSpeed);
+}
+
+void Arena::advance() {
+	m_blastX.clear();
+	m_blastY.clear();
+	m_missiles.tick();
+	for (std::size_t slot = 0; slot < m_missiles.capacity(); ++slot) {
+		if (!m_missiles.live(slot))
+			continue;
+		MissilePool::Missile& missile = m_missiles.missile(slot);
+		missile.travelled += missileSpeed;
+		if (missile.travelled >= missile.range) {
+			missile.travelled = missile.range;
+			const Geometry::Point at = missile.position();
+			m_blastX.push_back(at.x()); // within the capacity reserved for it
+			m_blastY.push_back(at.y());
+			m_missiles.explode(m_missiles.handle(slot));
+		}
+	}
+}
+
+void Arena::collide() {
+	const std::size_t n = robots();
+	m_sweep.update(Geometry::points(m_bodies), robotRadius);
+	m_contacts.clear();
+	m_sweep.findContacts(m_contacts);
+
+	// every pair is judged on the speeds before any of them stopped
+	m_collided.assign(n, 0);
+	for (std::size_t c = 0; c < m_contacts.size(); ++c) {
+		const Id a = m_contacts[c].first, b = m_contacts[c].second;
+		if (!m_alive[a] || !m_alive[b] || (speed(a) == 0.0 && speed(b) == 0.0))
+			continue;
+		m_damage[a] += collisionDamage;
+		m_damage[b] += collisionDamage;
+		++m_cold[a].stats.collisions;
+		++m_cold[b].stats.collisions;
+		m_collided[a] = m_collided[b] = 1;
+	}
+	for (Id i = 0; i < n; ++i) {
+		if (!m_collided[i])
+			continue;
+		m_bodies[i].setSpeed(0.0);
+		m_drives[i].stop();
+	}
+}
+
+void Arena::tick() {
+	const std::size_t n = robots();
+	for (Id i = 0; i < n; ++i) {
+		if (!m_alive[i])
+			continue;
+		Geometry::EntityBatch::Ref body = m_bodies[i];
+		m_drives[i].steer(body);
+	}
+	m_bodies.moveAll(); // the dead are at rest
+	++m_moved;
+
+	for (Id i = 0; i < n; ++i) {
+		if (!m_alive[i])
+			continue;
+		const double x = m_bodies.x()[i], y = m_bodies.y()[i];
+		if (x < 0.0 || x > size || y < 0.0 || y > size) {
+			Geometry::EntityBatch::Ref body = m_bodies[i];
+			body.setPosition(Geometry::Point(x < 0.0 ? 0.0 : x > size ? size : x,
+			                                 y < 0.0 ? 0.0 : y > size ? size : y));
+			body.setSpeed(0.0);
+			m_drives[i].stop();
+			m_damage[i] += collisionDamage;
+			++m_cold[i].stats.collisions;
+		}
+		m_grid.update(i, position(i));
+		++m_cold[i].stats.ticks;
+	}
+	collide();
+
+	advance();
+	applyBlasts(explosions(), m_grid, m_damage.data(), m_nearby);
+
+	for (Id i = 0; i < n; ++i)
+		if (m_alive[i] && m_damage[i] >= deadly)
+			leave(i);
+}
+
+} // namespace Server
@@ -0,0 +1,167 @@
+// Arena.h
+// The world that Server::Bot queries and acts on: every robot's state, and
+// the missiles in flight.
+
+#ifndef Arena_h__
+#define Arena_h__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Collision.h"
+#include "Geometry.h"
+#include "MissilePool.h"
+#include "Proximity.h"
+#include "ScanTable.h"
+#include "SpatialGrid.h"
+
+namespace Server {
+
+////////////////////////////////////////////////////////////
+//
+// struct BotStats
+//
+// What a robot has done over a match, for the scoreboard.
+
+struct BotStats {
+	long scans;
+	long shots;      // missiles actually fired
+	long collisions; // with a wall or another robot
+	long ticks;      // ticks survived
+
+	BotStats() : scans(0), shots(0), collisions(0), ticks(0) {}
+};
+
+////////////////////////////////////////////////////////////
+//
+// class Arena
+//
+// Owns every robot.  What tick() reads and writes for every robot is kept
+// hot, in arrays indexed by Id: position, facing and speed in an
+// EntityBatch, then the drives and damage.  Names and statistics are kept
+// cold, in a separate array that only the scoreboard walks.  Server::Bot
+// is a handle onto one robot here.
+//
+// Each tick, bodies are kept sorted along x in a SweepAndPrune, which finds
+// the robots that ran into one another in time proportional to the number
+// of robots, not their pairs.
+//
+// scan() answers from the scanning robot's ScanTable, built by its first
+// scan after any robot moved and read in whole degrees, as CROBOTS does,
+// by every later one.  Positions are also filed in a SpatialGrid, so that
+// a blast only looks at the robots near it, and missiles are kept in a
+// MissilePool sized for the whole field up front.  Nothing here allocates
+// after construction, so scan() and launch() can be called millions of
+// times a second.
+
+class Arena {
+public:
+	typedef Geometry::SpatialGrid::Id Id;
+	static const Id none = Geometry::SpatialGrid::none;
+
+	static constexpr double size = 1000.0;        // each side, in meters
+	static constexpr double maxResolution = 10.0;  // scan(), +/- degrees
+	static constexpr double cannonRange = 700.0;   // meters
+	static constexpr double missileSpeed = 10.0;   // meters per tick
+	static constexpr double fullSpeed = 1.0;       // a robot's, meters per tick
+	static constexpr double robotRadius = 2.5;     // robots closer than twice this collide
+	static const int collisionDamage = 2;          // percent, to each robot
+	static const int deadly = 100;                 // percent damage
+
+private:
+	struct Cold {
+		std::string name;
+		BotStats stats;
+	};
+
+	// hot
+	Geometry::EntityBatch m_bodies;
+	std::vector<Geometry::Drive> m_drives;
+	std::vector<int> m_damage;             // percent
+	std::vector<unsigned char> m_alive;
+	Geometry::SpatialGrid m_grid;          // the live robots
+	MissilePool m_missiles;
+	std::vector<double> m_blastX, m_blastY; // this tick's explosions
+	std::vector<Id> m_nearby;              // scratch for applyBlasts()
+	ScanTables m_scans;                    // by Id
+	ScanTable::Tick m_moved;               // counts changes of position, for m_scans
+	Geometry::SweepAndPrune m_sweep;       // every body, for collide()
+	std::vector<Geometry::Contact> m_contacts; // scratch for collide()
+	std::vector<unsigned char> m_collided; // scratch for collide(), by Id
+
+	// cold
+	std::vector<Cold> m_cold;
+	std::size_t m_capacity;
+
+public:
+	// Creators
+	// Room for 'robots' robots and their missiles.
+	explicit Arena(const std::size_t robots,
+	               const int reloadTicks = MissilePool::defaultReloadTicks);
+
+	// Accessors
+	std::size_t capacity() const { return m_capacity; }
+	std::size_t robots() const { return m_bodies.size(); }
+	const Geometry::EntityBatch& bodies() const { return m_bodies; }
+	const Geometry::SpatialGrid& grid() const { return m_grid; }
+	const MissilePool& missiles() const { return m_missiles; }
+
+	Geometry::Point position(const Id robot) const { return Geometry::Point(m_bodies.x()[robot], m_bodies.y()[robot]); }
+	Geometry::Angle facing(const Id robot) const { return Geometry::Angle(m_bodies.facing()[robot]); }
+	double speed(const Id robot) const { return m_bodies.speed()[robot]; }
+	int damage(const Id robot) const { return m_damage[robot]; }
+	bool alive(const Id robot) const { return m_alive[robot] != 0; }
+	const std::string& name(const Id robot) const { return m_cold[robot].name; }
+	const BotStats& stats(const Id robot) const { return m_cold[robot].stats; }
+
+	// Where the missiles that reached their range in the last advance()
+	// exploded, ready for applyBlasts().
+	Geometry::PointSet explosions() const {
+		return Geometry::PointSet(m_blastX.data(), m_blastY.data(), m_blastX.size());
+	}
+
+	// Modifiers
+	// Adds a robot, at rest.  Returns none once at capacity().
+	Id enter(const Geometry::Point& position, const Geometry::Angle& facing = Geometry::Angle(),
+	         const std::string& name = std::string());
+	void place(const Id robot, const Geometry::Point& position);
+	void leave(const Id robot); // as if destroyed
+
+	// The distance from robot 'self' to the nearest other live robot whose
+	// bearing is within +/- 'resolution' of 'direction', or 0 if there is
+	// none.  As in CROBOTS, everything is in whole degrees, bearings and
+	// the arguments rounded to the nearest, and the range is rounded to
+	// whole meters; the resolution is made positive and limited to
+	// maxResolution degrees.  See ScanTable.
+	double scan(const Id self, const Geometry::Angle& direction,
+	            const Geometry::Angle& resolution);
+
+	// Fires a missile from robot 'owner' toward 'direction', to explode after
+	// 'range' meters; ranges are limited to 0 to cannonRange.  Returns false,
+	// and fires nothing, while the robot's cannon is reloading.
+	bool launch(const Id owner, const Geometry::Angle& direction, const double range);
+
+	// Sets the heading, and the speed in percent of fullSpeed, that the
+	// robot's drive works toward from the next tick.
+	void drive(const Id robot, const Geometry::Angle& heading, const double speed);
+
+	// Moves every missile missileSpeed meters, or to the end of its range,
+	// where it explodes; see explosions().  Also counts down the reloads.
+	void advance();
+
+	// Damages and stops both robots of every live pair that overlap, as
+	// CROBOTS does, if either of them was moving; robots at rest against
+	// one another are not hurt again every tick.
+	void collide();
+
+	// One whole tick: every live robot's drive is stepped and the robots
+	// moved together; robots that reach a wall stop there and are damaged,
+	// and so are robots that collide().  Then the missiles advance, their
+	// blasts are applied, and robots with deadly damage leave.
+	void tick();
+};
+
+} // namespace Server
+
+#endif // Arena_h__
@@ -0,0 +1,201 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <cmath>
+
+#include "../Shared/Arena.h"
+#include "../Shared/Bot.h"
+
+namespace {
+
+Geometry::Angle degrees(const double d) { return Geometry::Angle::d2r(d); }
+
+}
+
+SUITE(ArenaTestSuite) {
+
+TEST(ScanFindsNearestInCone) {
+	Server::Arena arena(4);
+	const Server::Arena::Id self = arena.enter(Geometry::Point(100, 100));
+	arena.enter(Geometry::Point(400, 100));  // due east, 300 m
+	arena.enter(Geometry::Point(300, 100));  // due east, 200 m
+	arena.enter(Geometry::Point(100, 150));  // due north, 50 m
+
+	CHECK_CLOSE(200.0, arena.scan(self, degrees(0), degrees(0)), 1e-9);
+	CHECK_CLOSE(50.0, arena.scan(self, degrees(90), degrees(5)), 1e-9);
+	CHECK_EQUAL(0.0, arena.scan(self, degrees(180), degrees(10)));
+	// resolution is limited to 10 degrees
+	CHECK_EQUAL(0.0, arena.scan(self, degrees(60), degrees(45)));
+	CHECK_CLOSE(50.0, arena.scan(self, degrees(80), degrees(-10)), 1e-9);
+}
+
+TEST(ScanReadsWholeDegrees) {
+	// bearings of 10.4 and 10.6 degrees round to 10 and 11, so only the
+	// first is at the edge of a 10 degree scan; the same as ScanTable's
+	Server::Arena arena(3);
+	const Server::Arena::Id self = arena.enter(Geometry::Point(100, 100));
+	const Server::Arena::Id inside = arena.enter(Geometry::Point(100 + 300 * std::cos(degrees(10.4).as_r()),
+	                                                             100 + 300 * std::sin(degrees(10.4).as_r())));
+	CHECK_EQUAL(300.0, arena.scan(self, degrees(0), degrees(10)));
+	CHECK_EQUAL(300.0, arena.scan(self, degrees(0.4), degrees(10.4)));
+	CHECK_EQUAL(0.0, arena.scan(self, degrees(-0.6), degrees(10)));
+
+	arena.place(inside, Geometry::Point(100 + 200 * std::cos(degrees(10.6).as_r()),
+	                                    100 + 200 * std::sin(degrees(10.6).as_r())));
+	CHECK_EQUAL(0.0, arena.scan(self, degrees(0), degrees(10)));
+	CHECK_EQUAL(200.0, arena.scan(self, degrees(1), degrees(10)));
+
+	Server::ScanTable table;
+	table.build(0, arena.position(self), Geometry::points(arena.bodies()), self);
+	CHECK_EQUAL(table.scan(0, 10), arena.scan(self, degrees(0), degrees(10)));
+	CHECK_EQUAL(table.scan(1, 10), arena.scan(self, degrees(1), degrees(10)));
+
+	// a table is rebuilt once robots have moved
+	const Server::Arena::Id mover = arena.enter(Geometry::Point(100, 300));
+	CHECK_EQUAL(200.0, arena.scan(self, degrees(90), degrees(0)));
+	arena.drive(mover, degrees(90), 100);
+	for (int i = 0; i < 20; ++i)
+		arena.tick();
+	CHECK(arena.scan(self, degrees(90), degrees(0)) > 200.0);
+	arena.leave(mover);
+	CHECK_EQUAL(0.0, arena.scan(self, degrees(90), degrees(0)));
+}
+
+TEST(LaunchLimitsMissilesInFlight) {
+	Server::Arena arena(2, 0); // no reload time, only the two missile limit
+	const Server::Arena::Id a = arena.enter(Geometry::Point(100, 100));
+	const Server::Arena::Id b = arena.enter(Geometry::Point(900, 900));
+	CHECK_EQUAL(Server::Arena::none, arena.enter(Geometry::Point(500, 500)));
+
+	CHECK(arena.launch(a, degrees(45), 1000));
+	CHECK(arena.launch(a, degrees(405), 15));
+	CHECK(!arena.launch(a, degrees(0), 100));
+	CHECK(arena.launch(b, degrees(180), 30));
+	CHECK_EQUAL(3u, arena.missiles().size());
+	CHECK_EQUAL(2, arena.missiles().inFlight(a));
+
+	// the 15 m missile explodes on the second tick, the 30 m one on the third
+	arena.advance();
+	CHECK_EQUAL(0u, arena.explosions().count);
+	arena.advance();
+	CHECK_EQUAL(1u, arena.explosions().count);
+	CHECK_CLOSE(100 + 15 * std::sqrt(0.5), arena.explosions().x[0], 1e-6);
+	CHECK_CLOSE(100 + 15 * std::sqrt(0.5), arena.explosions().y[0], 1e-6);
+	CHECK_EQUAL(1, arena.missiles().inFlight(a));
+	CHECK(arena.launch(a, degrees(0), 100));
+	arena.advance();
+	CHECK_EQUAL(1u, arena.explosions().count);
+	CHECK_CLOSE(870.0, arena.explosions().x[0], 1e-9);
+	CHECK_CLOSE(900.0, arena.explosions().y[0], 1e-9);
+
+	// ranges are limited to the cannon's
+	for (int i = 0; i < 66; ++i)
+		arena.advance();
+	CHECK_EQUAL(1u, arena.missiles().size());
+	arena.advance();
+	CHECK_EQUAL(0u, arena.missiles().size());
+}
+
+TEST(LaunchWaitsForReload) {
+	Server::Arena arena(1, 3);
+	const Server::Arena::Id a = arena.enter(Geometry::Point(100, 100));
+	CHECK(arena.launch(a, degrees(0), 700));
+	CHECK(!arena.launch(a, degrees(0), 700));
+	arena.advance();
+	arena.advance();
+	CHECK(!arena.launch(a, degrees(0), 700));
+	arena.advance();
+	CHECK(arena.launch(a, degrees(0), 700));
+}
+
+TEST(BotActsThroughArena) {
+	Server::Arena arena(2);
+	const Server::Bot hunter(arena, arena.enter(Geometry::Point(100, 100), degrees(0), "hunter"));
+	const Server::Bot target(arena, arena.enter(Geometry::Point(100, 400), degrees(0), "target"));
+	CHECK_EQUAL("hunter", hunter.name());
+	CHECK_EQUAL(100.0, target.health());
+
+	CHECK_CLOSE(300.0, hunter.scan(degrees(90), degrees(2)), 1e-9);
+	CHECK(hunter.fire(degrees(90), 300));
+	CHECK(!hunter.fire(degrees(90), 300)); // reloading
+	CHECK_EQUAL(1, arena.stats(hunter.id()).scans);
+	CHECK_EQUAL(1, arena.stats(hunter.id()).shots);
+
+	// drive north at full speed; the grid follows the bot
+	hunter.drive(degrees(90), 100);
+	for (int i = 0; i < 20; ++i)
+		arena.tick();
+	CHECK(hunter.position().y() > 100.0);
+	CHECK_EQUAL(std::floor(400.5 - hunter.position().y()), hunter.scan(degrees(90), degrees(0))); // whole meters
+
+	// the missile landed on the target after 30 ticks
+	for (int i = 0; i < 10; ++i)
+		arena.tick();
+	CHECK_EQUAL(90.0, target.health());
+
+	const Server::Bot outside;
+	CHECK(!outside.valid());
+	CHECK_EQUAL(0.0, outside.scan(degrees(0), degrees(10)));
+	CHECK(!outside.fire(degrees(0), 100));
+}
+
+TEST(RobotsThatMeetCollide) {
+	Server::Arena arena(4, 0);
+	const Server::Bot east(arena, arena.enter(Geometry::Point(400, 500)));
+	const Server::Bot west(arena, arena.enter(Geometry::Point(440, 500)));
+	const Server::Bot resting(arena, arena.enter(Geometry::Point(700, 700)));
+	const Server::Bot against(arena, arena.enter(Geometry::Point(703, 700)));
+
+	// head on, at full speed; both stop and both are damaged, once
+	east.drive(degrees(0), 100);
+	west.drive(degrees(180), 100);
+	for (int i = 0; i < 60; ++i)
+		arena.tick();
+	CHECK(west.position().x() - east.position().x() < 2 * Server::Arena::robotRadius);
+	CHECK_EQUAL(0.0, east.speed());
+	CHECK_EQUAL(0.0, west.speed());
+	CHECK_EQUAL(Server::Arena::collisionDamage, arena.damage(east.id()));
+	CHECK_EQUAL(Server::Arena::collisionDamage, arena.damage(west.id()));
+	CHECK_EQUAL(1, arena.stats(east.id()).collisions);
+	CHECK_EQUAL(1, arena.stats(west.id()).collisions);
+
+	// robots at rest together are not hurt, but one that drives into
+	// another hurts both
+	CHECK_EQUAL(0, arena.damage(resting.id()));
+	CHECK_EQUAL(0, arena.damage(against.id()));
+	against.drive(degrees(180), 50);
+	arena.tick();
+	CHECK_EQUAL(Server::Arena::collisionDamage, arena.damage(resting.id()));
+	CHECK_EQUAL(Server::Arena::collisionDamage, arena.damage(against.id()));
+	CHECK_EQUAL(0.0, against.speed());
+}
+
+TEST(TickStopsAtWallsAndRemovesTheDead) {
+	Server::Arena arena(2, 0);
+	const Server::Bot runner(arena, arena.enter(Geometry::Point(995, 500)));
+	const Server::Bot sitter(arena, arena.enter(Geometry::Point(500, 500)));
+
+	runner.drive(degrees(0), 100);
+	for (int i = 0; i < 30; ++i)
+		arena.tick();
+	CHECK_EQUAL(Server::Arena::size, runner.position().x());
+	CHECK_EQUAL(0.0, runner.speed());
+	CHECK_EQUAL(Server::Arena::collisionDamage, arena.damage(runner.id()));
+	CHECK_EQUAL(1, arena.stats(runner.id()).collisions);
+
+	// ten direct hits of 10%, two missiles in flight at a time
+	for (int i = 0; i < 10; ++i) {
+		CHECK(runner.fire(degrees(180), 500));
+		arena.tick();
+		if (i % 2 == 1)
+			for (int k = 0; k < 50; ++k)
+				arena.tick();
+	}
+	for (int k = 0; k < 50; ++k)
+		arena.tick();
+	CHECK(!sitter.alive());
+	CHECK_EQUAL(0.0, sitter.scan(degrees(0), degrees(10)));
+	CHECK_EQUAL(0.0, runner.scan(degrees(180), degrees(10)));
+	CHECK(!sitter.fire(degrees(0), 100));
+}
+
+}
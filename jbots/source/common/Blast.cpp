@@ -0,0 +1,58 @@
+// Blast.cpp
+// Missile blast damage for every explosion of a tick, resolved in one pass.
+
+#include "Blast.h"
+
+#include "Simd.h"
+
+namespace Server {
+
+namespace {
+
+// Squared ring radii, innermost first.
+const double nearSquared = 5.0 * 5.0;
+const double middleSquared = 20.0 * 20.0;
+const double farSquared = blastReach * blastReach;
+
+} // namespace
+
+const BlastRing blastRing[blastRings] = {
+	{ 5.0, 10 },
+	{ 20.0, 5 },
+	{ blastReach, 3 },
+};
+
+int blastDamage(const double d2) {
+	return d2 < nearSquared ? blastRing[0].damage
+	     : d2 < middleSquared ? blastRing[1].damage
+	     : d2 < farSquared ? blastRing[2].damage
+	     : 0;
+}
+
+void applyBlasts(const Geometry::PointSet& explosions, const Geometry::PointSet& bots,
+                 int* damage, const unsigned char* alive)
+{
+	const Geometry::Rings rings = {
+		{ nearSquared, middleSquared, farSquared },
+		{ blastRing[0].damage, blastRing[1].damage, blastRing[2].damage },
+	};
+	const Geometry::Kernels& kernels = Geometry::kernels();
+	for (std::size_t e = 0; e < explosions.count; ++e)
+		kernels.rings(explosions.x[e], explosions.y[e], bots.x, bots.y, alive, bots.count, rings, damage);
+}
+
+void applyBlasts(const Geometry::PointSet& explosions, const Geometry::SpatialGrid& bots,
+                 int* damage, std::vector<Geometry::SpatialGrid::Id>& nearby)
+{
+	for (std::size_t e = 0; e < explosions.count; ++e) {
+		const Geometry::Point center(explosions.x[e], explosions.y[e]);
+		nearby.clear();
+		bots.within(center, blastReach, nearby);
+		for (std::size_t k = 0; k < nearby.size(); ++k) {
+			const Geometry::SpatialGrid::Id id = nearby[k];
+			damage[id] += blastDamage(Geometry::distanceSquared(center, bots.position(id)));
+		}
+	}
+}
+
+} // namespace Server
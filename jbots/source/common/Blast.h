@@ -0,0 +1,53 @@
+// Blast.h
+// Missile blast damage for every explosion of a tick, resolved in one pass.
+
+#ifndef Blast_h__
+#define Blast_h__
+
+#include <cstddef>
+#include <vector>
+
+#include "Proximity.h"
+#include "SpatialGrid.h"
+
+namespace Server {
+
+////////////////////////////////////////////////////////////
+//
+// Blast rings
+//
+// CROBOTS damage, in percent, to a robot near an exploding missile: 10%
+// within 5 meters, 5% within 20 and 3% within 40.  Only the innermost ring
+// that reaches the robot counts, and a ring reaches a robot strictly inside
+// its radius.  Every explosion deals its damage separately.
+
+struct BlastRing {
+	double radius;
+	int damage;
+};
+
+const int blastRings = 3;
+extern const BlastRing blastRing[blastRings]; // innermost first
+
+// The largest distance at which an explosion does any damage.
+const double blastReach = 40.0;
+
+// The damage one explosion does at the given squared distance.
+int blastDamage(const double distanceSquared);
+
+// Adds to damage[i] what every explosion of the tick does to bots[i].  Bots
+// whose 'alive' entry is 0 are skipped when 'alive' is given.  Explosions
+// are taken one at a time against the whole bot array, a loop of squared
+// distance compares that the compiler can vectorize.
+void applyBlasts(const Geometry::PointSet& explosions, const Geometry::PointSet& bots,
+                 int* damage, const unsigned char* alive = 0);
+
+// The same, using a grid of the live bots, filed under their bot index, to
+// visit only the bots near each explosion.  'nearby' is scratch space; a
+// caller that keeps it between ticks does not allocate.
+void applyBlasts(const Geometry::PointSet& explosions, const Geometry::SpatialGrid& bots,
+                 int* damage, std::vector<Geometry::SpatialGrid::Id>& nearby);
+
+} // namespace Server
+
+#endif // Blast_h__
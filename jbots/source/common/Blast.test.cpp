@@ -0,0 +1,77 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <vector>
+
+#include "../Shared/Blast.h"
+
+SUITE(BlastTestSuite) {
+
+TEST(BlastRings) {
+	CHECK_EQUAL(10, Server::blastDamage(0.0));
+	CHECK_EQUAL(10, Server::blastDamage(4.99 * 4.99));
+	CHECK_EQUAL(5, Server::blastDamage(5.0 * 5.0));
+	CHECK_EQUAL(5, Server::blastDamage(19.99 * 19.99));
+	CHECK_EQUAL(3, Server::blastDamage(20.0 * 20.0));
+	CHECK_EQUAL(3, Server::blastDamage(39.99 * 39.99));
+	CHECK_EQUAL(0, Server::blastDamage(40.0 * 40.0));
+	CHECK_EQUAL(0, Server::blastDamage(1e9));
+}
+
+TEST(ApplyBlasts) {
+	// two explosions at (100, 100) and (130, 100)
+	const double ex[] = { 100, 130 };
+	const double ey[] = { 100, 100 };
+	const double bx[] = { 100, 110, 125, 200, 150 };
+	const double by[] = { 103, 100, 100, 200, 100 };
+	const Geometry::PointSet explosions(ex, ey, 2);
+	const Geometry::PointSet bots(bx, by, 5);
+
+	int damage[5] = { 1, 0, 0, 0, 0 };
+	Server::applyBlasts(explosions, bots, damage);
+	CHECK_EQUAL(1 + 10 + 3, damage[0]); // 3 m and ~30 m away
+	CHECK_EQUAL(5 + 3, damage[1]);      // 10 m and 20 m
+	CHECK_EQUAL(3 + 5, damage[2]);      // 25 m, and exactly 5 m is outside the inner ring
+	CHECK_EQUAL(0, damage[3]);
+	CHECK_EQUAL(3, damage[4]);          // 50 m, and exactly 20 m
+
+	const unsigned char alive[5] = { 1, 0, 1, 1, 1 };
+	int masked[5] = { 0, 0, 0, 0, 0 };
+	Server::applyBlasts(explosions, bots, masked, alive);
+	CHECK_EQUAL(13, masked[0]);
+	CHECK_EQUAL(0, masked[1]);
+}
+
+TEST(ApplyBlastsThroughGrid) {
+	// the grid must give the same damage as the full pass
+	std::vector<double> bx, by, ex, ey;
+	unsigned long state = 99;
+	for (int i = 0; i < 400; ++i) {
+		state = (state * 1103515245ul + 12345ul) & 0x7ffffffful;
+		bx.push_back(state % 1000);
+		state = (state * 1103515245ul + 12345ul) & 0x7ffffffful;
+		by.push_back(state % 1000);
+	}
+	for (int i = 0; i < 50; ++i) {
+		ex.push_back(bx[i * 7] + i % 13);
+		ey.push_back(by[i * 7] - i % 11);
+	}
+	const Geometry::PointSet bots(bx.data(), by.data(), bx.size());
+	const Geometry::PointSet explosions(ex.data(), ey.data(), ex.size());
+
+	std::vector<int> full(bx.size(), 0), gridded(bx.size(), 0);
+	Server::applyBlasts(explosions, bots, full.data());
+
+	Geometry::SpatialGrid grid;
+	grid.updateAll(bots);
+	std::vector<Geometry::SpatialGrid::Id> nearby;
+	Server::applyBlasts(explosions, grid, gridded.data(), nearby);
+
+	int total = 0;
+	for (std::size_t i = 0; i < bx.size(); ++i) {
+		CHECK_EQUAL(full[i], gridded[i]);
+		total += full[i];
+	}
+	CHECK(total > 0);
+}
+
+} // suite
@@ -1,33 +1,59 @@
 #include "Bot.h"
 
+#include <cmath>
+
 namespace Server {
 
-Bot::Bot(const std::string& name)
-	: m_name(name)
-{
+const std::string& Bot::name() const {
+	static const std::string nobody;
+	return valid() ? m_arena->name(m_id) : nobody;
 }
 
-Bot::Bot(const std::string& name, const Geometry::Point& p, const Geometry::Angle& a) 
-	: m_name(name)
-{
-	setPosition(p);
-	setFacing(a);
-	setSpeed(0);
+double Bot::scan(const Geometry::Angle& direction, const Geometry::Angle& resolution) const {
+	return valid() ? m_arena->scan(m_id, direction, resolution) : 0.0;
 }
 
-double Bot::scan(const Geometry::Angle& direction, const Geometry::Angle& resolution) const {
-	// Bot must be able to query Arena
-	// TODO: implement
-	return 0.0;
+bool Bot::fire(const Geometry::Angle& direction, const double range) const {
+	return valid() ? m_arena->launch(m_id, direction, range) : false;
 }
 
-void Bot::fire(const Geometry::Angle& direction, const double range) const {
-	// Bot must be able to request that the Arena create a missile
-	// TODO: implement
+void Bot::drive(const Geometry::Angle& direction, const double speed) const {
+	if (valid())
+		m_arena->drive(m_id, direction, speed);
 }
 
-void Bot::drive(const Geometry::Angle& direction, const double speed) {
-	// TODO: implement
+namespace {
+
+Geometry::Angle degrees(const Vm::Word d) { return Geometry::Angle::d2r(d); }
+
+Vm::Word meters(const double m) {
+	const Vm::Word w = static_cast<Vm::Word>(m);
+	return w < 0 ? 0 : w > Arena::size - 1 ? static_cast<Vm::Word>(Arena::size) - 1 : w;
 }
 
+} // namespace
+
+Vm::Word BotHost::scan(const Vm::Word degree, const Vm::Word resolution) {
+	return static_cast<Vm::Word>(m_bot.scan(degrees(degree), degrees(resolution)));
+}
+
+Vm::Word BotHost::cannon(const Vm::Word degree, const Vm::Word range) {
+	return m_bot.fire(degrees(degree), range) ? 1 : 0;
+}
+
+void BotHost::drive(const Vm::Word degree, const Vm::Word speed) {
+	m_bot.drive(degrees(degree), speed < 0 ? 0 : speed > 100 ? 100 : speed);
+}
+
+Vm::Word BotHost::damage() {
+	return static_cast<Vm::Word>(Arena::deadly - m_bot.health());
+}
+
+Vm::Word BotHost::speed() {
+	return static_cast<Vm::Word>(std::floor(m_bot.speed() / Arena::fullSpeed * 100.0 + 0.5));
+}
+
+Vm::Word BotHost::locX() { return meters(m_bot.position().x()); }
+Vm::Word BotHost::locY() { return meters(m_bot.position().y()); }
+
 } // namespace Server
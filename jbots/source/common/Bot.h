@@ -2,66 +2,84 @@
 #define Bot_h__
 
 #include <string>
+#include <vector>
 
+#include "Arena.h"
+#include "Bytecode.h"
 #include "Geometry.h"
-
-struct Order;
+#include "Order.h"
 
 namespace Server {
 
-	class Bot : private Geometry::Entity {
-	protected:
-		std::string m_name;
-		double m_health;
+	// A handle onto one robot in an Arena, which owns all of its state.  As
+	// cheap to copy as an index; a default-constructed Bot is in no Arena,
+	// sees nothing and cannot fire.
+	class Bot {
+	private:
+		Arena* m_arena;
+		Arena::Id m_id;
 	public:
 		// Creators
-		Bot() {}
-		Bot(const Bot& other) {}
-		Bot(const std::string& name);
-		Bot(const std::string& name, const Geometry::Point& p, const Geometry::Angle& a);
+		Bot() : m_arena(0), m_id(Arena::none) {}
+		Bot(Arena& arena, const Arena::Id id) : m_arena(id != Arena::none ? &arena : 0), m_id(id) {}
 
 		// Accessors
-		const std::string& name() const { return m_name; }
-		bool alive() const { return health() > 0; }
-		const double health() const { return m_health; }
+		Arena::Id id() const { return m_id; }
+		bool valid() const { return m_arena != 0; }
+		const std::string& name() const;
+		bool alive() const { return valid() && m_arena->alive(m_id); }
+		double health() const { return valid() ? Arena::deadly - m_arena->damage(m_id) : 0.0; }
+		Geometry::Point position() const { return valid() ? m_arena->position(m_id) : Geometry::Point(); }
+		Geometry::Angle facing() const { return valid() ? m_arena->facing(m_id) : Geometry::Angle(); }
+		double speed() const { return valid() ? m_arena->speed(m_id) : 0.0; }
 
 		// Modifiers
+		// The CROBOTS intrinsics, answered by the Arena.  scan() returns the
+		// distance to the nearest bot in the cone, or 0; fire() returns false
+		// while the cannon is reloading; drive() takes a speed in percent of
+		// Arena::fullSpeed, and takes effect at the next Arena::tick().
 		double scan(const Geometry::Angle& direction, const Geometry::Angle& resolution) const;
-		void fire(const Geometry::Angle& direction, const double range) const;
-		void drive(const Geometry::Angle& direction, const double speed);
+		bool fire(const Geometry::Angle& direction, const double range) const;
+		void drive(const Geometry::Angle& direction, const double speed) const;
 	};
 	typedef std::vector<Bot> Bots;
 
+	// Answers a robot CPU's intrinsics with a Bot, in CROBOTS units: whole
+	// degrees, whole meters from 0 to 999, and percent.
+	class BotHost : public Vm::Host {
+	private:
+		Bot m_bot;
+	public:
+		// Creators
+		explicit BotHost(const Bot& bot) : m_bot(bot) {}
+
+		// Accessors
+		const Bot& bot() const { return m_bot; }
+
+		// Vm::Host
+		Vm::Word scan(const Vm::Word degree, const Vm::Word resolution);
+		Vm::Word cannon(const Vm::Word degree, const Vm::Word range);
+		void drive(const Vm::Word degree, const Vm::Word speed);
+		Vm::Word damage();
+		Vm::Word speed();
+		Vm::Word locX();
+		Vm::Word locY();
+	};
+
 }
 
 namespace Client {
 
 class Bot {
 public:
-	Bot();
-	~Bot();
+	virtual ~Bot() {}
 	
-	// Called by Match to determine the next order
-	Order order();
+	// Called by Match once a tick, to queue this tick's orders.  They are
+	// applied after every bot has been asked, so the results of fires and
+	// scans can be read back by ticket on the next call.
+	virtual void order(Server::Orders& orders, const Server::OrderBuffer& last) = 0;
 };
 
 } // namespace Client
 
-////////////////////////////////////////////////////////////
-
-#if 0
-struct Order {
-	enum OrderType { nothing, accelerate, turn, fire, scan } type;
-
-	// 
-	double parameter1, parameter2;
-	double const& newVelocity = parameter1;
-	double const& newFacing = parameter1;
-	double const& fireAngle = parameter1;
-	double const& fireRange = parameter2;
-	double const& scanRange = parameter1;
-	double const& scanWidth = parameter2;
-};
-#endif // 0
-
 #endif // Bot_h__
@@ -0,0 +1,116 @@
+// Bytecode.cpp
+// The CROBOTS intrinsic function library.
+
+#include "Bytecode.h"
+
+#include "Trig.h"
+
+namespace Vm {
+
+void entries(const Image& image, std::vector<bool>& entered) {
+	const int end = static_cast<int>(image.code.size());
+	entered.assign(end + 1, false);
+	for (std::size_t f = 0; f < image.links.size(); ++f)
+		if (image.links[f].entry >= 0 && image.links[f].entry < end)
+			entered[image.links[f].entry] = true;
+	for (int pc = 0; pc < end; ++pc)
+		if (image.code[pc].op == Instruction::branch && image.code[pc].operand >= 0 && image.code[pc].operand <= end)
+			entered[image.code[pc].operand] = true;
+}
+
+Word binary(const int op, const Word x, const Word y) {
+	switch (op) {
+	case Instruction::assign: return binary<Instruction::assign>(x, y);
+	case Instruction::add: return binary<Instruction::add>(x, y);
+	case Instruction::sub: return binary<Instruction::sub>(x, y);
+	case Instruction::mul: return binary<Instruction::mul>(x, y);
+	case Instruction::div: return binary<Instruction::div>(x, y);
+	case Instruction::mod: return binary<Instruction::mod>(x, y);
+	case Instruction::shl: return binary<Instruction::shl>(x, y);
+	case Instruction::shr: return binary<Instruction::shr>(x, y);
+	case Instruction::band: return binary<Instruction::band>(x, y);
+	case Instruction::bor: return binary<Instruction::bor>(x, y);
+	case Instruction::bxor: return binary<Instruction::bxor>(x, y);
+	case Instruction::land: return binary<Instruction::land>(x, y);
+	case Instruction::lor: return binary<Instruction::lor>(x, y);
+	case Instruction::lt: return binary<Instruction::lt>(x, y);
+	case Instruction::le: return binary<Instruction::le>(x, y);
+	case Instruction::eq: return binary<Instruction::eq>(x, y);
+	case Instruction::ne: return binary<Instruction::ne>(x, y);
+	case Instruction::ge: return binary<Instruction::ge>(x, y);
+	case Instruction::gt: return binary<Instruction::gt>(x, y);
+	default: return 0;
+	}
+}
+
+namespace {
+
+Word scan(Host* host, std::uint32_t&, const Word* args) {
+	return host ? host->scan(Geometry::wrapDegrees(args[0]), args[1]) : 0;
+}
+
+Word cannon(Host* host, std::uint32_t&, const Word* args) {
+	return host ? host->cannon(Geometry::wrapDegrees(args[0]), args[1]) : 0;
+}
+
+Word drive(Host* host, std::uint32_t&, const Word* args) {
+	if (host)
+		host->drive(Geometry::wrapDegrees(args[0]), args[1]);
+	return 0;
+}
+
+Word damage(Host* host, std::uint32_t&, const Word*) { return host ? host->damage() : 0; }
+Word speed(Host* host, std::uint32_t&, const Word*) { return host ? host->speed() : 0; }
+Word locX(Host* host, std::uint32_t&, const Word*) { return host ? host->locX() : 0; }
+Word locY(Host* host, std::uint32_t&, const Word*) { return host ? host->locY() : 0; }
+
+// 0 to limit - 1, from the usual 15-bit linear congruential generator.
+Word rand(Host*, std::uint32_t& random, const Word* args) {
+	random = random * 1103515245u + 12345u;
+	const Word r = static_cast<Word>((random >> 16) & 0x7fff);
+	return args[0] > 0 ? r % args[0] : 0;
+}
+
+// Truncated, of the magnitude.
+Word sqrt(Host*, std::uint32_t&, const Word* args) {
+	const std::uint32_t n = args[0] < 0 ? 0u - static_cast<std::uint32_t>(args[0]) : args[0];
+	std::uint32_t root = 0;
+	for (std::uint32_t bit = 1u << 15; bit; bit >>= 1) {
+		const std::uint32_t guess = root | bit;
+		if (static_cast<std::uint64_t>(guess) * guess <= n)
+			root = guess;
+	}
+	return static_cast<Word>(root);
+}
+
+Word sin(Host*, std::uint32_t&, const Word* args) { return Geometry::isin(args[0]); }
+Word cos(Host*, std::uint32_t&, const Word* args) { return Geometry::icos(args[0]); }
+Word tan(Host*, std::uint32_t&, const Word* args) { return Geometry::itan(args[0]); }
+Word atan(Host*, std::uint32_t&, const Word* args) { return Geometry::iatan(args[0]); }
+
+} // namespace
+
+const Intrinsic intrinsics[Intrinsic::count] = {
+	{ "scan", 2, scan },
+	{ "cannon", 2, cannon },
+	{ "drive", 2, drive },
+	{ "damage", 0, damage },
+	{ "speed", 0, speed },
+	{ "loc_x", 0, locX },
+	{ "loc_y", 0, locY },
+	{ "rand", 1, rand },
+	{ "sqrt", 1, sqrt },
+	{ "sin", 1, sin },
+	{ "cos", 1, cos },
+	{ "tan", 1, tan },
+	{ "atan", 1, atan },
+};
+
+const Intrinsic* Intrinsic::find(const std::string& name) {
+	for (int i = 0; i < count; ++i)
+		if (name == intrinsics[i].name)
+			return &intrinsics[i];
+	return 0;
+}
+
+} // namespace Vm
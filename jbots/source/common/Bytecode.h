@@ -0,0 +1,153 @@
+// Bytecode.h
+// The CROBOTS robot CPU's instruction set, program image and intrinsic
+// library, shared by every tier that runs robot programs.
+
+#ifndef Bytecode_h__
+#define Bytecode_h__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Vm {
+
+// The robot CPU is a 32-bit integer machine; arithmetic wraps.
+typedef std::int32_t Word;
+
+const int codeSpace = 1000;    // instructions
+const int stackSize = 500;     // words, data and call/return together
+const int callWords = 3;       // per call: frame mark, return address, local mark
+const int maxVariables = 64;   // external, or local to one function
+const int maxFunctions = 64;
+
+// Flags a FETCH or STORE offset as external, from the bottom of the stack,
+// rather than local, from the current local mark.
+const Word external = 0x8000;
+
+////////////////////////////////////////////////////////////
+//
+// struct Instruction
+//
+// The ten CROBOTS instructions, all the same size.  BINOP and STORE carry
+// an operator; STORE's is 'assign' for a plain '='.  An FCALL operand is an
+// index into the link list, or -1 - Intrinsic::Id for an intrinsic.  BRANCH
+// pops the top of the stack and jumps to its operand if that was zero.
+
+struct Instruction {
+	enum Op { nop, fetch, store, constant, binop, fcall, retsub, branch, chop, frame };
+	enum BinOp {
+		assign, add, sub, mul, div, mod, shl, shr, band, bor, bxor,
+		land, lor, lt, le, eq, ne, ge, gt, binops
+	};
+
+	std::uint8_t op;
+	std::uint8_t opcode;
+	Word operand;
+};
+
+// One function in the link list.  Its first 'params' locals are its
+// arguments.
+struct Link {
+	std::string name;
+	int entry;
+	int params;
+	int locals;  // params included
+};
+
+// A compiled robot program.
+struct Image {
+	std::vector<Instruction> code;
+	std::vector<Link> links;
+	int externals;
+	int main;    // index of main() in links, or -1
+};
+
+// Sets 'entered' to one flag per instruction, and one for the end of the
+// code, marking those reached other than from the instruction before:
+// function entries and branch targets.
+void entries(const Image& image, std::vector<bool>& entered);
+
+////////////////////////////////////////////////////////////
+//
+// Arithmetic
+//
+// What BINOP and STORE compute.  Overflow wraps, division or modulo by zero
+// gives zero, shifts use the low five bits of the count, and comparisons
+// and logical operators give 1 or 0.  Every tier uses these, so that a
+// robot behaves the same whichever one runs it.
+
+template <int Op>
+inline Word binary(const Word x, const Word y) {
+	typedef std::uint32_t U;
+	switch (Op) {
+	case Instruction::assign: return y;
+	case Instruction::add: return static_cast<Word>(static_cast<U>(x) + static_cast<U>(y));
+	case Instruction::sub: return static_cast<Word>(static_cast<U>(x) - static_cast<U>(y));
+	case Instruction::mul: return static_cast<Word>(static_cast<U>(x) * static_cast<U>(y));
+	case Instruction::div: return y == 0 ? 0 : y == -1 ? static_cast<Word>(0 - static_cast<U>(x)) : x / y;
+	case Instruction::mod: return y == 0 || y == -1 ? 0 : x % y;
+	case Instruction::shl: return static_cast<Word>(static_cast<U>(x) << (y & 31));
+	case Instruction::shr: return x >> (y & 31);
+	case Instruction::band: return x & y;
+	case Instruction::bor: return x | y;
+	case Instruction::bxor: return x ^ y;
+	case Instruction::land: return x != 0 && y != 0;
+	case Instruction::lor: return x != 0 || y != 0;
+	case Instruction::lt: return x < y;
+	case Instruction::le: return x <= y;
+	case Instruction::eq: return x == y;
+	case Instruction::ne: return x != y;
+	case Instruction::ge: return x >= y;
+	case Instruction::gt: return x > y;
+	default: return 0;
+	}
+}
+
+// The same, for an operator only known at run time.
+Word binary(const int op, const Word x, const Word y);
+
+////////////////////////////////////////////////////////////
+//
+// class Host
+//
+// What the intrinsics that touch the robot act on.  Degrees arrive already
+// forced into 0-359.
+
+class Host {
+public:
+	virtual ~Host() {}
+	virtual Word scan(const Word degree, const Word resolution) = 0;
+	virtual Word cannon(const Word degree, const Word range) = 0;
+	virtual void drive(const Word degree, const Word speed) = 0;
+	virtual Word damage() = 0;
+	virtual Word speed() = 0;
+	virtual Word locX() = 0;
+	virtual Word locY() = 0;
+};
+
+////////////////////////////////////////////////////////////
+//
+// struct Intrinsic
+//
+// The intrinsic function library.  Each is called through a fixed
+// trampoline taking the robot's Host (which may be 0, for a robot not in
+// an arena), its random number state and its arguments in order.
+
+struct Intrinsic {
+	enum Id { scan, cannon, drive, damage, speed, locX, locY, rand, sqrt, sin, cos, tan, atan, count };
+
+	typedef Word (*Trampoline)(Host* host, std::uint32_t& random, const Word* args);
+
+	const char* name;
+	int arity;
+	Trampoline call;
+
+	// Id's entry, or 0 for an unknown name.
+	static const Intrinsic* find(const std::string& name);
+};
+
+extern const Intrinsic intrinsics[Intrinsic::count];
+
+} // namespace Vm
+
+#endif // Bytecode_h__
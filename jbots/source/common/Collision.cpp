@@ -0,0 +1,263 @@
+// Collision.cpp
+// Robot-robot and robot-wall collision detection.
+
+#include "Collision.h"
+
+#include <cmath> // sqrt()
+
+namespace Geometry {
+
+////////////////////////////////////////////////////////////
+// class SweepAndPrune
+
+void SweepAndPrune::resize(const std::size_t count) {
+	if (count == m_order.size())
+		return;
+	if (count < m_order.size()) {
+		// drop the departing ids, keeping the survivors' relative order
+		std::size_t kept = 0;
+		for (std::size_t i = 0; i < m_order.size(); ++i)
+			if (m_order[i] < count)
+				m_order[kept++] = m_order[i];
+		m_order.resize(kept);
+	} else {
+		for (std::size_t id = m_order.size(); id < count; ++id)
+			m_order.push_back(id);
+	}
+	m_left.resize(count);
+}
+
+void SweepAndPrune::sort() {
+	// Insertion sort: linear when the order from the last tick still holds.
+	m_swaps = 0;
+	for (std::size_t i = 1; i < m_order.size(); ++i) {
+		const std::size_t id = m_order[i];
+		const double key = m_left[id];
+		std::size_t j = i;
+		while (j > 0 && m_left[m_order[j - 1]] > key) {
+			m_order[j] = m_order[j - 1];
+			--j;
+		}
+		m_swaps += i - j;
+		m_order[j] = id;
+	}
+}
+
+void SweepAndPrune::place(const PointSet& centers, const double* radii, const double radius) {
+	resize(centers.count);
+	for (std::size_t id = 0; id < centers.count; ++id)
+		m_left[id] = centers.x[id] - (radii ? radii[id] : radius);
+	sort();
+	m_sorted.resize(m_order.size());
+	for (std::size_t i = 0; i < m_order.size(); ++i) {
+		const std::size_t id = m_order[i];
+		Box& box = m_sorted[i];
+		box.x = centers.x[id];
+		box.y = centers.y[id];
+		box.radius = radii ? radii[id] : radius;
+		box.left = box.x - box.radius;
+		box.right = box.x + box.radius;
+		box.bottom = box.y - box.radius;
+		box.top = box.y + box.radius;
+		box.id = id;
+	}
+}
+
+void SweepAndPrune::update(const PointSet& centers, const double radius) {
+	place(centers, 0, radius);
+}
+
+void SweepAndPrune::update(const PointSet& centers, const double* radii) {
+	place(centers, radii, 0.0);
+}
+
+void SweepAndPrune::clear() {
+	m_order.clear();
+	m_left.clear();
+	m_sorted.clear();
+	m_swaps = 0;
+}
+
+void SweepAndPrune::findContacts(std::vector<Contact>& out) const {
+	const std::size_t n = m_sorted.size();
+	for (std::size_t i = 0; i < n; ++i) {
+		const Box& a = m_sorted[i];
+		for (std::size_t j = i + 1; j < n && m_sorted[j].left <= a.right; ++j) {
+			const Box& b = m_sorted[j];
+			if (b.bottom > a.top || b.top < a.bottom)
+				continue;
+			// narrow phase: exact circle overlap
+			const double dx = b.x - a.x;
+			const double dy = b.y - a.y;
+			const double reach = a.radius + b.radius;
+			const double d2 = dx * dx + dy * dy;
+			if (d2 < reach * reach) {
+				Contact contact;
+				contact.first = a.id < b.id ? a.id : b.id;
+				contact.second = a.id < b.id ? b.id : a.id;
+				contact.distanceSquared = d2;
+				out.push_back(contact);
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////
+
+void findWallContacts(const PointSet& centers, const double radius,
+                      const double width, const double height,
+                      std::vector<WallContact>& out)
+{
+	for (std::size_t id = 0; id < centers.count; ++id) {
+		unsigned walls = 0;
+		if (centers.x[id] - radius < 0.0)    walls |= WallContact::left;
+		if (centers.x[id] + radius > width)  walls |= WallContact::right;
+		if (centers.y[id] - radius < 0.0)    walls |= WallContact::bottom;
+		if (centers.y[id] + radius > height) walls |= WallContact::top;
+		if (walls) {
+			WallContact contact;
+			contact.id = id;
+			contact.walls = walls;
+			out.push_back(contact);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////
+// Continuous collision
+
+namespace {
+
+inline double dot(const double ax, const double ay, const double bx, const double by) {
+	return ax * bx + ay * by;
+}
+
+inline double cross(const double ax, const double ay, const double bx, const double by) {
+	return ax * by - ay * bx;
+}
+
+// Earliest t in [0, 1] at which |d + v t| = reach, for a separation d that
+// changes by v over the tick.
+bool firstContact(const double dx, const double dy, const double vx, const double vy,
+                  const double reach, double& t)
+{
+	const double c = dot(dx, dy, dx, dy) - reach * reach;
+	if (c <= 0.0) {
+		t = 0.0;
+		return true;
+	}
+	const double a = dot(vx, vy, vx, vy);
+	const double b = dot(dx, dy, vx, vy);
+	if (a == 0.0 || b >= 0.0)
+		return false; // not moving, or moving apart
+	const double discriminant = b * b - a * c;
+	if (discriminant < 0.0)
+		return false;
+	const double root = (-b - sqrt(discriminant)) / a;
+	if (root > 1.0)
+		return false;
+	t = root;
+	return true;
+}
+
+// Earliest t in [0, 1] at which 'position + motion * t' reaches 'limit' while
+// moving toward it; 'below' says the allowed side is below the limit.
+bool reachLimit(const double position, const double motion, const double limit,
+                const bool below, double& t)
+{
+	const double gap = below ? limit - position : position - limit;
+	if (gap <= 0.0) {
+		t = 0.0;
+		return true;
+	}
+	const double closing = below ? motion : -motion;
+	if (closing <= 0.0 || closing < gap)
+		return false;
+	t = gap / closing;
+	return true;
+}
+
+} // namespace
+
+bool sweepPointCircle(const Point& from, const Point& motion,
+                      const Point& center, const double radius, double& t)
+{
+	return firstContact(from.x() - center.x(), from.y() - center.y(),
+	                    motion.x(), motion.y(), radius, t);
+}
+
+bool sweepCircles(const Point& a, const Point& motionA, const double radiusA,
+                  const Point& b, const Point& motionB, const double radiusB,
+                  double& t)
+{
+	// work in a's frame of reference, where a stands still
+	return firstContact(b.x() - a.x(), b.y() - a.y(),
+	                    motionB.x() - motionA.x(), motionB.y() - motionA.y(),
+	                    radiusA + radiusB, t);
+}
+
+bool intersectSegments(const Point& a0, const Point& a1,
+                       const Point& b0, const Point& b1, double& t)
+{
+	const double rx = a1.x() - a0.x(), ry = a1.y() - a0.y();
+	const double sx = b1.x() - b0.x(), sy = b1.y() - b0.y();
+	const double qx = b0.x() - a0.x(), qy = b0.y() - a0.y();
+	const double denominator = cross(rx, ry, sx, sy);
+	if (denominator == 0.0) {
+		if (cross(qx, qy, rx, ry) != 0.0)
+			return false; // parallel
+		// collinear: project b's ends onto a and take the earliest overlap
+		const double rr = dot(rx, ry, rx, ry);
+		if (rr == 0.0) {
+			// a is a point; it must lie on b
+			const double ss = dot(sx, sy, sx, sy);
+			const double u = ss == 0.0 ? 0.0 : dot(-qx, -qy, sx, sy) / ss;
+			if ((ss == 0.0 && (qx != 0.0 || qy != 0.0)) || u < 0.0 || u > 1.0)
+				return false;
+			t = 0.0;
+			return true;
+		}
+		double t0 = dot(qx, qy, rx, ry) / rr;
+		double t1 = t0 + dot(sx, sy, rx, ry) / rr;
+		if (t0 > t1) { const double swap = t0; t0 = t1; t1 = swap; }
+		if (t1 < 0.0 || t0 > 1.0)
+			return false;
+		t = t0 < 0.0 ? 0.0 : t0;
+		return true;
+	}
+	const double u = cross(qx, qy, rx, ry) / denominator;
+	const double v = cross(qx, qy, sx, sy) / denominator;
+	if (v < 0.0 || v > 1.0 || u < 0.0 || u > 1.0)
+		return false;
+	t = v;
+	return true;
+}
+
+bool sweepWalls(const Point& from, const Point& motion, const double radius,
+                const double width, const double height, double& t, unsigned& walls)
+{
+	struct Limit { double position, motion, limit; bool below; unsigned wall; };
+	const Limit limits[4] = {
+		{ from.x(), motion.x(), radius,          false, WallContact::left },
+		{ from.x(), motion.x(), width - radius,  true,  WallContact::right },
+		{ from.y(), motion.y(), radius,          false, WallContact::bottom },
+		{ from.y(), motion.y(), height - radius, true,  WallContact::top },
+	};
+	bool hit = false;
+	walls = 0;
+	for (int i = 0; i < 4; ++i) {
+		double when;
+		if (!reachLimit(limits[i].position, limits[i].motion, limits[i].limit, limits[i].below, when))
+			continue;
+		if (!hit || when < t) {
+			t = when;
+			walls = limits[i].wall;
+			hit = true;
+		} else if (when == t) {
+			walls |= limits[i].wall;
+		}
+	}
+	return hit;
+}
+
+} // namespace Geometry
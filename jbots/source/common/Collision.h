@@ -0,0 +1,122 @@
+// Collision.h
+// Robot-robot and robot-wall collision detection.  A sweep-and-prune broad
+// phase over bounding circles feeds an exact circle test, so detection stays
+// close to linear in the number of robots.
+
+#ifndef Collision_h__
+#define Collision_h__
+
+#include <cstddef>
+#include <vector>
+
+#include "Geometry.h"
+#include "Proximity.h"
+
+namespace Geometry {
+
+////////////////////////////////////////////////////////////
+//
+// struct Contact, struct WallContact
+//
+// A pair of overlapping bodies, first < second, and a body touching one or
+// more of the arena's walls.
+
+struct Contact {
+	std::size_t first, second;
+	double distanceSquared;
+};
+
+struct WallContact {
+	enum Wall { left = 1, right = 2, bottom = 4, top = 8 };
+	std::size_t id;
+	unsigned walls; // Wall bits
+};
+
+////////////////////////////////////////////////////////////
+//
+// class SweepAndPrune
+//
+// Keeps bodies sorted by the left edge of their bounding boxes.  Bodies move
+// only a little per tick, so update() restores the order with an insertion
+// sort that does work proportional to the number of bodies that actually
+// passed one another.  findContacts() then sweeps the sorted list: a body is
+// only compared with the bodies whose x extents overlap its own, then the y
+// extents are checked, and finally the exact distance between the circles.
+//
+// Body ids are indices into the PointSet passed to update().
+
+class SweepAndPrune {
+private:
+	struct Box {
+		double left, right, bottom, top;
+		double x, y, radius;
+		std::size_t id;
+	};
+
+	std::vector<std::size_t> m_order; // body ids by left edge
+	std::vector<double> m_left;       // left edge, by body id
+	std::vector<Box> m_sorted;        // boxes in m_order, rebuilt per update
+	std::size_t m_swaps;
+
+	void resize(const std::size_t count);
+	void sort();
+	void place(const PointSet& centers, const double* radii, const double radius);
+
+public:
+	// Creators
+	SweepAndPrune() : m_swaps(0) {}
+
+	// Accessors
+	std::size_t size() const { return m_order.size(); }
+	std::size_t swaps() const { return m_swaps; } // reordering done by the last update()
+
+	// Appends every pair of bodies whose circles overlap.
+	void findContacts(std::vector<Contact>& out) const;
+
+	// Modifiers
+	// Takes new positions for every body.  Bodies beyond the previous count
+	// are added, and bodies beyond the new count dropped.
+	void update(const PointSet& centers, const double radius);
+	void update(const PointSet& centers, const double* radii);
+	void clear();
+};
+
+// Appends every body whose circle reaches outside [0, width] x [0, height].
+void findWallContacts(const PointSet& centers, const double radius,
+                      const double width, const double height,
+                      std::vector<WallContact>& out);
+
+////////////////////////////////////////////////////////////
+//
+// Continuous collision
+//
+// Exact tests for bodies that move in a straight line during a tick, so a
+// fast missile or robot cannot pass through a target or a wall between two
+// positions.  Motion is given as a start point and a displacement for the
+// whole tick; on a hit, 't' receives the fraction of the tick, 0 to 1, at
+// which first contact happens.  Bodies that already overlap at the start hit
+// at t = 0.
+
+// A point moving from 'from' by 'motion' against a stationary circle.
+bool sweepPointCircle(const Point& from, const Point& motion,
+                      const Point& center, const double radius, double& t);
+
+// Two circles, each moving by its own displacement, against each other.
+bool sweepCircles(const Point& a, const Point& motionA, const double radiusA,
+                  const Point& b, const Point& motionB, const double radiusB,
+                  double& t);
+
+// Segment a0-a1 against segment b0-b1; 't' is the position along a0-a1.
+// Collinear overlapping segments report their first point of contact.
+bool intersectSegments(const Point& a0, const Point& a1,
+                       const Point& b0, const Point& b1, double& t);
+
+// A circle moving from 'from' by 'motion' against the walls of the arena
+// [0, width] x [0, height].  'walls' receives the WallContact bits of the
+// wall or walls reached first.
+bool sweepWalls(const Point& from, const Point& motion, const double radius,
+                const double width, const double height, double& t, unsigned& walls);
+
+} // namespace Geometry
+
+#endif // Collision_h__
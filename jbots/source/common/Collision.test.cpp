@@ -0,0 +1,177 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <vector>
+
+#include "../Shared/Collision.h"
+
+namespace {
+
+bool hasContact(const std::vector<Geometry::Contact>& contacts, std::size_t a, std::size_t b) {
+	for (std::size_t i = 0; i < contacts.size(); ++i)
+		if (contacts[i].first == a && contacts[i].second == b)
+			return true;
+	return false;
+}
+
+}
+
+SUITE(CollisionTestSuite) {
+
+TEST(OverlappingCircles) {
+	const double x[] = { 100, 105, 300, 104 };
+	const double y[] = { 100, 103, 100, 111 };
+	Geometry::SweepAndPrune sap;
+	sap.update(Geometry::PointSet(x, y, 4), 5.0);
+	std::vector<Geometry::Contact> contacts;
+	sap.findContacts(contacts);
+	CHECK_EQUAL(2u, contacts.size());
+	CHECK(hasContact(contacts, 0, 1));
+	CHECK(hasContact(contacts, 1, 3));
+	CHECK_CLOSE(34.0, contacts[0].distanceSquared, 0.0001);
+}
+
+TEST(MatchesBruteForce) {
+	const std::size_t n = 400;
+	std::vector<double> x(n), y(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		x[i] = static_cast<double>((i * 7919) % 1000);
+		y[i] = static_cast<double>((i * 104729) % 1000);
+	}
+	Geometry::SweepAndPrune sap;
+	for (int tick = 0; tick < 5; ++tick) {
+		for (std::size_t i = 0; i < n; ++i)
+			x[i] += (i % 3) - 1.0;
+		sap.update(Geometry::PointSet(&x[0], &y[0], n), 12.0);
+		std::vector<Geometry::Contact> contacts;
+		sap.findContacts(contacts);
+
+		std::size_t expected = 0;
+		for (std::size_t a = 0; a < n; ++a) {
+			for (std::size_t b = a + 1; b < n; ++b) {
+				const double dx = x[a] - x[b], dy = y[a] - y[b];
+				if (dx * dx + dy * dy < 24.0 * 24.0) {
+					++expected;
+					CHECK(hasContact(contacts, a, b));
+				}
+			}
+		}
+		CHECK_EQUAL(expected, contacts.size());
+	}
+}
+
+TEST(IncrementalSortIsCheap) {
+	double x[] = { 10, 20, 30, 40 };
+	double y[] = { 0, 0, 0, 0 };
+	Geometry::SweepAndPrune sap;
+	sap.update(Geometry::PointSet(x, y, 4), 1.0);
+	x[0] = 25; // passes one neighbour
+	sap.update(Geometry::PointSet(x, y, 4), 1.0);
+	CHECK_EQUAL(1u, sap.swaps());
+	sap.update(Geometry::PointSet(x, y, 4), 1.0);
+	CHECK_EQUAL(0u, sap.swaps());
+}
+
+TEST(BodiesComeAndGo) {
+	const double x[] = { 0, 1, 2 };
+	const double y[] = { 0, 0, 0 };
+	const double radii[] = { 0.6, 0.6, 0.1 };
+	Geometry::SweepAndPrune sap;
+	sap.update(Geometry::PointSet(x, y, 3), radii);
+	std::vector<Geometry::Contact> contacts;
+	sap.findContacts(contacts);
+	CHECK_EQUAL(1u, contacts.size());
+
+	sap.update(Geometry::PointSet(x, y, 1), 5.0);
+	CHECK_EQUAL(1u, sap.size());
+	contacts.clear();
+	sap.findContacts(contacts);
+	CHECK(contacts.empty());
+}
+
+TEST(Walls) {
+	const double x[] = { 500, 1, 998, 500 };
+	const double y[] = { 500, 1, 500, 999 };
+	std::vector<Geometry::WallContact> walls;
+	Geometry::findWallContacts(Geometry::PointSet(x, y, 4), 2.0, 1000, 1000, walls);
+	CHECK_EQUAL(2u, walls.size());
+	CHECK_EQUAL(1u, walls[0].id);
+	CHECK_EQUAL(unsigned(Geometry::WallContact::left | Geometry::WallContact::bottom), walls[0].walls);
+	CHECK_EQUAL(3u, walls[1].id);
+	CHECK_EQUAL(unsigned(Geometry::WallContact::top), walls[1].walls);
+}
+
+////////////////////////////////////////
+
+TEST(SweepPointCircle) {
+	double t = -1;
+	// a missile covering 100m in a tick passes straight through a robot
+	CHECK(Geometry::sweepPointCircle(Geometry::Point(0, 0), Geometry::Point(100, 0),
+	                                 Geometry::Point(50, 0), 5, t));
+	CHECK_CLOSE(0.45, t, 0.000001);
+	CHECK(!Geometry::sweepPointCircle(Geometry::Point(0, 0), Geometry::Point(100, 0),
+	                                  Geometry::Point(50, 10), 5, t));
+	CHECK(!Geometry::sweepPointCircle(Geometry::Point(0, 0), Geometry::Point(40, 0),
+	                                  Geometry::Point(50, 0), 5, t));
+	CHECK(!Geometry::sweepPointCircle(Geometry::Point(60, 0), Geometry::Point(100, 0),
+	                                  Geometry::Point(50, 0), 5, t));
+	CHECK(Geometry::sweepPointCircle(Geometry::Point(52, 0), Geometry::Point(100, 0),
+	                                 Geometry::Point(50, 0), 5, t));
+	CHECK_EQUAL(0.0, t);
+}
+
+TEST(SweepCircles) {
+	double t = -1;
+	// head on: gap of 80 closes at 100 per tick
+	CHECK(Geometry::sweepCircles(Geometry::Point(0, 0), Geometry::Point(50, 0), 10,
+	                             Geometry::Point(100, 0), Geometry::Point(-50, 0), 10, t));
+	CHECK_CLOSE(0.8, t, 0.000001);
+	// same velocity never meets
+	CHECK(!Geometry::sweepCircles(Geometry::Point(0, 0), Geometry::Point(50, 0), 10,
+	                              Geometry::Point(100, 0), Geometry::Point(50, 0), 10, t));
+	// passing side by side
+	CHECK(!Geometry::sweepCircles(Geometry::Point(0, 0), Geometry::Point(100, 0), 10,
+	                              Geometry::Point(100, 30), Geometry::Point(-100, 0), 10, t));
+}
+
+TEST(IntersectSegments) {
+	double t = -1;
+	CHECK(Geometry::intersectSegments(Geometry::Point(0, 0), Geometry::Point(10, 0),
+	                                  Geometry::Point(4, -5), Geometry::Point(4, 5), t));
+	CHECK_CLOSE(0.4, t, 0.000001);
+	CHECK(!Geometry::intersectSegments(Geometry::Point(0, 0), Geometry::Point(10, 0),
+	                                   Geometry::Point(4, 1), Geometry::Point(4, 5), t));
+	CHECK(!Geometry::intersectSegments(Geometry::Point(0, 0), Geometry::Point(10, 0),
+	                                   Geometry::Point(0, 1), Geometry::Point(10, 1), t));
+	// collinear overlap reports first contact
+	CHECK(Geometry::intersectSegments(Geometry::Point(0, 0), Geometry::Point(10, 0),
+	                                  Geometry::Point(12, 0), Geometry::Point(6, 0), t));
+	CHECK_CLOSE(0.6, t, 0.000001);
+}
+
+TEST(SweepWalls) {
+	double t = -1;
+	unsigned walls = 0;
+	CHECK(Geometry::sweepWalls(Geometry::Point(980, 500), Geometry::Point(40, 0), 10,
+	                           1000, 1000, t, walls));
+	CHECK_CLOSE(0.25, t, 0.000001);
+	CHECK_EQUAL(unsigned(Geometry::WallContact::right), walls);
+
+	CHECK(!Geometry::sweepWalls(Geometry::Point(500, 500), Geometry::Point(40, 40), 10,
+	                            1000, 1000, t, walls));
+
+	// into the corner, reaching both walls at once
+	CHECK(Geometry::sweepWalls(Geometry::Point(20, 20), Geometry::Point(-20, -20), 10,
+	                           1000, 1000, t, walls));
+	CHECK_CLOSE(0.5, t, 0.000001);
+	CHECK_EQUAL(unsigned(Geometry::WallContact::left | Geometry::WallContact::bottom), walls);
+}
+
+TEST(EntitySweep) {
+	Geometry::Entity missile(Geometry::Point(0, 0), Geometry::Angle(0), 100);
+	double t = -1;
+	CHECK(Geometry::sweepPointCircle(missile.position(), missile.velocity(),
+	                                 Geometry::Point(50, 0), 5, t));
+	CHECK_CLOSE(0.45, t, 0.0001);
+}
+
+} // suite
@@ -0,0 +1,675 @@
+// Compiler.cpp
+// Compiles the CROBOTS C subset into an Image for the robot CPU.
+
+#include "Compiler.h"
+
+#include <cstring> // memcmp(), memcpy()
+#include <vector>
+
+namespace Vm {
+
+namespace {
+
+const int significant = 7; // characters of an identifier
+const int maxNesting = 16; // of ifs, and of whiles
+const int maxDepth = 150;  // of statements, expressions and unary operators, as yacc's stack
+
+// Tokens other than single characters, which stand for themselves.
+enum Token {
+	End = 256, Number, Identifier,
+	Int, Long, Auto, Register, If, Else, While, Return, Break,
+	Shl, Shr, Le, Ge, Eq, Ne, And, Or, Inc, Dec,
+	AddAssign, SubAssign, MulAssign, DivAssign, ModAssign,
+	ShlAssign, ShrAssign, AndAssign, XorAssign, OrAssign
+};
+
+// An identifier, cut to its significant characters.
+struct Name {
+	char text[significant];
+	unsigned char length;
+
+	bool operator==(const Name& other) const {
+		return length == other.length && std::memcmp(text, other.text, length) == 0;
+	}
+};
+
+struct Keyword {
+	const char* text;
+	int token;
+};
+
+const Keyword keywords[] = {
+	{ "int", Int }, { "long", Long }, { "auto", Auto }, { "register", Register },
+	{ "if", If }, { "else", Else }, { "while", While }, { "return", Return }, { "break", Break },
+};
+
+// Binary operators, loosest first; the level is the index into this table.
+struct Level {
+	int tokens[4];
+	int opcodes[4];
+};
+
+const Level levels[] = {
+	{ { Or }, { Instruction::lor } },
+	{ { And }, { Instruction::land } },
+	{ { '|' }, { Instruction::bor } },
+	{ { '^' }, { Instruction::bxor } },
+	{ { '&' }, { Instruction::band } },
+	{ { Eq, Ne }, { Instruction::eq, Instruction::ne } },
+	{ { '<', Le, '>', Ge }, { Instruction::lt, Instruction::le, Instruction::gt, Instruction::ge } },
+	{ { Shl, Shr }, { Instruction::shl, Instruction::shr } },
+	{ { '+', '-' }, { Instruction::add, Instruction::sub } },
+	{ { '*', '/', '%' }, { Instruction::mul, Instruction::div, Instruction::mod } },
+};
+const int loosest = 0, tightest = sizeof(levels) / sizeof(levels[0]) - 1;
+
+bool isLetter(const char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+bool isDigit(const char c) { return c >= '0' && c <= '9'; }
+
+////////////////////////////////////////////////////////////
+//
+// class Parser
+//
+// Recursive descent, emitting code as it goes.  After the first error
+// every token reads as End, so that the descent unwinds by itself.  The
+// descent is bounded by maxDepth, so that no source, however deeply it
+// nests, can overflow the native stack.
+
+class Parser {
+private:
+	// Counts one level of the descent for as long as it lives.
+	class Nest {
+	private:
+		Parser& m_parser;
+	public:
+		explicit Nest(Parser& parser) : m_parser(parser) {
+			if (++m_parser.m_depth > maxDepth)
+				m_parser.fail("yacc stack overflow");
+		}
+		~Nest() { --m_parser.m_depth; }
+		bool overflowed() const { return m_parser.m_depth > maxDepth; }
+	};
+
+	struct Lexer {
+		const char* p;
+		int line;
+		int token;
+		Word number;
+		Name name;
+	};
+
+	struct Function {
+		Name name;
+		int firstUse;    // line, for "function referenced but not found"
+		bool defined;
+	};
+
+	const char* const m_end;
+	Lexer m_lex;
+	Image& m_image;
+	CompileError* m_error;
+	bool m_failed;
+
+	std::vector<Name> m_externals;
+	std::vector<Name> m_locals;    // of the function being compiled
+	std::vector<Function> m_functions; // in link list order
+	int m_ifs, m_whiles;           // nesting
+	int m_depth;                   // of the descent, see Nest
+
+	// Lexer
+	void next();
+	Name cut(const char* text, const std::size_t length) const;
+	bool accept(const int token);
+	void expect(const int token);
+	void fail(const char* message);
+
+	// Symbols
+	Word variable(const Name& name);
+	int function(const Name& name);
+	void declare(std::vector<Name>& pool, const Name& name);
+
+	// Code
+	int emit(const int op, const Word operand = 0, const int opcode = Instruction::assign);
+	void patch(const int at, const int target) { if (!m_failed) m_image.code[at].operand = target; }
+	int here() const { return static_cast<int>(m_image.code.size()); }
+
+	// Grammar
+	bool typeWord() const;
+	void declarations(std::vector<Name>& pool);
+	void definition(const Name& name);
+	void compound();
+	void statement();
+	void expression();
+	void binary(const int level);
+	void unary();
+	void primary();
+	void call(const Name& name);
+
+public:
+	Parser(const char* source, const std::size_t length, Image& image, CompileError* error);
+	bool program();
+};
+
+Parser::Parser(const char* source, const std::size_t length, Image& image, CompileError* error)
+	: m_end(source + length), m_image(image), m_error(error), m_failed(false), m_ifs(0), m_whiles(0), m_depth(0)
+{
+	m_lex.p = source;
+	m_lex.line = 1;
+	m_image.code.clear();
+	m_image.links.clear();
+	m_image.externals = 0;
+	m_image.main = -1;
+	m_image.code.reserve(codeSpace);
+	next();
+}
+
+void Parser::fail(const char* message) {
+	if (m_failed)
+		return;
+	m_failed = true;
+	if (m_error) {
+		m_error->message = message;
+		m_error->line = m_lex.line;
+	}
+	m_lex.token = End;
+}
+
+Name Parser::cut(const char* text, const std::size_t length) const {
+	Name name;
+	name.length = static_cast<unsigned char>(length < significant ? length : significant);
+	std::memcpy(name.text, text, name.length);
+	return name;
+}
+
+void Parser::next() {
+	if (m_failed)
+		return;
+	const char* p = m_lex.p;
+	for (;;) {
+		while (p < m_end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == '\f')) {
+			if (*p == '\n')
+				++m_lex.line;
+			++p;
+		}
+		if (p + 1 < m_end && p[0] == '/' && p[1] == '*') {
+			for (p += 2; p < m_end && !(p[0] == '*' && p + 1 < m_end && p[1] == '/'); ++p)
+				if (*p == '\n')
+					++m_lex.line;
+			p = p < m_end ? p + 2 : m_end;
+			continue;
+		}
+		break;
+	}
+	if (p == m_end) {
+		m_lex.p = p;
+		m_lex.token = End;
+		return;
+	}
+
+	if (isDigit(*p)) {
+		std::uint32_t n = 0;
+		for (; p < m_end && isDigit(*p); ++p)
+			n = n * 10 + static_cast<std::uint32_t>(*p - '0');
+		m_lex.p = p;
+		m_lex.token = Number;
+		m_lex.number = static_cast<Word>(n);
+		return;
+	}
+	if (isLetter(*p)) {
+		const char* const start = p;
+		while (p < m_end && (isLetter(*p) || isDigit(*p)))
+			++p;
+		m_lex.p = p;
+		m_lex.token = Identifier;
+		const std::size_t length = p - start;
+		for (std::size_t k = 0; k < sizeof(keywords) / sizeof(keywords[0]); ++k)
+			if (std::strlen(keywords[k].text) == length && std::memcmp(keywords[k].text, start, length) == 0)
+				m_lex.token = keywords[k].token;
+		m_lex.name = cut(start, length);
+		return;
+	}
+
+	const char c = *p, d = p + 1 < m_end ? p[1] : 0, e = p + 2 < m_end ? p[2] : 0;
+	int token = c, length = 1;
+	switch (c) {
+	case '<':
+		if (d == '<') { token = e == '=' ? ShlAssign : Shl; length = e == '=' ? 3 : 2; }
+		else if (d == '=') { token = Le; length = 2; }
+		break;
+	case '>':
+		if (d == '>') { token = e == '=' ? ShrAssign : Shr; length = e == '=' ? 3 : 2; }
+		else if (d == '=') { token = Ge; length = 2; }
+		break;
+	case '=': if (d == '=') { token = Eq; length = 2; } break;
+	case '!': if (d == '=') { token = Ne; length = 2; } break;
+	case '&':
+		if (d == '&') { token = And; length = 2; }
+		else if (d == '=') { token = AndAssign; length = 2; }
+		break;
+	case '|':
+		if (d == '|') { token = Or; length = 2; }
+		else if (d == '=') { token = OrAssign; length = 2; }
+		break;
+	case '+':
+		if (d == '+') { token = Inc; length = 2; }
+		else if (d == '=') { token = AddAssign; length = 2; }
+		break;
+	case '-':
+		if (d == '-') { token = Dec; length = 2; }
+		else if (d == '=') { token = SubAssign; length = 2; }
+		break;
+	case '*': if (d == '=') { token = MulAssign; length = 2; } break;
+	case '/': if (d == '=') { token = DivAssign; length = 2; } break;
+	case '%': if (d == '=') { token = ModAssign; length = 2; } break;
+	case '^': if (d == '=') { token = XorAssign; length = 2; } break;
+	case '~': case '(': case ')': case '{': case '}': case ',': case ';':
+		break;
+	default:
+		m_lex.p = p;
+		fail("syntax error");
+		return;
+	}
+	m_lex.p = p + length;
+	m_lex.token = token;
+}
+
+bool Parser::accept(const int token) {
+	if (m_lex.token != token)
+		return false;
+	next();
+	return true;
+}
+
+void Parser::expect(const int token) {
+	if (!accept(token))
+		fail("syntax error");
+}
+
+void Parser::declare(std::vector<Name>& pool, const Name& name) {
+	for (std::size_t i = 0; i < pool.size(); ++i)
+		if (pool[i] == name)
+			return;
+	if (pool.size() == static_cast<std::size_t>(maxVariables))
+		fail("symbol pool exceeded");
+	else
+		pool.push_back(name);
+}
+
+// A FETCH or STORE operand; undeclared names become locals.
+Word Parser::variable(const Name& name) {
+	for (std::size_t i = 0; i < m_locals.size(); ++i)
+		if (m_locals[i] == name)
+			return static_cast<Word>(i);
+	for (std::size_t i = 0; i < m_externals.size(); ++i)
+		if (m_externals[i] == name)
+			return static_cast<Word>(i) | external;
+	declare(m_locals, name);
+	return static_cast<Word>(m_locals.size()) - 1;
+}
+
+// A link list index, adding the function if it is new.
+int Parser::function(const Name& name) {
+	for (std::size_t i = 0; i < m_functions.size(); ++i)
+		if (m_functions[i].name == name)
+			return static_cast<int>(i);
+	if (m_functions.size() == static_cast<std::size_t>(maxFunctions)) {
+		fail("symbol pool exceeded");
+		return 0;
+	}
+	const Function f = { name, m_lex.line, false };
+	m_functions.push_back(f);
+	const Link link = { std::string(name.text, name.length), -1, 0, 0 };
+	m_image.links.push_back(link);
+	return static_cast<int>(m_functions.size()) - 1;
+}
+
+int Parser::emit(const int op, const Word operand, const int opcode) {
+	if (m_failed)
+		return 0;
+	if (here() == codeSpace) {
+		fail("instruction space exceeded");
+		return 0;
+	}
+	const Instruction in = { static_cast<std::uint8_t>(op), static_cast<std::uint8_t>(opcode), operand };
+	m_image.code.push_back(in);
+	return here() - 1;
+}
+
+bool Parser::typeWord() const {
+	return m_lex.token == Int || m_lex.token == Long || m_lex.token == Auto || m_lex.token == Register;
+}
+
+// [auto|register] [int|long] name, name, ... ;
+void Parser::declarations(std::vector<Name>& pool) {
+	while (typeWord())
+		next();
+	do {
+		if (m_lex.token != Identifier) {
+			fail("syntax error");
+			return;
+		}
+		declare(pool, m_lex.name);
+		next();
+	} while (accept(','));
+	expect(';');
+}
+
+bool Parser::program() {
+	while (m_lex.token != End) {
+		bool typed = false;
+		while (typeWord()) {
+			typed = true;
+			next();
+		}
+		if (m_lex.token != Identifier) {
+			fail("syntax error");
+			break;
+		}
+		const Name name = m_lex.name;
+		next();
+		if (m_lex.token == '(') {
+			definition(name);
+			continue;
+		}
+		if (!typed) {
+			fail("syntax error");
+			break;
+		}
+		// externals
+		declare(m_externals, name);
+		while (accept(',')) {
+			if (m_lex.token != Identifier) {
+				fail("syntax error");
+				break;
+			}
+			declare(m_externals, m_lex.name);
+			next();
+		}
+		expect(';');
+	}
+	emit(Instruction::nop); // the end of the code
+
+	for (std::size_t i = 0; i < m_functions.size() && !m_failed; ++i)
+		if (!m_functions[i].defined) {
+			m_lex.line = m_functions[i].firstUse;
+			fail("function referenced but not found");
+		}
+	const Name main = cut("main", 4);
+	for (std::size_t i = 0; i < m_functions.size(); ++i)
+		if (m_functions[i].name == main && m_functions[i].defined)
+			m_image.main = static_cast<int>(i);
+	if (m_image.main < 0)
+		fail("main not defined");
+	m_image.externals = static_cast<int>(m_externals.size());
+	return !m_failed;
+}
+
+// name ( params ) declarations { body }
+void Parser::definition(const Name& name) {
+	if (Intrinsic::find(std::string(name.text, name.length))) {
+		fail("function definition same as intrinsic");
+		return;
+	}
+	const int index = function(name);
+	if (m_failed)
+		return;
+	if (m_functions[index].defined) {
+		fail("syntax error");
+		return;
+	}
+	m_functions[index].defined = true;
+
+	m_locals.clear();
+	expect('(');
+	if (m_lex.token != ')') {
+		do {
+			if (m_lex.token != Identifier) {
+				fail("syntax error");
+				return;
+			}
+			declare(m_locals, m_lex.name);
+			next();
+		} while (accept(','));
+	}
+	expect(')');
+	const int params = static_cast<int>(m_locals.size());
+	while (typeWord())
+		declarations(m_locals);
+
+	m_image.links[index].entry = here();
+	m_image.links[index].params = params;
+	compound();
+	emit(Instruction::constant, 0); // the dummy return value
+	emit(Instruction::retsub);
+	m_image.links[index].locals = static_cast<int>(m_locals.size());
+}
+
+void Parser::compound() {
+	expect('{');
+	while (typeWord())
+		declarations(m_locals);
+	while (m_lex.token != '}' && m_lex.token != End)
+		statement();
+	expect('}');
+}
+
+void Parser::statement() {
+	const Nest nest(*this);
+	if (nest.overflowed())
+		return;
+	switch (m_lex.token) {
+	case ';':
+		next();
+		break;
+	case '{':
+		compound();
+		break;
+	case If: {
+		if (++m_ifs > maxNesting)
+			fail("if nest level exceeded");
+		next();
+		expect('(');
+		expression();
+		expect(')');
+		const int skip = emit(Instruction::branch);
+		statement();
+		if (accept(Else)) {
+			emit(Instruction::constant, 0);
+			const int over = emit(Instruction::branch);
+			patch(skip, here());
+			statement();
+			patch(over, here());
+		} else
+			patch(skip, here());
+		--m_ifs;
+		break;
+	}
+	case While: {
+		if (++m_whiles > maxNesting)
+			fail("while nest level exceeded");
+		next();
+		const int top = here();
+		expect('(');
+		expression();
+		expect(')');
+		const int exit = emit(Instruction::branch);
+		statement();
+		emit(Instruction::constant, 0);
+		emit(Instruction::branch, top);
+		patch(exit, here());
+		--m_whiles;
+		break;
+	}
+	case Return:
+		next();
+		if (m_lex.token == ';')
+			emit(Instruction::constant, 0);
+		else
+			expression();
+		emit(Instruction::retsub);
+		expect(';');
+		break;
+	case Break: // "unsupported break": ignored
+		next();
+		expect(';');
+		break;
+	default:
+		expression();
+		emit(Instruction::chop);
+		expect(';');
+		break;
+	}
+}
+
+// Assignment, right to left, then the binary operators.
+void Parser::expression() {
+	const Nest nest(*this);
+	if (nest.overflowed())
+		return;
+	if (m_lex.token == Identifier) {
+		const Lexer before = m_lex;
+		next();
+		int opcode = -1;
+		switch (m_lex.token) {
+		case '=': opcode = Instruction::assign; break;
+		case AddAssign: opcode = Instruction::add; break;
+		case SubAssign: opcode = Instruction::sub; break;
+		case MulAssign: opcode = Instruction::mul; break;
+		case DivAssign: opcode = Instruction::div; break;
+		case ModAssign: opcode = Instruction::mod; break;
+		case ShlAssign: opcode = Instruction::shl; break;
+		case ShrAssign: opcode = Instruction::shr; break;
+		case AndAssign: opcode = Instruction::band; break;
+		case XorAssign: opcode = Instruction::bxor; break;
+		case OrAssign: opcode = Instruction::bor; break;
+		}
+		if (opcode >= 0) {
+			next();
+			expression();
+			emit(Instruction::store, variable(before.name), opcode);
+			return;
+		}
+		if (!m_failed)
+			m_lex = before;
+	}
+	binary(loosest);
+}
+
+void Parser::binary(const int level) {
+	if (level > tightest) {
+		unary();
+		return;
+	}
+	binary(level + 1);
+	for (;;) {
+		const Level& l = levels[level];
+		int k = 0;
+		while (k < 4 && l.tokens[k] && l.tokens[k] != m_lex.token)
+			++k;
+		if (k == 4 || !l.tokens[k])
+			return;
+		next();
+		binary(level + 1);
+		emit(Instruction::binop, 0, l.opcodes[k]);
+	}
+}
+
+void Parser::unary() {
+	const Nest nest(*this);
+	if (nest.overflowed())
+		return;
+	switch (m_lex.token) {
+	case '-':
+		next();
+		if (m_lex.token == Number) { // a negative constant
+			emit(Instruction::constant, static_cast<Word>(0u - static_cast<std::uint32_t>(m_lex.number)));
+			next();
+		} else {
+			emit(Instruction::constant, 0);
+			unary();
+			emit(Instruction::binop, 0, Instruction::sub);
+		}
+		break;
+	case '!':
+		next();
+		unary();
+		emit(Instruction::constant, 0);
+		emit(Instruction::binop, 0, Instruction::eq);
+		break;
+	case '~':
+		next();
+		unary();
+		emit(Instruction::constant, -1);
+		emit(Instruction::binop, 0, Instruction::bxor);
+		break;
+	case Inc:
+	case Dec: {
+		const int opcode = m_lex.token == Inc ? Instruction::add : Instruction::sub;
+		next();
+		if (m_lex.token != Identifier) {
+			fail("syntax error");
+			return;
+		}
+		emit(Instruction::constant, 1);
+		emit(Instruction::store, variable(m_lex.name), opcode);
+		next();
+		break;
+	}
+	default:
+		primary();
+		break;
+	}
+}
+
+void Parser::primary() {
+	switch (m_lex.token) {
+	case Number:
+		emit(Instruction::constant, m_lex.number);
+		next();
+		break;
+	case Identifier: {
+		const Name name = m_lex.name;
+		next();
+		if (m_lex.token == '(')
+			call(name);
+		else if (m_lex.token == Inc || m_lex.token == Dec) { // postfix, taken as prefix
+			emit(Instruction::constant, 1);
+			emit(Instruction::store, variable(name), m_lex.token == Inc ? Instruction::add : Instruction::sub);
+			next();
+		} else
+			emit(Instruction::fetch, variable(name));
+		break;
+	}
+	case '(':
+		next();
+		expression();
+		expect(')');
+		break;
+	default:
+		fail("syntax error");
+		break;
+	}
+}
+
+void Parser::call(const Name& name) {
+	const Intrinsic* const intrinsic = Intrinsic::find(std::string(name.text, name.length));
+	const int link = intrinsic ? -1 - static_cast<int>(intrinsic - intrinsics) : function(name);
+	emit(Instruction::frame);
+	expect('(');
+	if (m_lex.token != ')') {
+		do
+			expression();
+		while (accept(','));
+	}
+	expect(')');
+	emit(Instruction::fcall, link);
+}
+
+} // namespace
+
+bool compile(const char* source, const std::size_t length, Image& image, CompileError* error) {
+	Parser parser(source, length, image, error);
+	return parser.program();
+}
+
+} // namespace Vm
@@ -0,0 +1,41 @@
+// Compiler.h
+// Compiles the CROBOTS C subset into an Image for the robot CPU.
+
+#ifndef Compiler_h__
+#define Compiler_h__
+
+#include <cstddef>
+#include <string>
+
+#include "Bytecode.h"
+
+namespace Vm {
+
+struct CompileError {
+	std::string message;  // as CROBOTS words it, e.g. "syntax error"
+	int line;             // from 1
+};
+
+// Compiles a robot program into 'image'.  Like CROBOTS, stops at the first
+// error: returns false, with 'error' filled in if given, and leaves
+// 'image' unspecified.
+//
+// The language is what the CROBOTS documentation describes: externals,
+// functions with K&R parameter declarations, locals, if/else, while,
+// return, the C operators without ?: and ',', and the intrinsics.
+// Identifiers are significant to 7 characters, undeclared variables are
+// locals, postfix ++ and -- act as prefix, 'break' is ignored, and && and
+// || evaluate both sides.  Nesting too deep for CROBOTS's parser fails with
+// "yacc stack overflow".
+//
+// One pass, over the source in place; a typical robot compiles in tens of
+// microseconds.
+bool compile(const char* source, const std::size_t length, Image& image, CompileError* error = 0);
+
+inline bool compile(const std::string& source, Image& image, CompileError* error = 0) {
+	return compile(source.data(), source.size(), image, error);
+}
+
+} // namespace Vm
+
+#endif // Compiler_h__
@@ -0,0 +1,157 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <string>
+
+#include "../Shared/Arena.h"
+#include "../Shared/Bot.h"
+#include "../Shared/Compiler.h"
+#include "../Shared/Cpu.h"
+#include "../Shared/SampleRobots.h"
+
+namespace {
+
+// Compiles and runs 'source' until it has had 'cycles' cycles.
+struct Compiled {
+	Vm::Image image;
+	Vm::CompileError error;
+	bool compiled;
+
+	Compiled(const std::string& source) : compiled(Vm::compile(source, image, &error)) {}
+
+	Vm::Word external(const int i, const long cycles = 10000) {
+		Vm::Cpu cpu(image);
+		cpu.run(cycles);
+		return cpu.external(i);
+	}
+};
+
+bool fails(const std::string& source, const char* message, const int line) {
+	Vm::Image image;
+	Vm::CompileError error;
+	return !Vm::compile(source, image, &error) && error.message == message && error.line == line;
+}
+
+}
+
+SUITE(CompilerTestSuite) {
+
+TEST(CompilesTheSampleRobots) {
+	const char* const robots[] = { Vm::Samples::rabbit, Vm::Samples::counter, Vm::Samples::rook, Vm::Samples::sniper };
+	for (int r = 0; r < 4; ++r) {
+		Vm::Image image;
+		Vm::CompileError error;
+		CHECK(Vm::compile(robots[r], image, &error));
+		CHECK(image.code.size() <= static_cast<std::size_t>(Vm::codeSpace));
+		CHECK_EQUAL(Vm::Instruction::nop, image.code.back().op);
+		CHECK_EQUAL("main", image.links[image.main].name);
+	}
+
+	Vm::Image sniper;
+	Vm::compile(Vm::Samples::sniper, sniper);
+	CHECK_EQUAL(15, sniper.externals);
+	CHECK_EQUAL(4u, sniper.links.size());
+	CHECK_EQUAL("new_cor", sniper.links[1].name); // significant to 7 characters
+	CHECK_EQUAL("plot_co", sniper.links[2].name);
+	CHECK_EQUAL(4, sniper.links[3].params);
+	CHECK_EQUAL(6, sniper.links[3].locals);
+}
+
+TEST(ExpressionsFollowKAndR) {
+	CHECK_EQUAL(14, Compiled("int r; main() { r = 2 + 3 * 4; }").external(0));
+	CHECK_EQUAL(20, Compiled("int r; main() { r = (2 + 3) * 4; }").external(0));
+	CHECK_EQUAL(1, Compiled("int r; main() { r = 1 < 2 == 1; }").external(0));
+	CHECK_EQUAL(7, Compiled("int r; main() { r = 1 | 2 & 3 ^ 4 + 1; }").external(0));
+	CHECK_EQUAL(-7, Compiled("int r; main() { r = -7; }").external(0));
+	CHECK_EQUAL(2, Compiled("int r; main() { r = 10 - 5 - 3; }").external(0));
+	CHECK_EQUAL(-6, Compiled("int r; main() { int x; x = 6; r = -x; }").external(0));
+	CHECK_EQUAL(1, Compiled("int r; main() { r = !0 && ~-1 == 0; }").external(0));
+	CHECK_EQUAL(16, Compiled("int r; main() { r = 1 << 6 >> 2; }").external(0));
+	CHECK_EQUAL(5, Compiled("int a, b; main() { a = b = 5; }").external(0));
+	CHECK_EQUAL(12, Compiled("int r; main() { r = 5; r += 7; }").external(0));
+	CHECK_EQUAL(1, Compiled("int r; main() { r = 9; r %= 4; }").external(0));
+	CHECK_EQUAL(24, Compiled("int r; main() { r = 3; r <<= 3; }").external(0));
+	CHECK_EQUAL(2, Compiled("int r; main() { r = 0; r++; ++r; while (1) ; }").external(0));
+	// postfix is prefix
+	CHECK_EQUAL(3, Compiled("int a, b; main() { a = 2; b = a++; }").external(1));
+}
+
+TEST(StatementsAndCalls) {
+	CHECK_EQUAL(55, Compiled("int r; main() { int i; while (i < 10) r += ++i; while (1) ; }").external(0));
+	CHECK_EQUAL(2, Compiled("int r; main() { if (0) r = 1; else if (1) r = 2; else r = 3; }").external(0));
+	CHECK_EQUAL(720, Compiled(
+		"int r;\n"
+		"main() { r = fact(6); }\n"
+		"fact(n) int n; { if (n < 2) return 1; return (n * fact(n - 1)); }\n").external(0));
+	// a function without a return gives 0; break is ignored
+	CHECK_EQUAL(0, Compiled("int r; main() { r = 5; r = f(); while (1) ; } f() { break; }").external(0));
+	// externals are kept when main() returns and starts again, after five
+	// instructions and the return to the top
+	Compiled count("int r; main() { r += 1; }");
+	CHECK_EQUAL(4, count.external(0, 4 * 6));
+	// intrinsics
+	CHECK_EQUAL(12, Compiled("int r; main() { r = sqrt(-150); }").external(0));
+	CHECK_EQUAL(45, Compiled("int r; main() { r = atan(100000); }").external(0));
+	CHECK_EQUAL(-100000, Compiled("long r; main() { r = cos(180) + sin(360); }").external(0));
+}
+
+TEST(ReportsTheFirstError) {
+	CHECK(fails("main() {\n x = ;\n}", "syntax error", 2));
+	CHECK(fails("main() {\n x = 1\n}", "syntax error", 3));
+	CHECK(fails("main() { x = 1 ? 2 : 3; }", "syntax error", 1));
+	CHECK(fails("int x;", "main not defined", 1));
+	CHECK(fails("main() {\n\n go(); }", "function referenced but not found", 3));
+	CHECK(fails("main() { } scan(a, b) { }", "function definition same as intrinsic", 1));
+	CHECK(fails("main() { } main() { }", "syntax error", 1));
+	CHECK(fails("main() { x = 1 @ 2; }", "syntax error", 1));
+
+	std::string many = "int";
+	for (int i = 0; i < 65; ++i)
+		many += std::string(i ? "," : "") + " v" + std::to_string(i);
+	CHECK(fails(many + "; main() { }", "symbol pool exceeded", 1));
+
+	std::string nested = "main() {";
+	for (int i = 0; i < 17; ++i)
+		nested += " while (1)";
+	CHECK(fails(nested + " ; }", "while nest level exceeded", 1));
+
+	// however deep a hostile source nests, the descent stops before the
+	// native stack does
+	const std::string deep(100000, '(');
+	CHECK(fails("main() { x = " + deep + "1; }", "yacc stack overflow", 1));
+	std::string negated;
+	for (int i = 0; i < 50000; ++i)
+		negated += "- ";
+	CHECK(fails("main() { x = " + negated + "y; }", "yacc stack overflow", 1));
+	CHECK(fails("main() " + std::string(100000, '{'), "yacc stack overflow", 1));
+	Vm::Image image;
+	CHECK(Vm::compile("main() { x = " + std::string(40, '(') + "-1" + std::string(40, ')') + "; }", image));
+
+	std::string big = "main() {";
+	for (int i = 0; i < 250; ++i)
+		big += " x = x + 1;";
+	CHECK(fails(big + " }", "instruction space exceeded", 1));
+}
+
+TEST(SamplesRunAgainstAnArena) {
+	Server::Arena arena(2);
+	const Server::Bot sniper(arena, arena.enter(Geometry::Point(500, 500), Geometry::Angle(), "sniper"));
+	const Server::Bot rabbit(arena, arena.enter(Geometry::Point(300, 700), Geometry::Angle(), "rabbit"));
+	Vm::Image sniperImage, rabbitImage;
+	CHECK(Vm::compile(Vm::Samples::sniper, sniperImage));
+	CHECK(Vm::compile(Vm::Samples::rabbit, rabbitImage));
+	Server::BotHost sniperHost(sniper), rabbitHost(rabbit);
+	Vm::Cpu sniperCpu(sniperImage, &sniperHost, 7), rabbitCpu(rabbitImage, &rabbitHost, 11);
+
+	for (int tick = 0; tick < 3000 && sniper.alive() && rabbit.alive(); ++tick) {
+		sniperCpu.run(50);
+		rabbitCpu.run(50);
+		arena.tick();
+	}
+	CHECK_EQUAL(0, sniperCpu.overflows());
+	CHECK_EQUAL(0, rabbitCpu.overflows());
+	CHECK(arena.stats(sniper.id()).scans > 0);
+	CHECK(arena.stats(sniper.id()).shots > 0);
+	CHECK(rabbit.position().x() != 300.0);
+}
+
+}
@@ -0,0 +1,139 @@
+// Cpu.bench.cpp
+// Measures how many robot instructions per second the Cpu executes on each
+// tier, and how many robots per second the Compiler compiles.  Built on its
+// own, outside of jbots-test, from this directory:
+//   mkdir -p /tmp/jbots/include && ln -sfn "$PWD" /tmp/jbots/Shared
+//   c++ -std=c++20 -O2 -I/tmp/jbots/include Cpu.bench.cpp Cpu.cpp Registers.cpp Jit.cpp Aot.cpp Compiler.cpp Bytecode.cpp Trig.cpp Fixed.cpp -o cpu-bench
+// The sources include "../Shared/X.h", which the first line makes resolve
+// from /tmp/jbots/include to this directory.
+// The compiled tier's plug-ins are built in the current directory.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "../Shared/Compiler.h"
+#include "../Shared/Cpu.h"
+#include "../Shared/SampleRobots.h"
+
+namespace {
+
+const long cycles = 200000000;
+
+typedef Vm::Instruction I;
+
+void emit(Vm::Image& image, const int op, const Vm::Word operand = 0, const int opcode = I::assign) {
+	const I in = { static_cast<std::uint8_t>(op), static_cast<std::uint8_t>(opcode), operand };
+	image.code.push_back(in);
+}
+
+// main() { while (1) { x = x + i * 3; i += 1; } } with x and i local.
+Vm::Image arithmetic() {
+	Vm::Image image;
+	image.externals = 0;
+	image.main = 0;
+	const Vm::Link main = { "main", 0, 0, 2 };
+	image.links.push_back(main);
+	emit(image, I::fetch, 0);
+	emit(image, I::fetch, 1);
+	emit(image, I::constant, 3);
+	emit(image, I::binop, 0, I::mul);
+	emit(image, I::binop, 0, I::add);
+	emit(image, I::store, 0);
+	emit(image, I::chop);
+	emit(image, I::constant, 1);
+	emit(image, I::store, 1, I::add);
+	emit(image, I::chop);
+	emit(image, I::constant, 0);
+	emit(image, I::branch, 0);
+	return image;
+}
+
+// main() { while (1) d = d + f(d); }  f(a) { return a & 7; }
+Vm::Image calls() {
+	Vm::Image image;
+	image.externals = 1;
+	image.main = 0;
+	const Vm::Link main = { "main", 0, 0, 0 }, f = { "f", 9, 1, 1 };
+	image.links.push_back(main);
+	image.links.push_back(f);
+	emit(image, I::fetch, 0 | Vm::external);
+	emit(image, I::frame);
+	emit(image, I::fetch, 0 | Vm::external);
+	emit(image, I::fcall, 1);
+	emit(image, I::binop, 0, I::add);
+	emit(image, I::store, 0 | Vm::external);
+	emit(image, I::chop);
+	emit(image, I::constant, 0);
+	emit(image, I::branch, 0);
+	emit(image, I::fetch, 0);
+	emit(image, I::constant, 7);
+	emit(image, I::binop, 0, I::band);
+	emit(image, I::retsub);
+	return image;
+}
+
+void report(const char* name, Vm::Cpu& cpu) {
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point start = Clock::now();
+	cpu.run(cycles);
+	const Clock::time_point stop = Clock::now();
+	const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+	std::printf("%-28s %8.2f ns/instruction %8.0f M/s\n", name, ns / cycles, cycles / ns * 1000.0);
+}
+
+void report(const char* name, const Vm::Image& image, const Vm::Cpu::Tier tier) {
+	Vm::Cpu cpu(image, 0, 1, tier);
+	report(name, cpu);
+}
+
+void report(const char* name, const Vm::Image& image, Vm::Aot& aot) {
+	const Vm::Module* const module = aot.load(image);
+	if (!module) {
+		std::printf("%-28s could not be built\n", name);
+		return;
+	}
+	Vm::Cpu cpu(image, *module);
+	report(name, cpu);
+}
+
+void reportCompile(const char* name, const char* source) {
+	typedef std::chrono::steady_clock Clock;
+	const int compiles = 20000;
+	Vm::Image image;
+	const Clock::time_point start = Clock::now();
+	for (int i = 0; i < compiles; ++i)
+		Vm::compile(source, std::strlen(source), image);
+	const Clock::time_point stop = Clock::now();
+	const double us = std::chrono::duration<double, std::micro>(stop - start).count();
+	std::printf("%-28s %8.2f us/compile %8.0f /s\n", name, us / compiles, compiles / us * 1e6);
+}
+
+} // namespace
+
+int main(const int, char const**) {
+	Vm::Aot aot(".");
+	report("Cpu (arithmetic)", arithmetic(), Vm::Cpu::stack);
+	report("Cpu (arithmetic, registers)", arithmetic(), Vm::Cpu::registers);
+	report("Cpu (arithmetic, native)", arithmetic(), Vm::Cpu::native);
+	report("Cpu (arithmetic, compiled)", arithmetic(), aot);
+	report("Cpu (calls)", calls(), Vm::Cpu::stack);
+	report("Cpu (calls, registers)", calls(), Vm::Cpu::registers);
+	report("Cpu (calls, native)", calls(), Vm::Cpu::native);
+	report("Cpu (calls, compiled)", calls(), aot);
+	// with no host, so that intrinsics answer 0
+	Vm::Image sniper, rook;
+	Vm::compile(Vm::Samples::sniper, std::strlen(Vm::Samples::sniper), sniper);
+	Vm::compile(Vm::Samples::rook, std::strlen(Vm::Samples::rook), rook);
+	report("Cpu (sniper.r)", sniper, Vm::Cpu::stack);
+	report("Cpu (sniper.r, registers)", sniper, Vm::Cpu::registers);
+	report("Cpu (sniper.r, native)", sniper, Vm::Cpu::native);
+	report("Cpu (sniper.r, compiled)", sniper, aot);
+	report("Cpu (rook.r)", rook, Vm::Cpu::stack);
+	report("Cpu (rook.r, registers)", rook, Vm::Cpu::registers);
+	report("Cpu (rook.r, native)", rook, Vm::Cpu::native);
+	report("Cpu (rook.r, compiled)", rook, aot);
+	reportCompile("compile (rabbit.r)", Vm::Samples::rabbit);
+	reportCompile("compile (sniper.r)", Vm::Samples::sniper);
+	return 0;
+}
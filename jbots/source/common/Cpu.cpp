@@ -0,0 +1,570 @@
+// Cpu.cpp
+// The CROBOTS robot CPU, as a direct-threaded interpreter.
+
+#include "Cpu.h"
+
+#include <algorithm> // copy(), fill()
+
+#if defined(__GNUC__)
+#define JBOTS_THREADED 1 // labels as values
+#endif
+
+namespace Vm {
+
+namespace {
+
+#define JBOTS_CPU_HANDLERS(X) \
+	X(Nop) X(FetchLocal) X(FetchExternal) X(StoreLocal) X(StoreExternal) \
+	X(UpdateLocal) X(UpdateExternal) X(Constant) \
+	X(Add) X(Sub) X(Mul) X(Div) X(Mod) X(Shl) X(Shr) X(Band) X(Bor) X(Bxor) \
+	X(Land) X(Lor) X(Lt) X(Le) X(Eq) X(Ne) X(Ge) X(Gt) \
+	X(Call) X(CallIntrinsic) X(Return) X(Branch) X(Chop) X(Frame) X(Restart) \
+	X(Segment) X(Pop) X(Push) X(Goto) X(Native)
+
+// The registers tier's steps for each operator, Compute and Unless, in the
+// operators' order.
+#define JBOTS_CPU_OPERATORS(X) \
+	X(Assign, assign) X(Add, add) X(Sub, sub) X(Mul, mul) X(Div, div) X(Mod, mod) \
+	X(Shl, shl) X(Shr, shr) X(Band, band) X(Bor, bor) X(Bxor, bxor) X(Land, land) \
+	X(Lor, lor) X(Lt, lt) X(Le, le) X(Eq, eq) X(Ne, ne) X(Ge, ge) X(Gt, gt)
+
+#define JBOTS_CPU_ENUM(name) name,
+#define JBOTS_CPU_STEP_ENUM(name, op) Compute##name, Unless##name,
+enum Handler { JBOTS_CPU_HANDLERS(JBOTS_CPU_ENUM) JBOTS_CPU_OPERATORS(JBOTS_CPU_STEP_ENUM) handlers };
+#undef JBOTS_CPU_STEP_ENUM
+#undef JBOTS_CPU_ENUM
+
+// Room past the top of the stack for a function's locals, and an
+// intrinsic's missing arguments, to be addressed without bounds checks.
+const int slack = maxVariables + 2;
+
+// Where the registers tier keeps its constants, then its temporaries.
+const int registerFile = stackSize + slack;
+
+} // namespace
+
+////////////////////////////////////////////////////////////
+// class Cpu
+
+Cpu::Cpu(const Image& image, Host* host, const std::uint32_t seed, const Tier tier)
+	: m_image(&image), m_host(host), m_tier(tier), m_module(0), m_stack(stackSize + slack, 0),
+	  m_random(seed), m_cycles(0), m_overflows(0)
+{
+	enterMain(true);
+}
+
+Cpu::Cpu(const Image& image, const Module& module, Host* host, const std::uint32_t seed)
+	: m_image(&image), m_host(host), m_tier(compiled), m_module(module.loaded() ? &module : 0),
+	  m_stack(stackSize + slack, 0), m_random(seed), m_cycles(0), m_overflows(0)
+{
+	enterMain(true);
+}
+
+void Cpu::reset() {
+	enterMain(true);
+}
+
+void Cpu::thread(const std::intptr_t* handlers) {
+	const std::vector<Instruction>& code = m_image->code;
+	const int end = static_cast<int>(code.size());
+	m_code.resize(code.size() + 1);
+	for (int i = 0; i < end; ++i) {
+		const Instruction& in = code[i];
+		Threaded& t = m_code[i];
+		const bool isExternal = (in.operand & Vm::external) != 0;
+		const Word offset = in.operand & ~Vm::external;
+		const bool variable = isExternal ? offset >= 0 && offset < m_image->externals
+		                                 : in.operand >= 0 && in.operand < maxVariables;
+		int h = Restart; // for anything that cannot run
+		t.operand = offset;
+		t.extra = 0;
+		switch (in.op) {
+		case Instruction::nop:
+			h = Nop;
+			break;
+		case Instruction::fetch:
+			if (variable)
+				h = isExternal ? FetchExternal : FetchLocal;
+			break;
+		case Instruction::store:
+			if (variable && in.opcode == Instruction::assign)
+				h = isExternal ? StoreExternal : StoreLocal;
+			else if (variable && in.opcode < Instruction::binops) {
+				h = isExternal ? UpdateExternal : UpdateLocal;
+				t.extra = in.opcode;
+			}
+			break;
+		case Instruction::constant:
+			h = Constant;
+			t.operand = in.operand;
+			break;
+		case Instruction::binop:
+			if (in.opcode > Instruction::assign && in.opcode < Instruction::binops)
+				h = Add + (in.opcode - Instruction::add);
+			break;
+		case Instruction::fcall:
+			if (in.operand >= 0 && in.operand < static_cast<Word>(m_image->links.size())) {
+				const Link& link = m_image->links[in.operand];
+				if (link.entry >= 0 && link.entry < end && link.locals >= 0 && link.locals <= maxVariables) {
+					h = Call;
+					t.operand = link.entry;
+					t.extra = link.locals;
+				}
+			} else if (in.operand < 0 && -1 - in.operand < Intrinsic::count) {
+				h = CallIntrinsic;
+				t.operand = -1 - in.operand;
+			}
+			break;
+		case Instruction::retsub:
+			h = Return;
+			break;
+		case Instruction::branch:
+			if (in.operand >= 0 && in.operand <= end) {
+				h = Branch;
+				t.operand = in.operand;
+			}
+			break;
+		case Instruction::chop:
+			h = Chop;
+			break;
+		case Instruction::frame:
+			h = Frame;
+			break;
+		}
+		t.handler = handlers[h];
+	}
+	m_code[end].handler = handlers[Restart];
+	m_code[end].operand = m_code[end].extra = 0;
+
+	if (m_tier == registers) {
+		m_plain = m_code;
+		RegisterCode registerCode;
+		translate(*m_image, registerCode);
+		lower(registerCode, handlers);
+	}
+	if (m_tier == native && m_jit.compile(*m_image)) {
+		// as for Segments
+		m_plain = m_code;
+		for (std::size_t b = 0; b < m_jit.blocks().size(); ++b) {
+			Threaded& t = m_code[m_jit.blocks()[b].start];
+			t.handler = handlers[Native];
+			t.operand = static_cast<Word>(b);
+			t.extra = 0;
+		}
+	}
+}
+
+void Cpu::lower(const RegisterCode& code, const std::intptr_t* handlers) {
+	typedef RegisterCode::Register Register;
+	typedef RegisterCode::Operation Operation;
+
+	// constants and temporaries past the slack, with the constants' values
+	const Word temporaries = registerFile + static_cast<Word>(code.constants.size());
+	m_stack.resize(temporaries + RegisterCode::maxTemporaries, 0);
+	std::copy(code.constants.begin(), code.constants.end(), m_stack.begin() + registerFile);
+	const Word banks[] = { 0, 0, registerFile, temporaries };
+
+	m_steps.clear();
+	for (std::size_t s = 0; s < code.segments.size(); ++s) {
+		const RegisterCode::Segment& segment = code.segments[s];
+		// the first instruction stands for the whole Segment, and falls
+		// back on itself when the Segment cannot be taken
+		Threaded& t = m_code[segment.start];
+		t.handler = handlers[Segment];
+		t.operand = static_cast<Word>(m_steps.size());
+		t.extra = 0;
+
+		Step step = { 0, 0, segment.cost - 1, segment.reach, 0 };
+		m_steps.push_back(step);
+		for (int j = 0; j < segment.inputCount; ++j) {
+			const Register& r = code.registers[segment.inputs + j];
+			const Step pop = { handlers[Pop], banks[r.bank] + r.index, 0, 0, 0 };
+			m_steps.push_back(pop);
+		}
+		Word exit = segment.exit;
+		const Operation* branch = 0;
+		for (int o = 0; o < segment.count; ++o) {
+			const Operation& op = code.operations[segment.first + o];
+			if (op.kind == Operation::jump) {
+				exit = op.target;
+				continue;
+			}
+			if (op.kind >= Operation::branch) {
+				branch = &op; // always the last
+				continue;
+			}
+			step.handler = handlers[ComputeAssign + 2 * (op.kind - Operation::compute)];
+			step.dst = banks[op.dst.bank] + op.dst.index;
+			step.a = banks[op.a.bank] + op.a.index;
+			step.b = banks[op.b.bank] + op.b.index;
+			step.local = static_cast<std::uint8_t>((op.dst.bank == Register::local) |
+			                                       (op.a.bank == Register::local) << 1 |
+			                                       (op.b.bank == Register::local) << 2);
+			m_steps.push_back(step);
+		}
+		for (int j = 0; j < segment.outputCount; ++j) {
+			const Register& r = code.registers[segment.outputs + j];
+			const Step push = { handlers[Push], 0, banks[r.bank] + r.index, 0,
+			                    static_cast<std::uint8_t>((r.bank == Register::local) << 1) };
+			m_steps.push_back(push);
+		}
+		if (branch) {
+			const Operation& op = *branch;
+			step.handler = handlers[UnlessAssign + 2 * (op.kind - Operation::branch)];
+			step.dst = op.target;
+			step.a = banks[op.a.bank] + op.a.index;
+			step.b = banks[op.b.bank] + op.b.index;
+			step.local = static_cast<std::uint8_t>((op.a.bank == Register::local) << 1 |
+			                                       (op.b.bank == Register::local) << 2);
+			m_steps.push_back(step);
+		}
+		const Step leave = { handlers[Goto], exit, 0, 0, 0 };
+		m_steps.push_back(leave);
+	}
+}
+
+void Cpu::enterMain(const bool clear) {
+	const int externals = m_image->externals;
+	std::fill(m_stack.begin() + (clear ? 0 : externals), m_stack.begin() + registerFile, 0);
+
+	const int end = static_cast<int>(m_image->code.size());
+	const bool hasMain = m_image->main >= 0 && m_image->main < static_cast<int>(m_image->links.size());
+	const Link* const main = hasMain ? &m_image->links[m_image->main] : 0;
+	const bool runnable = main && main->entry >= 0 && main->entry < end &&
+	                      main->locals >= 0 && main->locals <= maxVariables;
+
+	// as if main() had been called by a FRAME and FCALL just past the
+	// externals, from the end of the code
+	m_csp = stackSize;
+	m_stack[--m_csp] = externals;
+	m_stack[--m_csp] = end;
+	m_stack[--m_csp] = externals + 1;
+	m_mark = externals + 1;
+	m_sp = m_mark + (runnable ? main->locals : 0);
+	m_tos = 0;
+	m_pc = runnable ? main->entry : end;
+}
+
+void Cpu::runCompiled(long cycles) {
+	Module::Machine machine;
+	machine.stack = m_stack.data();
+	machine.cycles = cycles;
+	machine.host = m_host;
+	machine.random = &m_random;
+	machine.intrinsics = intrinsics;
+	for (;;) {
+		machine.pc = m_pc;
+		machine.sp = m_sp;
+		machine.csp = m_csp;
+		machine.mark = m_mark;
+		machine.tos = m_tos;
+		const int status = m_module->run()(&machine);
+		if (status == Module::stopped)
+			break;
+		if (status == Module::overflow)
+			++m_overflows;
+		enterMain(status == Module::overflow);
+	}
+	m_pc = machine.pc;
+	m_sp = machine.sp;
+	m_csp = machine.csp;
+	m_mark = machine.mark;
+	m_tos = machine.tos;
+}
+
+void Cpu::run(long cycles) {
+	if (cycles <= 0)
+		return;
+	m_cycles += cycles;
+	if (m_module) {
+		runCompiled(cycles);
+		return;
+	}
+
+#if JBOTS_THREADED
+#define JBOTS_CPU_LABEL(name) reinterpret_cast<std::intptr_t>(&&name##_),
+#define JBOTS_CPU_STEP_LABEL(name, op) JBOTS_CPU_LABEL(Compute##name) JBOTS_CPU_LABEL(Unless##name)
+	if (m_code.empty()) {
+		const std::intptr_t labels[handlers] = {
+			JBOTS_CPU_HANDLERS(JBOTS_CPU_LABEL) JBOTS_CPU_OPERATORS(JBOTS_CPU_STEP_LABEL)
+		};
+		thread(labels);
+	}
+#undef JBOTS_CPU_STEP_LABEL
+#undef JBOTS_CPU_LABEL
+#define CASE(name) name##_:
+#define DISPATCH goto *reinterpret_cast<void*>(i->handler)
+#define STEP \
+	do { \
+		++o; \
+		goto *reinterpret_cast<void*>(o->handler); \
+	} while (0)
+#define NEXT \
+	do { \
+		if (--cycles < 0) \
+			goto stop; \
+		i = pc++; \
+		DISPATCH; \
+	} while (0)
+#else
+	if (m_code.empty()) {
+		std::intptr_t numbers[handlers];
+		for (int h = 0; h < handlers; ++h)
+			numbers[h] = h;
+		thread(numbers);
+	}
+#define CASE(name) case name:
+#define DISPATCH goto dispatch
+#define STEP \
+	do { \
+		++o; \
+		goto steps; \
+	} while (0)
+#define NEXT continue
+#endif
+
+// The top of the stack is in tos, and the rest below sp.
+#define PUSH(value) \
+	do { \
+		if (sp + 1 >= csp) \
+			goto overflow; \
+		*sp++ = tos; \
+		tos = (value); \
+	} while (0)
+
+#define LOAD() \
+	do { \
+		pc = code + m_pc; \
+		sp = base + m_sp; \
+		csp = base + m_csp; \
+		mark = base + m_mark; \
+		tos = m_tos; \
+	} while (0)
+
+	const Threaded* const code = m_code.data();
+	Word* const base = m_stack.data();
+	const Threaded* pc;
+	const Threaded* i;
+	const Step* o = 0;             // in a Segment
+	Word* sp;
+	Word* csp;
+	Word* mark;
+	Word tos;
+	LOAD();
+
+#if JBOTS_THREADED
+	NEXT;
+#else
+	for (;;) {
+		if (--cycles < 0)
+			goto stop;
+		i = pc++;
+dispatch:
+		switch (i->handler) {
+#endif
+
+	CASE(Nop)
+		NEXT;
+	CASE(FetchLocal)
+		PUSH(mark[i->operand]);
+		NEXT;
+	CASE(FetchExternal)
+		PUSH(base[i->operand]);
+		NEXT;
+	CASE(StoreLocal)
+		mark[i->operand] = tos;
+		NEXT;
+	CASE(StoreExternal)
+		base[i->operand] = tos;
+		NEXT;
+	CASE(UpdateLocal)
+		tos = mark[i->operand] = binary(i->extra, mark[i->operand], tos);
+		NEXT;
+	CASE(UpdateExternal)
+		tos = base[i->operand] = binary(i->extra, base[i->operand], tos);
+		NEXT;
+	CASE(Constant)
+		PUSH(i->operand);
+		NEXT;
+
+#define JBOTS_CPU_BINARY(name, op) \
+	CASE(name) \
+		tos = binary<Instruction::op>(*--sp, tos); \
+		NEXT;
+	JBOTS_CPU_BINARY(Add, add)
+	JBOTS_CPU_BINARY(Sub, sub)
+	JBOTS_CPU_BINARY(Mul, mul)
+	JBOTS_CPU_BINARY(Div, div)
+	JBOTS_CPU_BINARY(Mod, mod)
+	JBOTS_CPU_BINARY(Shl, shl)
+	JBOTS_CPU_BINARY(Shr, shr)
+	JBOTS_CPU_BINARY(Band, band)
+	JBOTS_CPU_BINARY(Bor, bor)
+	JBOTS_CPU_BINARY(Bxor, bxor)
+	JBOTS_CPU_BINARY(Land, land)
+	JBOTS_CPU_BINARY(Lor, lor)
+	JBOTS_CPU_BINARY(Lt, lt)
+	JBOTS_CPU_BINARY(Le, le)
+	JBOTS_CPU_BINARY(Eq, eq)
+	JBOTS_CPU_BINARY(Ne, ne)
+	JBOTS_CPU_BINARY(Ge, ge)
+	JBOTS_CPU_BINARY(Gt, gt)
+#undef JBOTS_CPU_BINARY
+
+	CASE(Call) {
+		// the arguments, pushed since the FRAME, become the first locals
+		*sp = tos;
+		Word* const args = base + *csp + 1;
+		Word* const top = args + i->extra;
+		if (top + 2 >= csp)
+			goto overflow;
+		for (Word* p = sp + 1; p < top; ++p)
+			*p = 0;
+		*--csp = static_cast<Word>(pc - code);
+		*--csp = static_cast<Word>(mark - base);
+		mark = args;
+		sp = top;
+		pc = code + i->operand;
+		NEXT;
+	}
+	CASE(CallIntrinsic) {
+		*sp = tos;
+		Word* const args = base + *csp++ + 1;
+		const Intrinsic& f = intrinsics[i->operand];
+		Word padded[2] = { 0, 0 }; // for arguments that were not pushed
+		const Word* argv = args;
+		if (sp + 1 - args < f.arity) {
+			for (Word* p = args; p <= sp; ++p)
+				padded[p - args] = *p;
+			argv = padded;
+		}
+		tos = f.call(m_host, m_random, argv);
+		sp = args;
+		NEXT;
+	}
+	CASE(Return) {
+		mark = base + *csp++;
+		pc = code + *csp++;
+		sp = base + *csp++ + 1;
+		NEXT;
+	}
+	CASE(Branch) {
+		const Word condition = tos;
+		tos = *--sp;
+		if (!condition)
+			pc = code + i->operand;
+		NEXT;
+	}
+	CASE(Chop)
+		tos = *--sp;
+		NEXT;
+	CASE(Frame)
+		if (csp - 1 <= sp)
+			goto overflow;
+		*--csp = static_cast<Word>(sp - base);
+		NEXT;
+	CASE(Restart)
+		enterMain(false);
+		LOAD();
+		NEXT;
+
+	CASE(Segment)
+		o = m_steps.data() + i->operand;
+		if (cycles < o->a || sp + o->b >= csp) {
+			// the stack code would stop or overflow part way through
+			i = m_plain.data() + (i - code);
+			DISPATCH;
+		}
+		cycles -= o->a;
+		STEP;
+
+	CASE(Native) {
+		const Jit::Block& block = m_jit.blocks()[i->operand];
+		if (cycles < block.cost - 1 || sp + block.reach >= csp) {
+			i = m_plain.data() + (i - code);
+			DISPATCH;
+		}
+		Jit::Machine& machine = m_machine;
+		machine.sp = sp;
+		machine.csp = csp;
+		machine.mark = mark;
+		machine.base = base;
+		machine.cycles = cycles + 1; // the block takes its own
+		machine.host = m_host;
+		machine.random = &m_random;
+		machine.tos = tos;
+		pc = code + block.entry(&machine);
+		sp = machine.sp;
+		csp = machine.csp;
+		tos = machine.tos;
+		cycles = static_cast<long>(machine.cycles);
+		NEXT;
+	}
+
+#if !JBOTS_THREADED
+		}
+		continue;
+steps:
+		switch (o->handler) {
+#endif
+
+// An operand of the step o.
+#define AT(field, bit) ((o->local & (bit)) ? mark : base)[o->field]
+
+	CASE(Pop)
+		base[o->dst] = tos;
+		tos = *--sp;
+		STEP;
+	CASE(Push)
+		*sp++ = tos;
+		tos = AT(a, 2);
+		STEP;
+	CASE(Goto)
+		pc = code + o->dst;
+		NEXT;
+
+#define JBOTS_CPU_STEP(name, op) \
+	CASE(Compute##name) \
+		AT(dst, 1) = binary<Instruction::op>(AT(a, 2), AT(b, 4)); \
+		STEP; \
+	CASE(Unless##name) \
+		if (!binary<Instruction::op>(AT(a, 2), AT(b, 4))) { \
+			pc = code + o->dst; \
+			NEXT; \
+		} \
+		STEP;
+	JBOTS_CPU_OPERATORS(JBOTS_CPU_STEP)
+#undef JBOTS_CPU_STEP
+#undef AT
+
+#if !JBOTS_THREADED
+		}
+		continue;
+#endif
+
+overflow:
+		++m_overflows;
+		enterMain(true);
+		LOAD();
+		NEXT;
+
+#if !JBOTS_THREADED
+	}
+#endif
+
+stop:
+	m_pc = static_cast<int>(pc - code);
+	m_sp = static_cast<int>(sp - base);
+	m_csp = static_cast<int>(csp - base);
+	m_mark = static_cast<int>(mark - base);
+	m_tos = tos;
+
+#undef CASE
+#undef DISPATCH
+#undef STEP
+#undef NEXT
+#undef PUSH
+#undef LOAD
+}
+
+} // namespace Vm
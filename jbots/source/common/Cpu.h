@@ -0,0 +1,118 @@
+// Cpu.h
+// The CROBOTS robot CPU, as a direct-threaded interpreter.
+
+#ifndef Cpu_h__
+#define Cpu_h__
+
+#include <cstdint>
+#include <vector>
+
+#include "Aot.h"
+#include "Bytecode.h"
+#include "Jit.h"
+#include "Registers.h"
+
+namespace Vm {
+
+////////////////////////////////////////////////////////////
+//
+// class Cpu
+//
+// Runs one robot's Image.  The image is translated once into threaded
+// code, each instruction carrying the address of its handler, so that
+// dispatch is one indirect jump (GCC and Clang's computed goto; other
+// compilers get a switch).  FETCH and STORE are split by external and
+// local, and BINOP by operator, so that handlers do not decode operands.
+// The top of the stack is cached in a register.
+//
+// The stack is laid out as the CROBOTS documentation describes: externals
+// at the bottom, then each call's locals and temporaries growing upward,
+// and three words of call/return information per call growing down from
+// the top.  If the two meet, the stack is zeroed and main() called again.
+// main() is also called again if it returns, with the externals kept.
+//
+// Every instruction executed, including the return to the top of main(),
+// is one cycle.
+//
+// The registers tier also translates the image into RegisterCode, and runs
+// each Segment's operations in place of its stack instructions, with one
+// dispatch per operation.  The native tier runs basic blocks compiled by
+// the Jit instead, where the Jit is available(); elsewhere it is the stack
+// tier.  The compiled tier hands the whole run to a Module, translated
+// ahead of time, coming back only to enter main() again; without one it
+// is the stack tier too.  Every tier executes the same cycles with the
+// same results, so a robot plays the same match whichever it runs on.
+
+class Cpu {
+public:
+	enum Tier { stack, registers, native, compiled };
+
+private:
+	struct Threaded {
+		std::intptr_t handler;     // a label's address, or a handler number
+		Word operand;
+		Word extra;                // STORE's operator, a call's locals
+	};
+
+	// The registers tier's code: each Segment is a header, with the cycles
+	// and the reach it needs, then steps, each carrying a handler like a
+	// Threaded instruction.  Operands are offsets into the stack, from the
+	// bottom or, where 'local' says so, from the mark.
+	struct Step {
+		std::intptr_t handler;
+		Word dst, a, b;            // or the header's cycles and reach
+		std::uint8_t local;        // 1, 2 and 4 for dst, a and b
+	};
+
+	const Image* m_image;
+	Host* m_host;
+	Tier m_tier;
+	std::vector<Threaded> m_code;  // the image's, then a Restart
+	std::vector<Threaded> m_plain; // the same without Segments or blocks
+	std::vector<Step> m_steps;
+	Jit m_jit;
+	Jit::Machine m_machine;
+	const Module* m_module;        // the compiled tier's
+	std::vector<Word> m_stack;
+	int m_pc;
+	int m_sp;                      // where the top of the stack would spill
+	int m_csp;                     // the last call/return word
+	int m_mark;                    // the local variable mark
+	Word m_tos;
+	std::uint32_t m_random;
+	long long m_cycles;
+	long m_overflows;
+
+	void thread(const std::intptr_t* handlers);
+	void lower(const RegisterCode& code, const std::intptr_t* handlers);
+	void enterMain(const bool clear);
+	void runCompiled(long cycles);
+
+public:
+	// Creators
+	// Ready to start main() with a zeroed stack.  'host' may be 0.
+	Cpu(const Image& image, Host* host = 0, const std::uint32_t seed = 1, const Tier tier = stack);
+	// On the compiled tier, running 'module', which must be loaded for
+	// 'image' and outlive the Cpu.
+	Cpu(const Image& image, const Module& module, Host* host = 0, const std::uint32_t seed = 1);
+
+	// Accessors
+	const Image& image() const { return *m_image; }
+	Host* host() const { return m_host; }
+	Tier tier() const { return m_tier; }
+	long long cycles() const { return m_cycles; }  // since construction
+	long overflows() const { return m_overflows; }
+	Word external(const int offset) const { return m_stack[offset]; }
+	std::uint32_t random() const { return m_random; }
+
+	// Modifiers
+	void setHost(Host* host) { m_host = host; }
+	void reset();                  // zeroes the stack and restarts main()
+
+	// Executes exactly 'cycles' instructions.
+	void run(long cycles);
+};
+
+} // namespace Vm
+
+#endif // Cpu_h__
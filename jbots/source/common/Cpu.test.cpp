@@ -0,0 +1,226 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <vector>
+
+#include "../Shared/Cpu.h"
+
+namespace {
+
+typedef Vm::Instruction I;
+
+// Builds an Image by hand, one instruction at a time.
+struct Assembler {
+	Vm::Image image;
+
+	Assembler(const int externals) { image.externals = externals; image.main = -1; }
+
+	int here() const { return static_cast<int>(image.code.size()); }
+	int emit(const int op, const Vm::Word operand = 0, const int binop = I::assign) {
+		const I in = { static_cast<std::uint8_t>(op), static_cast<std::uint8_t>(binop), operand };
+		image.code.push_back(in);
+		return here() - 1;
+	}
+	int function(const char* name, const int params, const int locals) {
+		const Vm::Link link = { name, here(), params, locals };
+		image.links.push_back(link);
+		const int index = static_cast<int>(image.links.size()) - 1;
+		if (std::string(name) == "main")
+			image.main = index;
+		return index;
+	}
+};
+
+// Records what a robot asked for.
+struct Recorder : Vm::Host {
+	std::vector<Vm::Word> calls;
+
+	Vm::Word scan(const Vm::Word degree, const Vm::Word resolution) {
+		calls.push_back(degree);
+		calls.push_back(resolution);
+		return degree == 90 ? 123 : 0;
+	}
+	Vm::Word cannon(const Vm::Word degree, const Vm::Word range) {
+		calls.push_back(-degree);
+		calls.push_back(range);
+		return 1;
+	}
+	void drive(const Vm::Word, const Vm::Word) {}
+	Vm::Word damage() { return 7; }
+	Vm::Word speed() { return 0; }
+	Vm::Word locX() { return 0; }
+	Vm::Word locY() { return 0; }
+};
+
+}
+
+SUITE(CpuTestSuite) {
+
+TEST(ArithmeticWrapsAndNeverTraps) {
+	CHECK_EQUAL(-2147483647 - 1, Vm::binary(I::add, 2147483647, 1));
+	CHECK_EQUAL(0, Vm::binary(I::div, 5, 0));
+	CHECK_EQUAL(0, Vm::binary(I::mod, 5, 0));
+	CHECK_EQUAL(-2147483647 - 1, Vm::binary(I::div, -2147483647 - 1, -1));
+	CHECK_EQUAL(-3, Vm::binary(I::div, -7, 2));
+	CHECK_EQUAL(-1, Vm::binary(I::mod, -7, 2));
+	CHECK_EQUAL(-4, Vm::binary(I::shr, -7, 1));
+	CHECK_EQUAL(1, Vm::binary(I::land, 3, -1));
+	CHECK_EQUAL(0, Vm::binary(I::lor, 0, 0));
+}
+
+TEST(CountsEveryInstruction) {
+	// x = 0; while (x < 10) x += 1;
+	Assembler a(1);
+	a.function("main", 0, 0);
+	const int top = a.here();
+	a.emit(I::fetch, 0 | Vm::external);
+	a.emit(I::constant, 10);
+	a.emit(I::binop, 0, I::lt);
+	const int exit = a.emit(I::branch);
+	a.emit(I::constant, 1);
+	a.emit(I::store, 0 | Vm::external, I::add);
+	a.emit(I::chop);
+	a.emit(I::constant, 0);
+	a.emit(I::branch, top);
+	a.image.code[exit].operand = a.here();
+	a.emit(I::constant, 0);
+	a.emit(I::retsub);
+
+	Vm::Cpu cpu(a.image);
+	cpu.run(9 * 9 + 5); // nine passes, and the tenth up to its STORE
+	CHECK_EQUAL(9, cpu.external(0));
+	cpu.run(1);
+	CHECK_EQUAL(10, cpu.external(0));
+	cpu.run(3 + 4 + 2);
+	CHECK_EQUAL(96LL, cpu.cycles());
+	CHECK_EQUAL(10, cpu.external(0));
+
+	// main() returns to the end of the code, and starts again from the top,
+	// with the externals kept
+	cpu.run(1 + 4);
+	CHECK_EQUAL(10, cpu.external(0));
+	CHECK_EQUAL(0, cpu.overflows());
+}
+
+TEST(CallsPassArgumentsAsLocals) {
+	// r = fact(10) - fact(0);
+	Assembler a(1);
+	a.function("main", 0, 0);
+	a.emit(I::frame);
+	a.emit(I::constant, 10);
+	a.emit(I::fcall, 1);
+	a.emit(I::frame);
+	a.emit(I::constant, 0);
+	a.emit(I::fcall, 1);
+	a.emit(I::binop, 0, I::sub);
+	a.emit(I::store, 0 | Vm::external);
+	a.emit(I::chop);
+	const int spin = a.here();
+	a.emit(I::constant, 0);
+	a.emit(I::branch, spin);
+
+	// fact(n) { if (n < 2) return 1; return n * fact(n - 1); }
+	a.function("fact", 1, 1);
+	a.emit(I::fetch, 0);
+	a.emit(I::constant, 2);
+	a.emit(I::binop, 0, I::lt);
+	const int skip = a.emit(I::branch);
+	a.emit(I::constant, 1);
+	a.emit(I::retsub);
+	a.image.code[skip].operand = a.here();
+	a.emit(I::fetch, 0);
+	a.emit(I::frame);
+	a.emit(I::fetch, 0);
+	a.emit(I::constant, 1);
+	a.emit(I::binop, 0, I::sub);
+	a.emit(I::fcall, 1);
+	a.emit(I::binop, 0, I::mul);
+	a.emit(I::retsub);
+
+	Vm::Cpu cpu(a.image);
+	cpu.run(1000);
+	CHECK_EQUAL(3628800 - 1, cpu.external(0));
+	CHECK_EQUAL(0, cpu.overflows());
+}
+
+TEST(IntrinsicsReachTheHost) {
+	// if ((r = scan(450, 3)) != 0) cannon(-90, r); d = damage() + sqrt(-50);
+	Assembler a(2);
+	a.function("main", 0, 1);
+	a.emit(I::frame);
+	a.emit(I::constant, 450);
+	a.emit(I::constant, 3);
+	a.emit(I::fcall, -1 - Vm::Intrinsic::scan);
+	a.emit(I::store, 0);
+	a.emit(I::constant, 0);
+	a.emit(I::binop, 0, I::ne);
+	const int skip = a.emit(I::branch);
+	a.emit(I::frame);
+	a.emit(I::constant, -90);
+	a.emit(I::fetch, 0);
+	a.emit(I::fcall, -1 - Vm::Intrinsic::cannon);
+	a.emit(I::chop);
+	a.image.code[skip].operand = a.here();
+	a.emit(I::frame);
+	a.emit(I::fcall, -1 - Vm::Intrinsic::damage);
+	a.emit(I::frame);
+	a.emit(I::constant, -50);
+	a.emit(I::fcall, -1 - Vm::Intrinsic::sqrt);
+	a.emit(I::binop, 0, I::add);
+	a.emit(I::store, 1 | Vm::external);
+	a.emit(I::chop);
+	const int spin = a.here();
+	a.emit(I::constant, 0);
+	a.emit(I::branch, spin);
+
+	Recorder host;
+	Vm::Cpu cpu(a.image, &host);
+	cpu.run(30);
+	CHECK_EQUAL(4u, host.calls.size());
+	CHECK_EQUAL(90, host.calls[0]);
+	CHECK_EQUAL(3, host.calls[1]);
+	CHECK_EQUAL(-270, host.calls[2]);
+	CHECK_EQUAL(123, host.calls[3]);
+	CHECK_EQUAL(7 + 7, cpu.external(1));
+}
+
+TEST(OverflowRestartsWithAZeroedStack) {
+	// x = 1; forever() { forever(); }
+	Assembler a(1);
+	a.function("main", 0, 0);
+	a.emit(I::constant, 1);
+	a.emit(I::store, 0 | Vm::external);
+	a.emit(I::chop);
+	a.emit(I::frame);
+	a.emit(I::fcall, 1);
+	a.function("forever", 0, 2);
+	a.emit(I::frame);
+	a.emit(I::fcall, 1);
+
+	Vm::Cpu cpu(a.image);
+	cpu.run(5);
+	CHECK_EQUAL(1, cpu.external(0));
+	// each call takes its three words, two locals and the spilled top
+	cpu.run(2 * (Vm::stackSize / 6));
+	CHECK_EQUAL(1, cpu.overflows());
+	CHECK_EQUAL(1, cpu.external(0));
+}
+
+TEST(BadInstructionsRestartMain) {
+	Assembler a(0);
+	a.function("main", 0, 0);
+	a.emit(I::branch, 5000);
+	a.emit(I::fcall, 77);
+	a.emit(I::fetch, 3 | Vm::external);
+	Vm::Cpu cpu(a.image);
+	cpu.run(100000);
+	CHECK_EQUAL(100000LL, cpu.cycles());
+
+	Vm::Image empty;
+	empty.externals = 0;
+	empty.main = -1;
+	Vm::Cpu idle(empty);
+	idle.run(10);
+	CHECK_EQUAL(10LL, idle.cycles());
+}
+
+}
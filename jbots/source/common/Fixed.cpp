@@ -0,0 +1,40 @@
+// Fixed.cpp
+// A 32-bit fixed-point number for deterministic, integer-only physics.
+
+#include "Fixed.h"
+
+namespace Geometry {
+
+////////////////////////////////////////////////////////////
+// class Fixed::Wide
+
+Fixed Fixed::Wide::sqrt() const {
+	if (m_raw <= 0)
+		return Fixed();
+	// Digit-by-digit square root.  The square root of a 32.32 number read as
+	// an integer is the 16.16 result read as an integer.
+	std::uint64_t rest = static_cast<std::uint64_t>(m_raw);
+	std::uint64_t result = 0;
+	std::uint64_t bit = std::uint64_t(1) << 62;
+	while (bit > rest)
+		bit >>= 2;
+	while (bit != 0) {
+		if (rest >= result + bit) {
+			rest -= result + bit;
+			result = (result >> 1) + bit;
+		} else {
+			result >>= 1;
+		}
+		bit >>= 2;
+	}
+	return Fixed::fromRaw(result > INT32_MAX ? INT32_MAX : static_cast<std::int32_t>(result));
+}
+
+////////////////////////////////////////////////////////////
+// class Fixed
+
+std::ostream& operator<<(std::ostream& os, const Fixed& a) {
+	return os << a.toDouble();
+}
+
+} // namespace Geometry
@@ -0,0 +1,130 @@
+// Fixed.h
+// A 32-bit fixed-point number for deterministic, integer-only physics.
+
+#ifndef Fixed_h__
+#define Fixed_h__
+
+#include <cstdint>
+#include <iostream>
+
+namespace Geometry {
+
+////////////////////////////////////////////////////////////
+//
+// class Fixed
+//
+// A signed 16.16 fixed-point number held in a 32-bit word, the word size of
+// the CROBOTS CPU.  All arithmetic is integer arithmetic, so the same inputs
+// give the same bits on every machine and compiler, which is what replays
+// need.  Products truncate toward negative infinity and quotients toward
+// zero; results out of range wrap, and division by zero saturates.
+// Conversion from double rounds to nearest and saturates.
+//
+// Fixed::Wide is a 32.32 number that holds an exact product of two Fixed
+// values, so squared distances across the whole arena neither overflow nor
+// lose precision.
+
+class Fixed {
+public:
+	class Wide;
+
+	static constexpr int fractionBits = 16;
+	static constexpr std::int32_t one = 1 << fractionBits;
+
+private:
+	std::int32_t m_raw;
+
+	struct RawTag {};
+	constexpr Fixed(const std::int32_t raw, RawTag) : m_raw(raw) {}
+
+	static constexpr std::int32_t wrap(const std::int64_t value) {
+		return static_cast<std::int32_t>(static_cast<std::uint32_t>(value));
+	}
+	static constexpr std::int32_t fromDouble(const double value) {
+		return !(value == value) ? 0 // NaN
+		     : value * one >= 2147483647.0 ? INT32_MAX
+		     : value * one <= -2147483648.0 ? INT32_MIN
+		     : value >= 0.0 ? static_cast<std::int32_t>(value * one + 0.5)
+		     : -static_cast<std::int32_t>(-value * one + 0.5);
+	}
+
+public:
+	// Creators
+	constexpr Fixed() : m_raw(0) {}
+	constexpr Fixed(const int value) : m_raw(wrap(static_cast<std::int64_t>(value) * one)) {}
+	constexpr Fixed(const double value) : m_raw(fromDouble(value)) {}
+	static constexpr Fixed fromRaw(const std::int32_t raw) { return Fixed(raw, RawTag()); }
+
+	// Accessors
+	constexpr std::int32_t raw() const { return m_raw; }
+	constexpr double toDouble() const { return static_cast<double>(m_raw) / one; }
+
+	// Modifiers
+	constexpr Fixed& operator+=(const Fixed& b) { m_raw = wrap(static_cast<std::int64_t>(m_raw) + b.m_raw); return *this; }
+	constexpr Fixed& operator-=(const Fixed& b) { m_raw = wrap(static_cast<std::int64_t>(m_raw) - b.m_raw); return *this; }
+	constexpr Fixed& operator*=(const Fixed& b) {
+		m_raw = wrap((static_cast<std::int64_t>(m_raw) * b.m_raw) >> fractionBits);
+		return *this;
+	}
+	constexpr Fixed& operator/=(const Fixed& b) {
+		m_raw = b.m_raw != 0 ? wrap(static_cast<std::int64_t>(m_raw) * one / b.m_raw)
+		      : m_raw >= 0 ? INT32_MAX : INT32_MIN;
+		return *this;
+	}
+
+	friend constexpr Fixed operator+(Fixed a, const Fixed& b) { return a += b; }
+	friend constexpr Fixed operator-(Fixed a, const Fixed& b) { return a -= b; }
+	friend constexpr Fixed operator*(Fixed a, const Fixed& b) { return a *= b; }
+	friend constexpr Fixed operator/(Fixed a, const Fixed& b) { return a /= b; }
+	friend constexpr Fixed operator-(const Fixed& a) { return fromRaw(wrap(-static_cast<std::int64_t>(a.m_raw))); }
+	friend constexpr bool operator==(const Fixed& a, const Fixed& b) { return a.m_raw == b.m_raw; }
+	friend constexpr bool operator!=(const Fixed& a, const Fixed& b) { return a.m_raw != b.m_raw; }
+	friend constexpr bool operator<(const Fixed& a, const Fixed& b) { return a.m_raw < b.m_raw; }
+	friend constexpr bool operator>(const Fixed& a, const Fixed& b) { return a.m_raw > b.m_raw; }
+	friend constexpr bool operator<=(const Fixed& a, const Fixed& b) { return a.m_raw <= b.m_raw; }
+	friend constexpr bool operator>=(const Fixed& a, const Fixed& b) { return a.m_raw >= b.m_raw; }
+};
+
+class Fixed::Wide {
+private:
+	std::int64_t m_raw; // 32.32
+
+	static constexpr std::int64_t wrap(const std::uint64_t value) {
+		return static_cast<std::int64_t>(value);
+	}
+
+public:
+	// Creators
+	constexpr Wide() : m_raw(0) {}
+	constexpr Wide(const Fixed& value) : m_raw(static_cast<std::int64_t>(value.raw()) * Fixed::one) {}
+	static constexpr Wide fromRaw(const std::int64_t raw) { Wide w; w.m_raw = raw; return w; }
+
+	// The exact product of two Fixed values.
+	static constexpr Wide product(const Fixed& a, const Fixed& b) {
+		return fromRaw(static_cast<std::int64_t>(a.raw()) * b.raw());
+	}
+
+	// Accessors
+	constexpr std::int64_t raw() const { return m_raw; }
+	constexpr double toDouble() const { return static_cast<double>(m_raw) / (static_cast<double>(Fixed::one) * Fixed::one); }
+	Fixed sqrt() const; // truncated; zero if negative, saturates beyond Fixed
+
+	// Modifiers
+	constexpr Wide& operator+=(const Wide& b) { m_raw = wrap(static_cast<std::uint64_t>(m_raw) + static_cast<std::uint64_t>(b.m_raw)); return *this; }
+	constexpr Wide& operator-=(const Wide& b) { m_raw = wrap(static_cast<std::uint64_t>(m_raw) - static_cast<std::uint64_t>(b.m_raw)); return *this; }
+
+	friend constexpr Wide operator+(Wide a, const Wide& b) { return a += b; }
+	friend constexpr Wide operator-(Wide a, const Wide& b) { return a -= b; }
+	friend constexpr bool operator==(const Wide& a, const Wide& b) { return a.m_raw == b.m_raw; }
+	friend constexpr bool operator!=(const Wide& a, const Wide& b) { return a.m_raw != b.m_raw; }
+	friend constexpr bool operator<(const Wide& a, const Wide& b) { return a.m_raw < b.m_raw; }
+	friend constexpr bool operator>(const Wide& a, const Wide& b) { return a.m_raw > b.m_raw; }
+	friend constexpr bool operator<=(const Wide& a, const Wide& b) { return a.m_raw <= b.m_raw; }
+	friend constexpr bool operator>=(const Wide& a, const Wide& b) { return a.m_raw >= b.m_raw; }
+};
+
+std::ostream& operator<<(std::ostream& os, const Fixed& a);
+
+} // namespace Geometry
+
+#endif // Fixed_h__
@@ -0,0 +1,60 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <type_traits>
+
+#include "../Shared/Fixed.h"
+
+static_assert(std::is_trivially_copyable<Geometry::Fixed>::value, "Fixed must be trivially copyable");
+static_assert(sizeof(Geometry::Fixed) == 4, "Fixed must fit the 32-bit CROBOTS word");
+static_assert(Geometry::Fixed(1.5) * Geometry::Fixed(2) == Geometry::Fixed(3), "Fixed must be constexpr");
+
+SUITE(FixedTestSuite) {
+
+TEST(FixedConversion) {
+	CHECK_EQUAL(0, Geometry::Fixed().raw());
+	CHECK_EQUAL(65536, Geometry::Fixed(1).raw());
+	CHECK_EQUAL(-98304, Geometry::Fixed(-1.5).raw());
+	CHECK_EQUAL(1, Geometry::Fixed(1.0 / 65536).raw());
+	CHECK_EQUAL(1, Geometry::Fixed(0.6 / 65536).raw());   // rounds to nearest
+	CHECK_EQUAL(-1, Geometry::Fixed(-0.6 / 65536).raw());
+	CHECK_EQUAL(INT32_MAX, Geometry::Fixed(1e9).raw());   // saturates
+	CHECK_EQUAL(INT32_MIN, Geometry::Fixed(-1e9).raw());
+	CHECK_EQUAL(0, Geometry::Fixed(0.0 / 0.0).raw());
+	CHECK_EQUAL(123.25, Geometry::Fixed(123.25).toDouble());
+}
+
+TEST(FixedArithmetic) {
+	using Geometry::Fixed;
+	CHECK(Fixed(1.25) + Fixed(2.5) == Fixed(3.75));
+	CHECK(Fixed(1.25) - Fixed(2.5) == Fixed(-1.25));
+	CHECK(Fixed(-3) * Fixed(0.5) == Fixed(-1.5));
+	CHECK(Fixed(7) / Fixed(2) == Fixed(3.5));
+	CHECK(-Fixed(2) == Fixed(-2));
+	CHECK(Fixed(1) < Fixed(2));
+	CHECK(Fixed(-1) <= Fixed(-1));
+
+	// products floor, quotients truncate toward zero
+	CHECK_EQUAL(-1, (Fixed::fromRaw(-1) * Fixed(0.5)).raw());
+	CHECK_EQUAL(0, (Fixed::fromRaw(-1) / Fixed(2)).raw());
+
+	// overflow wraps rather than being undefined; division by zero saturates
+	CHECK_EQUAL(INT32_MIN, (Fixed::fromRaw(INT32_MAX) + Fixed::fromRaw(1)).raw());
+	CHECK_EQUAL(INT32_MAX, (Fixed(1) / Fixed()).raw());
+	CHECK_EQUAL(INT32_MIN, (Fixed(-1) / Fixed()).raw());
+}
+
+TEST(FixedWide) {
+	using Geometry::Fixed;
+	// squares across the arena diagonal do not overflow
+	const Fixed::Wide d2 = Fixed::Wide::product(Fixed(1000), Fixed(1000))
+	                     + Fixed::Wide::product(Fixed(1000), Fixed(1000));
+	CHECK_EQUAL(2000000.0, d2.toDouble());
+	CHECK(Fixed::Wide(Fixed(3)) < d2);
+	CHECK_CLOSE(1414.2135624, d2.sqrt().toDouble(), 1.0 / 65536);
+	CHECK(Fixed::Wide::product(Fixed(5), Fixed(5)).sqrt() == Fixed(5));
+	CHECK(Fixed::Wide::product(Fixed(0.5), Fixed(0.5)).sqrt() == Fixed(0.5));
+	CHECK(Fixed::Wide(Fixed(-4)).sqrt() == Fixed());
+	CHECK(Fixed::Wide::fromRaw(INT64_MAX).sqrt() == Fixed::fromRaw(INT32_MAX));
+}
+
+} // suite
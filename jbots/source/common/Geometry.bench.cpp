@@ -0,0 +1,275 @@
+// Geometry.bench.cpp
+// Throughput of the Geometry primitives, per call and per batch, at several
+// entity counts and for each scalar policy.  Built as the jbots-bench
+// target, or on its own, run from this directory:
+//   mkdir -p /tmp/jbots/include && ln -sfn "$PWD" /tmp/jbots/Shared
+//   c++ -std=c++20 -O2 -I/tmp/jbots/include Geometry.bench.cpp Geometry.cpp Proximity.cpp Simd.cpp SpatialGrid.cpp Trig.cpp Fixed.cpp -o geometry-bench
+// The sources include "../Shared/X.h", which the first line makes resolve
+// from /tmp/jbots/include to this directory.
+//
+// Usage: geometry-bench [--json] [name...]
+// Names select benchmarks by prefix.  --json writes one JSON object per
+// line instead of the table, for comparing runs with a script.  Cycles are
+// read from the time stamp counter where there is one, which ticks at the
+// nominal clock rate rather than the current one; elsewhere they are 0.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "../Shared/Geometry.h"
+#include "../Shared/Proximity.h"
+#include "../Shared/SpatialGrid.h"
+
+namespace {
+
+const std::size_t counts[] = { 10, 1000, 100000 };
+
+// Each measurement runs about this many operations in total.
+const std::size_t operationsPerRun = 20000000;
+
+// Keeps the optimizer from discarding the measured work.
+volatile double sink;
+
+inline unsigned long long cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// Reads any scalar, or any product of scalars, as a double.
+inline double value(const double v) { return v; }
+inline double value(const float v) { return v; }
+inline double value(const Geometry::Fixed& v) { return v.toDouble(); }
+inline double value(const Geometry::Fixed::Wide& v) { return v.toDouble(); }
+
+template <typename S> const char* scalarName();
+template <> const char* scalarName<double>() { return "double"; }
+template <> const char* scalarName<float>() { return "float"; }
+template <> const char* scalarName<Geometry::Fixed>() { return "fixed"; }
+
+////////////////////////////////////////////////////////////
+// Reporting
+
+class Report {
+private:
+	bool m_json;
+	std::vector<const char*> m_filters;
+
+public:
+	Report(const int argc, char const** argv) : m_json(false) {
+		for (int i = 1; i < argc; ++i) {
+			if (std::strcmp(argv[i], "--json") == 0)
+				m_json = true;
+			else
+				m_filters.push_back(argv[i]);
+		}
+		if (!m_json)
+			std::printf("%-24s %-7s %8s %12s %12s\n", "benchmark", "scalar", "count", "ns/op", "cycles/op");
+	}
+
+	bool wanted(const char* name) const {
+		if (m_filters.empty())
+			return true;
+		for (std::size_t i = 0; i < m_filters.size(); ++i)
+			if (std::strncmp(name, m_filters[i], std::strlen(m_filters[i])) == 0)
+				return true;
+		return false;
+	}
+
+	// Runs 'body', which performs 'count' operations per call, enough times
+	// to reach 'budget' operations, and prints the cost per operation.
+	template <typename Body>
+	void measure(const char* name, const char* scalar, const std::size_t count, Body body,
+	             const std::size_t budget = operationsPerRun) {
+		if (!wanted(name))
+			return;
+		const std::size_t runs = budget / count > 0 ? budget / count : 1;
+		body(); // warm up caches and the branch predictor
+		typedef std::chrono::steady_clock Clock;
+		double total = 0.0;
+		const Clock::time_point start = Clock::now();
+		const unsigned long long startCycles = cycles();
+		for (std::size_t r = 0; r < runs; ++r)
+			total += body();
+		const unsigned long long stopCycles = cycles();
+		const Clock::time_point stop = Clock::now();
+		sink = total;
+
+		const double operations = static_cast<double>(runs) * count;
+		const double ns = std::chrono::duration<double, std::nano>(stop - start).count() / operations;
+		const double cyc = static_cast<double>(stopCycles - startCycles) / operations;
+		if (m_json)
+			std::printf("{\"benchmark\":\"%s\",\"scalar\":\"%s\",\"count\":%zu,\"operations\":%.0f,"
+			            "\"ns_per_op\":%.4f,\"cycles_per_op\":%.4f}\n",
+			            name, scalar, count, operations, ns, cyc);
+		else
+			std::printf("%-24s %-7s %8zu %12.3f %12.3f\n", name, scalar, count, ns, cyc);
+		std::fflush(stdout);
+	}
+};
+
+////////////////////////////////////////////////////////////
+// Test data
+//
+// Points scattered over the arena by a fixed linear congruential
+// generator, so every run and every scalar sees the same inputs.
+
+class Scatter {
+private:
+	unsigned long m_state;
+public:
+	Scatter() : m_state(12345) {}
+	double next(const double limit) {
+		m_state = (m_state * 1103515245ul + 12345ul) & 0x7ffffffful;
+		return limit * m_state / 2147483648.0;
+	}
+};
+
+template <typename S>
+std::vector<Geometry::BasicPoint<S> > points(const std::size_t count) {
+	Scatter scatter;
+	std::vector<Geometry::BasicPoint<S> > result;
+	result.reserve(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		const double x = scatter.next(1000.0), y = scatter.next(1000.0);
+		result.push_back(Geometry::BasicPoint<S>(S(x), S(y)));
+	}
+	return result;
+}
+
+template <typename S>
+std::vector<Geometry::BasicEntity<S> > entities(const std::size_t count) {
+	Scatter scatter;
+	std::vector<Geometry::BasicEntity<S> > result;
+	result.reserve(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		const double x = scatter.next(1000.0), y = scatter.next(1000.0);
+		const double facing = scatter.next(Geometry::twopi);
+		result.push_back(Geometry::BasicEntity<S>(Geometry::BasicPoint<S>(S(x), S(y)),
+		                                          Geometry::BasicAngle<S>(S(facing)), S(1.0)));
+	}
+	return result;
+}
+
+////////////////////////////////////////////////////////////
+// Per-call benchmarks, one call per operation
+
+template <typename S>
+void perCall(Report& report, const std::size_t count) {
+	typedef Geometry::BasicPoint<S> Point;
+	typedef Geometry::BasicAngle<S> Angle;
+	const char* const scalar = scalarName<S>();
+	const std::vector<Point> from = points<S>(count);
+	std::vector<Point> to = points<S>(count + 1);
+	to.erase(to.begin()); // pair every point with a different one
+
+	report.measure("distance", scalar, count, [&]() {
+		double total = 0.0;
+		for (std::size_t i = 0; i < count; ++i)
+			total += value(Geometry::distance(from[i], to[i]));
+		return total;
+	});
+
+	report.measure("distanceSquared", scalar, count, [&]() {
+		double total = 0.0;
+		for (std::size_t i = 0; i < count; ++i)
+			total += value(Geometry::distanceSquared(from[i], to[i]));
+		return total;
+	});
+
+	report.measure("bearing", scalar, count, [&]() {
+		double total = 0.0;
+		for (std::size_t i = 0; i < count; ++i)
+			total += value(Geometry::bearing(from[i], to[i]).as_r());
+		return total;
+	});
+
+	std::vector<Angle> angles(count);
+	report.measure("Angle::normalize", scalar, count, [&]() {
+		for (std::size_t i = 0; i < count; ++i)
+			angles[i].set(from[i].x()).normalize(); // up to 1000 radians, ~160 turns
+		return value(angles[count - 1].as_r());
+	});
+
+	std::vector<Geometry::BasicEntity<S> > movers = entities<S>(count);
+	report.measure("Entity::move", scalar, count, [&]() {
+		for (std::size_t i = 0; i < count; ++i)
+			movers[i].move();
+		return value(movers[count - 1].position().x());
+	});
+
+	// Turning every tick defeats the velocity cache: the worst case of move().
+	report.measure("Entity::move+turn", scalar, count, [&]() {
+		for (std::size_t i = 0; i < count; ++i) {
+			movers[i].setFacing(Angle(movers[i].facing().as_r() + S(0.01)));
+			movers[i].move();
+		}
+		return value(movers[count - 1].position().x());
+	});
+}
+
+////////////////////////////////////////////////////////////
+// Batch benchmarks, one whole-array call per run
+
+void perBatch(Report& report, const std::size_t count) {
+	const std::vector<Geometry::Entity> source = entities<double>(count);
+	Geometry::EntityBatch batch(count);
+	for (std::size_t i = 0; i < count; ++i)
+		batch.add(source[i]);
+
+	report.measure("EntityBatch::moveAll", "double", count, [&]() {
+		batch.moveAll();
+		return batch.x()[count - 1];
+	});
+
+	std::vector<double> radians(count);
+	report.measure("bearings", "double", count, [&]() {
+		Geometry::bearings(500.0, 500.0, Geometry::points(batch), radians.data());
+		return radians[count - 1];
+	});
+
+	report.measure("normalizeAll", "double", count, [&]() {
+		for (std::size_t i = 0; i < count; ++i)
+			radians[i] = batch.x()[i];
+		Geometry::normalizeAll(radians.data(), count);
+		return radians[count - 1];
+	});
+
+	// What a cone query on the grid costs: every entity looks once, in its
+	// own facing, as wide as the widest CROBOTS scan.  Each query costs
+	// hundreds of times more than the operations above, so fewer are run.
+	Geometry::SpatialGrid grid;
+	grid.updateAll(Geometry::points(batch));
+	const Geometry::Angle halfWidth(Geometry::Angle::d2r(10.5));
+	report.measure("SpatialGrid::nearestInCone", "double", count, [&]() {
+		double total = 0.0;
+		for (std::size_t i = 0; i < count; ++i) {
+			double d2 = 0.0;
+			grid.nearestInCone(Geometry::Point(batch.x()[i], batch.y()[i]), batch.facing()[i],
+			                   halfWidth, 1500.0, i, &d2);
+			total += d2;
+		}
+		return total;
+	}, operationsPerRun / 100);
+}
+
+} // namespace
+
+int main(const int argc, char const** argv) {
+	Report report(argc, argv);
+	for (std::size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+		perCall<double>(report, counts[c]);
+		perCall<float>(report, counts[c]);
+		perCall<Geometry::Fixed>(report, counts[c]);
+		perBatch(report, counts[c]);
+	}
+	return 0;
+}
@@ -5,175 +5,271 @@
 
 #include "../Shared/Geometry.h"
 
-#include <cmath> // pow(), sqrt(), sin(), cos(), tan(), abs()
 #include <iostream>
 
+#include "Simd.h"
+#include "Trig.h"
+
 namespace Geometry {
 
-double distance(const Point& a, const Point& b) {
-	return sqrt( pow(a.x() - b.x(), 2)  + pow(a.y() - b.y(), 2) );
+template <typename S>
+S distance(const BasicPoint<S>& a, const BasicPoint<S>& b) {
+	return ScalarTraits<S>::sqrt(distanceSquared(a, b));
 }
 
-Angle& bearing(const Point& from, const Point& to, Angle& bearing) {
-	return bearing.set( tan( (to.y() - from.y()) / (to.x() - from.x()) ) );
+template <typename S>
+BasicAngle<S> bearing(const BasicPoint<S>& from, const BasicPoint<S>& to) {
+	return BasicAngle<S>(ScalarTraits<S>::direction(to.y() - from.y(), to.x() - from.x()));
 }
 
 ////////////////////////////////////////////////////////////
-// class Point
+// class BasicPoint
 
-bool Point::near(const Point& other, double epsilon) const {
-	if (epsilon < 0)
+template <typename S>
+bool BasicPoint<S>::near(const BasicPoint& other, S epsilon) const {
+	if (epsilon < S())
 		return false;
-	return sqrt( pow(x() - other.x(), 2) + pow(y() - other.y(), 2) ) < epsilon;
+	return distanceSquared(*this, other) < ScalarTraits<S>::multiply(epsilon, epsilon);
 }
 
-Point& Point::operator=(const Point& other) {
-	x(other.x());
-	y(other.y());
-	return *this;
+template <typename S>
+std::ostream& operator<<(std::ostream& os, const BasicPoint<S>& point) {
+	return os << '<' << point.x() << ',' << point.y() << '>';
 }
 
-Point& Point::operator+=(const Point& other) {
-	x(x() + other.x());
-	y(y() + other.y());
-	return *this;
+template <typename S>
+BasicPoint<S> rotate(const BasicPoint<S>& a, const typename NonDeduced<BasicAngle<S> >::Type& by) {
+	S s, c;
+	ScalarTraits<S>::sinCos(by.as_r(), s, c);
+	return BasicPoint<S>(a.x() * c - a.y() * s, a.x() * s + a.y() * c);
 }
 
-Point& Point::operator-=(const Point& other) {
-	x(x() - other.x());
-	y(y() - other.y());
-	return *this;
+////////////////////////////////////////////////////////////
+// class BasicAngle
+
+// clamp the value to +/- one orbit
+template <typename S>
+BasicAngle<S>& BasicAngle<S>::normalize() {
+	return set(ScalarTraits<S>::wrap(as_r()));
 }
 
-bool operator==(const Point& a, const Point& b) {
-	return a.x() == b.x() && a.y() == b.y();
+// is this angle within +/- epsilon of another angle?  epsilon must be > 0
+template <typename S>
+bool BasicAngle<S>::near(const BasicAngle& other, const BasicAngle& epsilon) const {
+	return near(other, epsilon.as_r());
 }
 
-bool operator!=(const Point& a, const Point& b) {
-	return !(a == b);
+// is this angle within +/- epsilon of another angle?  epsilon must be > 0
+template <typename S>
+bool BasicAngle<S>::near(const BasicAngle& other, const S epsilon) const {
+	const S difference = as_r() - other.as_r();
+	return (difference < S() ? -difference : difference) <= epsilon;
 }
 
-Point operator+(const Point& a, const Point& b) {
-	Point result(a);
-	result += b;
-	return result;
+template <typename S>
+std::ostream& operator<<(std::ostream& os, const BasicAngle<S>& angle) {
+	return os << angle.as_r() << 'r';
 }
 
-Point operator*(const Point& a, const double factor) {
-	Point result(a.x() * factor, a.y() * factor);
-	return result;
+void normalizeAll(Angle* angles, const std::size_t count) {
+	// through a block of plain radians at a time, for the kernel
+	const std::size_t block = 256;
+	double radians[block];
+	for (std::size_t first = 0; first < count; first += block) {
+		const std::size_t n = count - first < block ? count - first : block;
+		for (std::size_t i = 0; i < n; ++i)
+			radians[i] = angles[first + i].as_r();
+		kernels().normalize(radians, n);
+		for (std::size_t i = 0; i < n; ++i)
+			angles[first + i].set(radians[i]);
+	}
 }
 
-std::ostream& operator<<(std::ostream& os, const Point& point) {
-	return os << '<' << point.x() << ',' << point.y() << '>';
+void normalizeAll(double* radians, const std::size_t count) {
+	kernels().normalize(radians, count);
 }
 
 ////////////////////////////////////////////////////////////
-// class Angle
+// class BasicEntity
 
-double Angle::r2d(const double angle) { 
-	return angle * 360.0 / twopi;
+template <typename S>
+S BasicEntity<S>::setSpeed(const S speed) {
+	if (speed >= S()) {
+		m_speed = speed;
+		m_velocityCurrent = false;
+	}
+	return this->speed();
 }
 
-double Angle::d2r(const double angle) { 
-	return angle * twopi / 360.0;
-}
- 
-// Return the angle's value in radians
-double Angle::as_r() const {
-	return m_value;
+template <typename S>
+const BasicAngle<S>& BasicEntity<S>::setFacing(const Angle& facing) {
+	m_facing = facing;
+	m_facing.normalize();
+	m_velocityCurrent = false;
+	return this->facing();
 }
 
-// Return the angle's value in degrees
-double Angle::as_d() const {
-	return r2d(as_r());
+template <typename S>
+void BasicEntity<S>::updateVelocity() const {
+	S s, c;
+	ScalarTraits<S>::sinCos(facing().as_r(), s, c);
+	m_velocity = Point(speed() * c, speed() * s);
+	m_velocityCurrent = true;
 }
 
-// clamp the value to +/- one orbit
-Angle& Angle::normalize() {
-	// TODO: would modulo be more efficient and equally accurate?
-	while (as_r() >= twopi)  { set(as_r() - twopi); } 
-	while (as_r() <= -twopi) { set(as_r() + twopi); }
-	return *this;
-}
+////////////////////////////////////////////////////////////
+// class BasicDrive
 
-// is this angle within +/- epsilon of another angle?  epsilon must be > 0
-bool Angle::near(const Angle& other, const Angle& epsilon) const {
-	return near(other, epsilon.as_r());
+template <typename S>
+void BasicDrive<S>::set(const Angle& heading, const S speed) {
+	m_heading = heading;
+	m_heading.normalize();
+	m_speed = speed > S() ? speed : S();
 }
 
-// is this angle within +/- epsilon of another angle?  epsilon must be > 0
-bool Angle::near(const Angle& other, const double epsilon) const {
-	return abs(as_r() - other.as_r()) <= epsilon;
+////////////////////////////////////////////////////////////
+// Instantiations, one set per scalar policy
+
+#define INSTANTIATE_GEOMETRY(S) \
+	template class BasicPoint<S>; \
+	template class BasicAngle<S>; \
+	template class BasicEntity<S>; \
+	template class BasicDrive<S>; \
+	template S distance(const BasicPoint<S>&, const BasicPoint<S>&); \
+	template BasicAngle<S> bearing(const BasicPoint<S>&, const BasicPoint<S>&); \
+	template BasicPoint<S> rotate(const BasicPoint<S>&, const NonDeduced<BasicAngle<S> >::Type&); \
+	template std::ostream& operator<<(std::ostream&, const BasicPoint<S>&); \
+	template std::ostream& operator<<(std::ostream&, const BasicAngle<S>&);
+
+INSTANTIATE_GEOMETRY(double)
+INSTANTIATE_GEOMETRY(float)
+INSTANTIATE_GEOMETRY(Fixed)
+
+#undef INSTANTIATE_GEOMETRY
+
+////////////////////////////////////////////////////////////
+// class EntityBatch
+
+void EntityBatch::updateVelocity(Index i) {
+	double s, c;
+	fastSinCos(m_facing[i], s, c);
+	m_vx[i] = m_speed[i] * c;
+	m_vy[i] = m_speed[i] * s;
 }
 
-bool operator<(const Angle& a, const Angle& b) {
-	return a.as_r() < b.as_r();
+Entity EntityBatch::entity(Index i) const {
+	return Entity(Point(m_x[i], m_y[i]), Angle(m_facing[i]), m_speed[i]);
 }
 
-bool operator>(const Angle& a, const Angle& b) {
-	return a.as_r() > b.as_r();
+void EntityBatch::reserve(std::size_t capacity) {
+	m_x.reserve(capacity);
+	m_y.reserve(capacity);
+	m_facing.reserve(capacity);
+	m_speed.reserve(capacity);
+	m_vx.reserve(capacity);
+	m_vy.reserve(capacity);
 }
 
-bool operator<=(const Angle& a, const Angle& b) {
-	return a.as_r() <= b.as_r();
+void EntityBatch::clear() {
+	m_x.clear();
+	m_y.clear();
+	m_facing.clear();
+	m_speed.clear();
+	m_vx.clear();
+	m_vy.clear();
 }
 
-bool operator>=(const Angle& a, const Angle& b) {
-	return a.as_r() >= b.as_r();
+EntityBatch::Index EntityBatch::add(const Entity& entity) {
+	const Index i = size();
+	m_x.push_back(entity.position().x());
+	m_y.push_back(entity.position().y());
+	m_facing.push_back(entity.facing().as_r());
+	m_speed.push_back(entity.speed());
+	m_vx.push_back(0.0);
+	m_vy.push_back(0.0);
+	updateVelocity(i);
+	return i;
 }
 
-bool operator==(const Angle& a, const Angle& b) {
-	return a.as_r() == b.as_r();
+void EntityBatch::remove(Index i) {
+	const Index last = size() - 1;
+	if (i != last) {
+		m_x[i] = m_x[last];
+		m_y[i] = m_y[last];
+		m_facing[i] = m_facing[last];
+		m_speed[i] = m_speed[last];
+		m_vx[i] = m_vx[last];
+		m_vy[i] = m_vy[last];
+	}
+	m_x.pop_back();
+	m_y.pop_back();
+	m_facing.pop_back();
+	m_speed.pop_back();
+	m_vx.pop_back();
+	m_vy.pop_back();
 }
 
-bool operator!=(const Angle& a, const Angle& b) {
-	return a.as_r() != b.as_r();
+void EntityBatch::turnAll(const double* turns) {
+	const std::size_t n = size();
+	for (Index i = 0; i < n; ++i)
+		m_facing[i] += turns[i];
+	kernels().normalize(m_facing.data(), n);
+	for (Index i = 0; i < n; ++i)
+		updateVelocity(i);
 }
 
-std::ostream& operator<<(std::ostream& os, const Angle& angle) {
-	return os << angle.as_r() << 'r';
+void EntityBatch::moveAll() {
+	// Velocity is cached per entity, so this is two independent adds per
+	// element, run by the vectorized kernel for this machine.
+	kernels().move(m_x.data(), m_y.data(), m_vx.data(), m_vy.data(), size());
 }
 
 ////////////////////////////////////////////////////////////
-// class Point
+// class EntityBatch::Ref
 
-Entity::Entity() : m_speed(0.0) {}
+Point EntityBatch::Ref::position() const {
+	return Point(m_batch->m_x[m_index], m_batch->m_y[m_index]);
+}
 
-Entity::Entity(const Point& position, const Angle& facing, const double speed)
-	: m_position(position), m_facing(facing), m_speed(speed)
-{}
+Angle EntityBatch::Ref::facing() const {
+	return Angle(m_batch->m_facing[m_index]);
+}
 
-Entity::Entity(const Entity& other) 
-	: m_position(other.position()), m_facing(other.facing()), m_speed(other.speed())
-{}
+double EntityBatch::Ref::speed() const {
+	return m_batch->m_speed[m_index];
+}
 
-const Point& Entity::setPosition(const Point& position) {
-	m_position = position;
-	return this->position();
+Entity EntityBatch::Ref::entity() const {
+	return m_batch->entity(m_index);
 }
 
-const double Entity::setSpeed(const double speed) {
-	if (speed >= 0.0)
-		m_speed = speed;
+double EntityBatch::Ref::setSpeed(const double speed) {
+	if (speed >= 0.0) {
+		m_batch->m_speed[m_index] = speed;
+		m_batch->updateVelocity(m_index);
+	}
 	return this->speed();
 }
 
-const Angle& Entity::setFacing(const Angle& facing) {
-	m_facing = facing;
-	m_facing.normalize();
+Angle EntityBatch::Ref::setFacing(const Angle& facing) {
+	Angle a(facing);
+	m_batch->m_facing[m_index] = a.normalize().as_r();
+	m_batch->updateVelocity(m_index);
 	return this->facing();
 }
 
-void Entity::move() {
-	// Note that this method jumps the object to the new position.
-	// TODO: saving the last velocity vector would improve performance
-	const double r = facing().as_r();
-	Point velocity(speed() * cos(r), speed() * sin(r));
-	setPosition(position() + velocity);
+Point EntityBatch::Ref::setPosition(const Point& position) {
+	m_batch->m_x[m_index] = position.x();
+	m_batch->m_y[m_index] = position.y();
+	return this->position();
+}
+
+void EntityBatch::Ref::move() {
+	m_batch->m_x[m_index] += m_batch->m_vx[m_index];
+	m_batch->m_y[m_index] += m_batch->m_vy[m_index];
 }
 
-Entity& Entity::operator=(const Entity& other) {
+EntityBatch::Ref& EntityBatch::Ref::operator=(const Entity& other) {
 	setPosition(other.position());
 	setFacing(other.facing());
 	setSpeed(other.speed());
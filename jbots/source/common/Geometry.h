@@ -7,143 +7,394 @@
 #define Geometry_h__
 
 #include <iostream>
+#include <vector>
+
+#include "AlignedAllocator.h"
+#include "Scalar.h"
 
 namespace Geometry {
 
 // Forward declarations
-class Point;
-class Angle;
-class Entity;
+template <typename S> class BasicPoint;
+template <typename S> class BasicAngle;
+template <typename S> class BasicEntity;
+template <typename S> class BasicDrive;
+class EntityBatch;
 
-////////////////////////////////////////////////////////////
+// The geometry types are templated on a scalar policy; see Scalar.h.  The
+// engine uses the double instantiations below unless it asks otherwise.
+typedef BasicPoint<double> Point;
+typedef BasicAngle<double> Angle;
+typedef BasicEntity<double> Entity;
+typedef BasicDrive<double> Drive;
 
-// Useful constants
-const double pi    = 3.14159;
-const double twopi = 2 * pi;
+// Keeps a parameter out of template argument deduction, so that arguments
+// such as a plain double still convert to it.
+template <typename T> struct NonDeduced { typedef T Type; };
 
 ////////////////////////////////////////////////////////////
 
 // Computes the linear distance between the two specified points.  Returned
 // distances are non-negative.
-double distance(const Point& from, const Point& to);
+template <typename S>
+S distance(const BasicPoint<S>& from, const BasicPoint<S>& to);
+
+// Computes the square of the distance between the two points.  Cheaper than
+// distance(), and sufficient whenever distances are only being compared.
+template <typename S>
+constexpr typename ScalarTraits<S>::Wide distanceSquared(const BasicPoint<S>& from, const BasicPoint<S>& to);
 
 // Returns the angle of a line from 'from' to 'to'.  Returned angle is the 
 // smallest non-negative angle between 0 and the line between the two points.
-Angle& bearing(const Point& from, const Point& to);
+// The bearing from a point to itself is zero.
+template <typename S>
+BasicAngle<S> bearing(const BasicPoint<S>& from, const BasicPoint<S>& to);
 
 ////////////////////////////////////////////////////////////
 //
-// class Point
+// class BasicPoint
 //
-// Represents a point in 2D space.
+// Represents a point in 2D space, or a 2D vector.  A trivially copyable
+// value type: points can be memcpy'd, and everything but near() and
+// rotate() can be evaluated at compile time.
 
-class Point {
+template <typename S>
+class BasicPoint {
 private:
-	double m_x, m_y;
+	S m_x, m_y;
 public:
+	typedef S Scalar;
+	typedef typename ScalarTraits<S>::Wide Wide;
+
 	// Creators
-	Point() : m_x(0.0), m_y(0.0) {}
-	Point(double x, double y) : m_x(x), m_y(y) {}
-	Point(const Point& other) : m_x(other.x()), m_y(other.y()) {}
+	constexpr BasicPoint() : m_x(), m_y() {}
+	constexpr BasicPoint(S x, S y) : m_x(x), m_y(y) {}
 
 	// Accessors
-	double x() const { return m_x; }
-	double y() const { return m_y; }
-	bool near(const Point& other, double epsilon) const;
+	constexpr S x() const { return m_x; }
+	constexpr S y() const { return m_y; }
+	bool near(const BasicPoint& other, S epsilon) const;
 	
 	// Modifiers
-	void x(double x) { m_x = x; }
-	void y(double y) { m_y = y; }
-	Point& operator=(const Point& other);
-	Point& operator+=(const Point& other);
-	Point& operator-=(const Point& other);
+	constexpr void x(S x) { m_x = x; }
+	constexpr void y(S y) { m_y = y; }
+	constexpr BasicPoint& operator+=(const BasicPoint& other) { m_x += other.m_x; m_y += other.m_y; return *this; }
+	constexpr BasicPoint& operator-=(const BasicPoint& other) { m_x -= other.m_x; m_y -= other.m_y; return *this; }
+	constexpr BasicPoint& operator*=(const S factor) { m_x *= factor; m_y *= factor; return *this; }
+
+	friend constexpr BasicPoint operator+(const BasicPoint& a, const BasicPoint& b) { return BasicPoint(a.x() + b.x(), a.y() + b.y()); }
+	friend constexpr BasicPoint operator-(const BasicPoint& a, const BasicPoint& b) { return BasicPoint(a.x() - b.x(), a.y() - b.y()); }
+	friend constexpr BasicPoint operator-(const BasicPoint& a) { return BasicPoint(-a.x(), -a.y()); }
+	friend constexpr BasicPoint operator*(const BasicPoint& a, const S factor) { return BasicPoint(a.x() * factor, a.y() * factor); }
+	friend constexpr BasicPoint operator*(const S factor, const BasicPoint& a) { return a * factor; }
+	friend constexpr bool operator==(const BasicPoint& a, const BasicPoint& b) { return a.x() == b.x() && a.y() == b.y(); }
+	friend constexpr bool operator!=(const BasicPoint& a, const BasicPoint& b) { return !(a == b); }
 };
 
-Point operator+(const Point& a, const Point& b);
-Point operator*(const Point& a, const double factor);
-bool operator==(const Point& a, const Point& b);
-bool operator!=(const Point& a, const Point& b);
-std::ostream& operator<<(std::ostream& os, const Point& a);
+template <typename S>
+std::ostream& operator<<(std::ostream& os, const BasicPoint<S>& a);
+
+// Vector operations on points taken as offsets from the origin.
+template <typename S>
+constexpr typename ScalarTraits<S>::Wide dot(const BasicPoint<S>& a, const BasicPoint<S>& b) {
+	return ScalarTraits<S>::multiply(a.x(), b.x()) + ScalarTraits<S>::multiply(a.y(), b.y());
+}
+
+template <typename S>
+constexpr typename ScalarTraits<S>::Wide cross(const BasicPoint<S>& a, const BasicPoint<S>& b) {
+	return ScalarTraits<S>::multiply(a.x(), b.y()) - ScalarTraits<S>::multiply(a.y(), b.x());
+}
+
+template <typename S>
+constexpr typename ScalarTraits<S>::Wide lengthSquared(const BasicPoint<S>& a) { return dot(a, a); }
+
+// anti-clockwise about the origin
+template <typename S>
+BasicPoint<S> rotate(const BasicPoint<S>& a, const typename NonDeduced<BasicAngle<S> >::Type& by);
+
+template <typename S>
+constexpr typename ScalarTraits<S>::Wide distanceSquared(const BasicPoint<S>& from, const BasicPoint<S>& to) {
+	return lengthSquared(to - from);
+}
 
 ////////////////////////////////////////////////////////////
 //
-// class Angle
+// class BasicAngle
 //
 // Angles are stored anti-clockwise in radians from the 3 o'clock position.
 // Turns clockwise are negative and anti-clockwise are positive.  Callers can
-// interface with the class in degrees or radians as they wish.
+// interface with the class in degrees or radians as they wish.  Like Point,
+// a trivially copyable value type usable at compile time.
 
-class Angle {
+template <typename S>
+class BasicAngle {
 private:
-	double m_value;  // in radians, may be negative
+	S m_value;  // in radians, may be negative
 public:
+	typedef S Scalar;
 	enum Unit { degrees, radians };
 
 	// Creators
-	Angle() : m_value(0.0) {}
-	Angle(const double to) : m_value(to) {}
-	Angle(const Angle& to) : m_value(to.as_r()) {}
+	constexpr BasicAngle() : m_value() {}
+	constexpr BasicAngle(const S to) : m_value(to) {}
 
 	// Accessors
-	double as_d() const; // value in degree
-	double as_r() const; // value in radians
-	bool near(const Angle& other, const Angle& epsilon) const;
-	bool near(const Angle& other, const double epsilon) const;
+	constexpr S as_d() const { return r2d(m_value); } // value in degree
+	constexpr S as_r() const { return m_value; }      // value in radians
+	bool near(const BasicAngle& other, const BasicAngle& epsilon) const;
+	bool near(const BasicAngle& other, const S epsilon) const;
 	
 	// Modifiers
-	Angle& set(const double angle) { m_value = angle; return *this; }
-	Angle& clear() { return set(0.0); }
-	Angle& normalize();
-	Angle& operator=(const double b) { return set(b); }
-	Angle& operator=(const Angle& b) { return set(b.as_r()); }
-	Angle& operator+=(const Angle& b) { return set(as_r() + b.as_r()); }
-	Angle& operator+=(const double b) { return set(as_r() + b); }
-	Angle& operator-=(const Angle& b) { return set(as_r() - b.as_r()); }
-	Angle& operator-=(const double b) { return set(as_r() - b); }
+	constexpr BasicAngle& set(const S angle) { m_value = angle; return *this; }
+	constexpr BasicAngle& clear() { return set(S()); }
+	BasicAngle& normalize();
+	constexpr BasicAngle& operator=(const S b) { return set(b); }
+	constexpr BasicAngle& operator+=(const BasicAngle& b) { return set(as_r() + b.as_r()); }
+	constexpr BasicAngle& operator+=(const S b) { return set(as_r() + b); }
+	constexpr BasicAngle& operator-=(const BasicAngle& b) { return set(as_r() - b.as_r()); }
+	constexpr BasicAngle& operator-=(const S b) { return set(as_r() - b); }
 
 	// TODO: maybe these should be free functions
-	static double r2d(const double angle);
-	static double d2r(const double angle);
+	static constexpr S r2d(const S angle) { return angle * ScalarTraits<S>::fromDouble(180.0 / pi); }
+	static constexpr S d2r(const S angle) { return angle * ScalarTraits<S>::fromDouble(pi / 180.0); }
+
+	friend constexpr bool operator<(const BasicAngle& a, const BasicAngle& b) { return a.as_r() < b.as_r(); }
+	friend constexpr bool operator>(const BasicAngle& a, const BasicAngle& b) { return a.as_r() > b.as_r(); }
+	friend constexpr bool operator<=(const BasicAngle& a, const BasicAngle& b) { return a.as_r() <= b.as_r(); }
+	friend constexpr bool operator>=(const BasicAngle& a, const BasicAngle& b) { return a.as_r() >= b.as_r(); }
+	friend constexpr bool operator==(const BasicAngle& a, const BasicAngle& b) { return a.as_r() == b.as_r(); }
+	friend constexpr bool operator!=(const BasicAngle& a, const BasicAngle& b) { return a.as_r() != b.as_r(); }
 };
 
-bool operator<(const Angle& a, const Angle& b);
-bool operator>(const Angle& a, const Angle& b);
-bool operator<=(const Angle& a, const Angle& b);
-bool operator>=(const Angle& a, const Angle& b);
-bool operator==(const Angle& a, const Angle& b);
-bool operator!=(const Angle& a, const Angle& b);
-std::ostream& operator<<(std::ostream& os, const Angle& a);
+template <typename S>
+std::ostream& operator<<(std::ostream& os, const BasicAngle<S>& a);
+
+// Normalizes every angle in place, as Angle::normalize() does, with the
+// vectorized kernel for this machine; see Simd.h.  The second form works
+// directly on arrays of radians.  Like the batch kernels, these take a
+// pointer and a count, which is what EntityBatch hands out.
+void normalizeAll(Angle* angles, const std::size_t count);
+void normalizeAll(double* radians, const std::size_t count);
 
 ////////////////////////////////////////////////////////////
 //
-// class Entity
+// class BasicEntity
 //
 // Represents a physics object with location, facing, and speed.  Does not
-// implement size, mass, impulse, collision, etc.
+// implement size, mass, impulse, collision, etc.  A trivially copyable
+// value type; see TrackedEntity in SpatialGrid.h for one that keeps a
+// spatial index up to date.
+//
+// The velocity is cached: it is worked out from facing and speed the first
+// time it is needed after either changes, so moving in a straight line
+// costs two adds per move().
+
+template <typename S>
+class BasicEntity {
+public:
+	typedef S Scalar;
+	typedef BasicPoint<S> Point;
+	typedef BasicAngle<S> Angle;
 
-class Entity {
 private:
 	Point m_position;
 	Angle m_facing;
-	double m_speed;
+	S m_speed;
+	mutable Point m_velocity;      // valid only if m_velocityCurrent
+	mutable bool m_velocityCurrent;
+
+	void updateVelocity() const;
 
 public:
 	// Creators
-	Entity();
-	Entity(const Point& position, const Angle& facing, const double speed);
-	Entity(const Entity& other);
+	constexpr BasicEntity() : m_speed(), m_velocityCurrent(true) {}
+	constexpr BasicEntity(const Point& position, const Angle& facing, const S speed)
+		: m_position(position), m_facing(facing), m_speed(speed), m_velocityCurrent(false) {}
 
 	// Accessors
-	const Point& position() const { return m_position; }
-	const Angle& facing() const { return m_facing; }
-	const double speed() const { return m_speed; }
+	constexpr const Point& position() const { return m_position; }
+	constexpr const Angle& facing() const { return m_facing; }
+	constexpr S speed() const { return m_speed; }
+	const Point& velocity() const { // displacement of the next move()
+		if (!m_velocityCurrent)
+			updateVelocity();
+		return m_velocity;
+	}
 	
 	// Modifiers
-	const double setSpeed(const double speed);
+	S setSpeed(const S speed);
 	const Angle& setFacing(const Angle& facing);
-	const Point& setPosition(const Point& position);
-	void move();
-	Entity& operator=(const Entity& other);
+	constexpr const Point& setPosition(const Point& position) { m_position = position; return m_position; }
+	void move() { m_position += velocity(); }
+};
+
+////////////////////////////////////////////////////////////
+//
+// class BasicDrive
+//
+// The CROBOTS motor model, as an integrator that advances an entity one
+// tick at a time.  A drive holds the requested heading and speed; each
+// step() brings the entity's speed at most 'acceleration' closer to the
+// requested speed and then moves it.  The heading can only change at or
+// below 'turnSpeed'.  Asking for a new heading while going faster
+// disengages the drive, as in CROBOTS: the requested speed drops to zero,
+// and the turn is made once the entity has slowed enough.
+//
+// step() only touches facing and speed while they differ from what was
+// requested, so a cruising entity keeps its cached velocity.
+
+template <typename S>
+class BasicDrive {
+public:
+	typedef BasicAngle<S> Angle;
+
+private:
+	Angle m_heading;   // requested, normalized
+	S m_speed;         // requested, non-negative
+	S m_acceleration;  // speed change per step, up or down
+	S m_turnSpeed;     // fastest speed at which the heading can change
+
+public:
+	// Creators
+	constexpr BasicDrive(const S acceleration, const S turnSpeed)
+		: m_speed(), m_acceleration(acceleration), m_turnSpeed(turnSpeed) {}
+
+	// CROBOTS gains or loses 10% of full speed per step and turns at 50%.
+	static constexpr BasicDrive crobots(const S fullSpeed) {
+		return BasicDrive(fullSpeed * ScalarTraits<S>::fromDouble(0.1),
+		                  fullSpeed * ScalarTraits<S>::fromDouble(0.5));
+	}
+
+	// Accessors
+	constexpr const Angle& heading() const { return m_heading; }
+	constexpr S speed() const { return m_speed; }
+	constexpr S acceleration() const { return m_acceleration; }
+	constexpr S turnSpeed() const { return m_turnSpeed; }
+
+	// Modifiers
+	void set(const Angle& heading, const S speed); // negative speeds stop
+	void stop() { m_speed = S(); }                 // e.g. after a collision
+	// For a BasicEntity, or anything with the same accessors and setters
+	// and a move(), such as a TrackedEntity.
+	template <typename E> void step(E& entity);
+
+	// step() without the move, for entities that are moved together, such
+	// as an EntityBatch::Ref before EntityBatch::moveAll().
+	template <typename E> void steer(E& entity);
+};
+
+template <typename S>
+template <typename E>
+void BasicDrive<S>::step(E& entity) {
+	steer(entity);
+	// Note that this jumps the entity to its new position.  Use velocity()
+	// with the sweep tests in Collision.h to find out what the jump passes
+	// through.
+	entity.move();
+}
+
+template <typename S>
+template <typename E>
+void BasicDrive<S>::steer(E& entity) {
+	if (entity.facing() != m_heading) {
+		if (entity.speed() <= m_turnSpeed)
+			entity.setFacing(m_heading);
+		else
+			m_speed = S();
+	}
+	const S current = entity.speed();
+	if (current < m_speed)
+		entity.setSpeed(current + m_acceleration < m_speed ? current + m_acceleration : m_speed);
+	else if (current > m_speed)
+		entity.setSpeed(current - m_acceleration > m_speed ? current - m_acceleration : m_speed);
+}
+
+// Instantiated in Geometry.cpp for each policy in Scalar.h.
+extern template class BasicPoint<double>;
+extern template class BasicPoint<float>;
+extern template class BasicPoint<Fixed>;
+extern template class BasicAngle<double>;
+extern template class BasicAngle<float>;
+extern template class BasicAngle<Fixed>;
+extern template class BasicEntity<double>;
+extern template class BasicEntity<float>;
+extern template class BasicEntity<Fixed>;
+extern template class BasicDrive<double>;
+extern template class BasicDrive<float>;
+extern template class BasicDrive<Fixed>;
+
+////////////////////////////////////////////////////////////
+//
+// class EntityBatch
+//
+// Stores many entities as a structure of arrays: x, y, facing, speed and the
+// cached velocity components each live in their own contiguous, aligned
+// array.  moveAll() advances every entity in a single loop the compiler can
+// vectorize.  Individual entities are reached through EntityBatch::Ref, a
+// view with the same interface as Entity.  Indices are stable until remove().
+
+class EntityBatch {
+public:
+	typedef std::size_t Index;
+	typedef std::vector<double, AlignedAllocator<double> > Array;
+
+	class Ref {
+	private:
+		EntityBatch* m_batch;
+		Index m_index;
+	public:
+		// Creators
+		Ref(EntityBatch& batch, Index index) : m_batch(&batch), m_index(index) {}
+
+		// Accessors
+		Index index() const { return m_index; }
+		Point position() const;
+		Angle facing() const;
+		double speed() const;
+		Entity entity() const;
+
+		// Modifiers
+		double setSpeed(const double speed);
+		Angle setFacing(const Angle& facing);
+		Point setPosition(const Point& position);
+		void move();
+		Ref& operator=(const Entity& other);
+	};
+
+private:
+	Array m_x, m_y;     // position
+	Array m_facing;     // radians, normalized
+	Array m_speed;      // non-negative
+	Array m_vx, m_vy;   // speed * (cos, sin) of facing; kept in sync
+
+	void updateVelocity(Index i);
+
+public:
+	// Creators
+	EntityBatch() {}
+	explicit EntityBatch(std::size_t capacity) { reserve(capacity); }
+
+	// Accessors
+	std::size_t size() const { return m_x.size(); }
+	bool empty() const { return m_x.empty(); }
+	Entity entity(Index i) const;
+	const double* x() const { return m_x.data(); }
+	const double* y() const { return m_y.data(); }
+	const double* facing() const { return m_facing.data(); }
+	const double* speed() const { return m_speed.data(); }
+	const double* vx() const { return m_vx.data(); }
+	const double* vy() const { return m_vy.data(); }
+
+	// Modifiers
+	void reserve(std::size_t capacity);
+	void clear();
+	Index add(const Entity& entity);
+	void remove(Index i); // moves the last entity into slot i
+	Ref operator[](Index i) { return Ref(*this, i); }
+	// Turns entity i by turns[i] radians, anti-clockwise, for every i, with
+	// one normalizeAll() pass over the facings.
+	void turnAll(const double* turns);
+	void moveAll();
 };
 
 } // namespace Geometry
@@ -1,12 +1,26 @@
 #include "Contrib/UnitTest++/src/UnitTest++.h"
 
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
 #include "../Shared/Geometry.h"
+#include "../Shared/Simd.h"
+
+// Value types must stay trivially copyable and usable at compile time.
+static_assert(std::is_trivially_copyable<Geometry::Point>::value, "Point must be trivially copyable");
+static_assert(std::is_trivially_copyable<Geometry::Angle>::value, "Angle must be trivially copyable");
+static_assert(std::is_trivially_copyable<Geometry::Entity>::value, "Entity must be trivially copyable");
+static_assert(Geometry::distanceSquared(Geometry::Point(1, 2), Geometry::Point(4, 6)) == 25.0,
+              "distanceSquared must be constexpr");
+static_assert(Geometry::Angle(Geometry::pi).as_d() == 180.0, "Angle conversions must be constexpr");
 
 SUITE(GeometryTestSuite) {
 
 TEST(Pi) {
 	CHECK_CLOSE(3.14159, Geometry::pi, 0.0001);
 	CHECK_CLOSE(6.28318, Geometry::twopi, 0.0001);
+	CHECK_EQUAL(3.141592653589793, Geometry::pi);
 }
 
 ////////////////////////////////////////
@@ -46,6 +60,28 @@ TEST(PointAssignment) {
 	CHECK_EQUAL(4.4, p.y());
 }
 
+TEST(PointVectorOperations) {
+	constexpr Geometry::Point a(3, 4);
+	constexpr Geometry::Point b(1, 2);
+	constexpr double d = Geometry::dot(a, b);
+	constexpr double c = Geometry::cross(a, b);
+	CHECK_EQUAL(11.0, d);
+	CHECK_EQUAL(2.0, c);
+	CHECK_EQUAL(25.0, Geometry::lengthSquared(a));
+	CHECK((a - b) == Geometry::Point(2, 2));
+	CHECK(-a == Geometry::Point(-3, -4));
+	CHECK(2.0 * b == Geometry::Point(2, 4));
+	CHECK(Geometry::rotate(Geometry::Point(1, 0), Geometry::pi / 2).near(Geometry::Point(0, 1), 0.00001));
+	CHECK(Geometry::rotate(a, Geometry::pi).near(-a, 0.00001));
+}
+
+TEST(PointMemcpy) {
+	Geometry::Point points[3] = { Geometry::Point(1, 2), Geometry::Point(3, 4), Geometry::Point(5, 6) };
+	Geometry::Point snapshot[3];
+	std::memcpy(snapshot, points, sizeof(points));
+	CHECK(snapshot[2] == Geometry::Point(5, 6));
+}
+
 TEST(PointComparison) {
 	Geometry::Point p(1,2);
 	Geometry::Point q(1,2);
@@ -102,6 +138,61 @@ TEST(AngleAssignment) {
 	CHECK_CLOSE(Geometry::pi, a.as_r(), 0.0001);
 }
 
+TEST(AngleNormalize) {
+	Geometry::Angle a(Geometry::pi + 10 * Geometry::twopi);
+	a.normalize();
+	CHECK_CLOSE(Geometry::pi, a.as_r(), 0.0001);
+
+	a.set(-Geometry::pi - 3 * Geometry::twopi);
+	a.normalize();
+	CHECK_CLOSE(-Geometry::pi, a.as_r(), 0.0001);
+
+	a.set(Geometry::twopi);
+	a.normalize();
+	CHECK_CLOSE(0.0, a.as_r(), 0.0001);
+
+	// corrupted headings finish immediately and land in range
+	a.set(1e300);
+	a.normalize();
+	CHECK(a.as_r() < Geometry::twopi && a.as_r() > -Geometry::twopi);
+
+	a.set(1e300 * 1e300);
+	a.normalize();
+	CHECK_EQUAL(0.0, a.as_r());
+}
+
+TEST(AngleNormalizeAll) {
+	// including values normalize() maps to 0
+	double inputs[300];
+	for (int i = 0; i < 300; ++i)
+		inputs[i] = i % 50 == 7 ? std::numeric_limits<double>::quiet_NaN()
+		          : i % 50 == 9 ? -std::numeric_limits<double>::infinity()
+		          : i % 50 == 11 ? 1e300
+		          : (i - 150) * 1.7;
+
+	// at every level
+	const Geometry::SimdLevel saved = Geometry::activeSimd();
+	for (int level = Geometry::simdScalar; level <= Geometry::detectedSimd(); ++level) {
+		Geometry::forceSimd(static_cast<Geometry::SimdLevel>(level));
+		Geometry::Angle angles[300];
+		double radians[300];
+		for (int i = 0; i < 300; ++i) {
+			angles[i].set(inputs[i]);
+			radians[i] = inputs[i];
+		}
+		Geometry::normalizeAll(angles, 300);
+		Geometry::normalizeAll(radians, 300);
+		for (int i = 0; i < 300; ++i) {
+			Geometry::Angle expected(inputs[i]);
+			expected.normalize();
+			CHECK_EQUAL(expected.as_r(), angles[i].as_r());
+			CHECK_EQUAL(expected.as_r(), radians[i]);
+			CHECK(angles[i].as_r() < Geometry::twopi && angles[i].as_r() > -Geometry::twopi);
+		}
+	}
+	Geometry::forceSimd(saved);
+}
+
 TEST(AngleComparison) {
 	Geometry::Angle a(Geometry::pi);
 	Geometry::Angle b(Geometry::pi);
@@ -124,6 +215,16 @@ TEST(AngleComparison) {
 	CHECK(a.near(b, epsilon));
 }
 
+TEST(Bearing) {
+	const Geometry::Point origin(100, 100);
+	CHECK_CLOSE(0.0, Geometry::bearing(origin, Geometry::Point(200, 100)).as_r(), 0.0001);
+	CHECK_CLOSE(Geometry::pi / 2, Geometry::bearing(origin, Geometry::Point(100, 200)).as_r(), 0.0001);
+	CHECK_CLOSE(Geometry::pi, Geometry::bearing(origin, Geometry::Point(0, 100)).as_r(), 0.0001);
+	CHECK_CLOSE(3 * Geometry::pi / 2, Geometry::bearing(origin, Geometry::Point(100, 0)).as_r(), 0.0001);
+	CHECK_CLOSE(7 * Geometry::pi / 4, Geometry::bearing(origin, Geometry::Point(200, 0)).as_r(), 0.0001);
+	CHECK_EQUAL(0.0, Geometry::bearing(origin, origin).as_r());
+}
+
 ////////////////////////////////////////
 
 TEST(EntityCreation) {
@@ -202,4 +303,211 @@ TEST(EntityMotion) {
 	}
 }
 
+TEST(EntityVelocityCache) {
+	Geometry::Entity e(Geometry::Point(0, 0), Geometry::Angle(0), 10);
+	CHECK(e.velocity().near(Geometry::Point(10, 0), 1e-9));
+	e.setFacing(Geometry::Angle(Geometry::pi / 2));
+	CHECK(e.velocity().near(Geometry::Point(0, 10), 1e-6));
+	e.setSpeed(4);
+	CHECK(e.velocity().near(Geometry::Point(0, 4), 1e-6));
+	e.setSpeed(-1); // rejected, velocity unchanged
+	CHECK(e.velocity().near(Geometry::Point(0, 4), 1e-6));
+
+	// copies carry the cache along
+	const Geometry::Entity copy(e);
+	CHECK(copy.velocity() == e.velocity());
+	CHECK(Geometry::Entity().velocity() == Geometry::Point());
+}
+
+TEST(DriveAcceleration) {
+	Geometry::Entity e(Geometry::Point(0, 0), Geometry::Angle(0), 0);
+	Geometry::Drive drive = Geometry::Drive::crobots(10);
+	CHECK_CLOSE(1.0, drive.acceleration(), 1e-12);
+	CHECK_CLOSE(5.0, drive.turnSpeed(), 1e-12);
+
+	drive.set(Geometry::Angle(0), 10);
+	for (int i = 1; i <= 10; ++i) {
+		drive.step(e);
+		CHECK_CLOSE(i, e.speed(), 1e-9);
+	}
+	drive.step(e);
+	CHECK_CLOSE(10.0, e.speed(), 1e-9);
+	CHECK_CLOSE(65.0, e.position().x(), 1e-6); // 1 + 2 + ... + 10 + 10
+
+	drive.set(Geometry::Angle(0), 3.5);
+	for (int i = 0; i < 6; ++i)
+		drive.step(e);
+	CHECK_CLOSE(4.0, e.speed(), 1e-9);
+	drive.step(e);
+	CHECK_CLOSE(3.5, e.speed(), 1e-9);
+
+	drive.set(Geometry::Angle(0), -2); // negative speeds stop
+	CHECK_EQUAL(0.0, drive.speed());
+}
+
+TEST(DriveTurnsOnlyWhenSlow) {
+	{
+		// at or below the turn speed the heading changes at once
+		Geometry::Entity e(Geometry::Point(0, 0), Geometry::Angle(0), 5);
+		Geometry::Drive drive = Geometry::Drive::crobots(10);
+		drive.set(Geometry::Angle(Geometry::pi / 2), 5);
+		drive.step(e);
+		CHECK(e.facing().near(Geometry::Angle(Geometry::pi / 2), 1e-12));
+		CHECK(e.position().near(Geometry::Point(0, 5), 1e-6));
+		CHECK_CLOSE(5.0, drive.speed(), 1e-12);
+	}
+	{
+		// above it the drive disengages, and the turn waits until slow enough
+		Geometry::Entity e(Geometry::Point(0, 0), Geometry::Angle(0), 8);
+		Geometry::Drive drive = Geometry::Drive::crobots(10);
+		drive.set(Geometry::Angle(Geometry::pi), 8);
+		drive.step(e);
+		CHECK_EQUAL(0.0, drive.speed());
+		CHECK(e.facing() == Geometry::Angle(0));
+		CHECK_CLOSE(7.0, e.speed(), 1e-9);
+		drive.step(e);
+		drive.step(e);
+		CHECK(e.facing() == Geometry::Angle(0));
+		CHECK_CLOSE(5.0, e.speed(), 1e-9);
+		drive.step(e);
+		CHECK(e.facing().near(Geometry::Angle(Geometry::pi), 1e-12));
+		CHECK_CLOSE(4.0, e.speed(), 1e-9);
+	}
+}
+
+////////////////////////////////////////
+
+TEST(EntityBatchAddAndView) {
+	Geometry::EntityBatch batch(4);
+	CHECK(batch.empty());
+
+	Geometry::Entity e(Geometry::Point(1,2), Geometry::Angle(Geometry::pi), 100);
+	Geometry::EntityBatch::Index i = batch.add(e);
+	CHECK_EQUAL(0u, i);
+	CHECK_EQUAL(1u, batch.size());
+
+	Geometry::EntityBatch::Ref ref = batch[i];
+	CHECK(ref.position() == e.position());
+	CHECK(ref.facing() == e.facing());
+	CHECK_CLOSE(100.0, ref.speed(), 0.0001);
+
+	ref.setPosition(Geometry::Point(5,6));
+	CHECK_EQUAL(5.0, batch.x()[i]);
+	CHECK_EQUAL(6.0, batch.y()[i]);
+	CHECK(batch.entity(i).position() == Geometry::Point(5,6));
+}
+
+TEST(EntityBatchMoveMatchesEntity) {
+	Geometry::EntityBatch batch;
+	Geometry::Entity entities[3] = {
+		Geometry::Entity(Geometry::Point(0,0), Geometry::Angle(0), 100),
+		Geometry::Entity(Geometry::Point(10,10), Geometry::Angle(Geometry::pi / 2), 20),
+		Geometry::Entity(Geometry::Point(500,500), Geometry::Angle(1.0), 0)
+	};
+	for (int i = 0; i < 3; ++i)
+		batch.add(entities[i]);
+
+	for (int tick = 0; tick < 5; ++tick) {
+		batch.moveAll();
+		for (int i = 0; i < 3; ++i)
+			entities[i].move();
+	}
+	for (int i = 0; i < 3; ++i)
+		CHECK(batch[i].position().near(entities[i].position(), 0.001));
+
+	// changing speed or facing through a view refreshes the cached velocity
+	batch[0].setSpeed(50);
+	batch[0].setFacing(Geometry::Angle(Geometry::pi));
+	batch[0].move();
+	CHECK(batch[0].position().near(Geometry::Point(450,0), 0.001));
+}
+
+TEST(EntityBatchTurnMatchesSetFacing) {
+	Geometry::EntityBatch batch, one;
+	double turns[40];
+	for (int i = 0; i < 40; ++i) {
+		const Geometry::Entity entity(Geometry::Point(i, 2 * i), Geometry::Angle(i * 0.7), 10 + i);
+		batch.add(entity);
+		one.add(entity);
+		turns[i] = (i - 20) * 0.83;
+	}
+	batch.turnAll(turns);
+	for (int i = 0; i < 40; ++i) {
+		one[i].setFacing(Geometry::Angle(one.facing()[i] + turns[i]));
+		CHECK_EQUAL(one.facing()[i], batch.facing()[i]);
+		CHECK_EQUAL(one.vx()[i], batch.vx()[i]);
+		CHECK_EQUAL(one.vy()[i], batch.vy()[i]);
+	}
+}
+
+TEST(EntityBatchRemove) {
+	Geometry::EntityBatch batch;
+	batch.add(Geometry::Entity(Geometry::Point(1,1), Geometry::Angle(0), 1));
+	batch.add(Geometry::Entity(Geometry::Point(2,2), Geometry::Angle(0), 2));
+	batch.add(Geometry::Entity(Geometry::Point(3,3), Geometry::Angle(0), 3));
+
+	batch.remove(0);
+	CHECK_EQUAL(2u, batch.size());
+	CHECK(batch[0].position() == Geometry::Point(3,3));
+	CHECK_CLOSE(3.0, batch[0].speed(), 0.0001);
+
+	batch.remove(1);
+	CHECK_EQUAL(1u, batch.size());
+	CHECK(batch[0].position() == Geometry::Point(3,3));
+}
+
+////////////////////////////////////////
+// Other scalar policies
+
+TEST(FloatGeometry) {
+	typedef Geometry::BasicPoint<float> Point;
+	typedef Geometry::BasicAngle<float> Angle;
+	typedef Geometry::BasicEntity<float> Entity;
+	CHECK_EQUAL(25.0f, Geometry::distanceSquared(Point(1, 2), Point(4, 6)));
+	CHECK_CLOSE(5.0f, Geometry::distance(Point(1, 2), Point(4, 6)), 1e-6f);
+	CHECK_CLOSE(Geometry::pi / 4, Geometry::bearing(Point(0, 0), Point(3, 3)).as_r(), 1e-6);
+	CHECK_CLOSE(0.5f, Angle(-Geometry::twopi + 0.5).normalize().as_r() + Geometry::twopi, 1e-5f);
+
+	Entity e(Point(100, 100), Angle(Angle::d2r(90)), 10);
+	e.move();
+	CHECK(e.position().near(Point(100, 110), 1e-4f));
+}
+
+TEST(FixedGeometry) {
+	typedef Geometry::Fixed Fixed;
+	typedef Geometry::BasicPoint<Fixed> Point;
+	typedef Geometry::BasicAngle<Fixed> Angle;
+	typedef Geometry::BasicEntity<Fixed> Entity;
+	static_assert(std::is_trivially_copyable<Entity>::value, "fixed Entity must be trivially copyable");
+
+	// squared distances are exact, even across the whole arena
+	CHECK_EQUAL(2000000.0, Geometry::distanceSquared(Point(0, 0), Point(1000, 1000)).toDouble());
+	CHECK(Geometry::distance(Point(1, 2), Point(4, 6)) == Fixed(5));
+	CHECK_CLOSE(Geometry::pi / 4, Geometry::bearing(Point(0, 0), Point(3, 3)).as_r().toDouble(), 3.0 / 65536);
+	CHECK(Geometry::bearing(Point(5, 5), Point(5, 5)) == Angle());
+
+	Angle a(Fixed(-7.0));
+	a.normalize();
+	CHECK_CLOSE(-7.0 + Geometry::twopi, a.as_r().toDouble(), 2.0 / 65536);
+
+	Entity e(Point(100, 100), Angle(Angle::d2r(90)), 10);
+	e.move();
+	CHECK(e.position().near(Point(100, 110), Fixed(0.01)));
+}
+
+TEST(FixedGeometryIsDeterministic) {
+	// The whole path is integer arithmetic; these raw values are what every
+	// machine must produce.
+	typedef Geometry::Fixed Fixed;
+	Geometry::BasicEntity<Fixed> e(Geometry::BasicPoint<Fixed>(500, 500),
+	                               Geometry::BasicAngle<Fixed>(Fixed(1.0)), Fixed(7.5));
+	for (int i = 0; i < 1000; ++i) {
+		e.move();
+		e.setFacing(Geometry::BasicAngle<Fixed>(e.facing().as_r() + Fixed(0.01)));
+	}
+	CHECK_EQUAL(-57663828, e.position().x().raw());
+	CHECK_EQUAL(59840558, e.position().y().raw());
+	CHECK_EQUAL(308761, e.facing().as_r().raw());
+}
+
 } // suite
@@ -0,0 +1,467 @@
+// Jit.cpp
+// Compiles CROBOTS basic blocks to x86-64 machine code, for the Cpu's
+// native tier.
+
+#include "Jit.h"
+
+#include <algorithm>        // max()
+#include <cstddef>          // offsetof
+#include <cstring>          // memcpy()
+#include <initializer_list>
+#include <utility>          // pair
+
+#if JBOTS_JIT
+#include <sys/mman.h>
+#include <unistd.h>         // sysconf()
+#endif
+
+namespace Vm {
+
+#if JBOTS_JIT
+
+namespace {
+
+// Below this, entering and leaving native code costs more than it saves.
+const int minimumCost = 3;
+
+// While a block runs, the Machine is in rbx, sp in r12, the mark in r13,
+// the bottom of the stack in r14, csp in r15 and the top of the stack in
+// ebp: all kept across calls to intrinsics by the calling convention.
+enum Register { rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi, r8, r9, r10, r11, r12, r13, r14, r15 };
+
+////////////////////////////////////////////////////////////
+//
+// class Emitter
+//
+// Appends machine code, and patches jumps once their targets are known.
+
+class Emitter {
+private:
+	std::vector<std::uint8_t>& m_code;
+
+public:
+	explicit Emitter(std::vector<std::uint8_t>& code) : m_code(code) {}
+
+	std::size_t here() const { return m_code.size(); }
+
+	void bytes(std::initializer_list<int> bytes) {
+		for (const int b : bytes)
+			m_code.push_back(static_cast<std::uint8_t>(b));
+	}
+	void word(const std::uint32_t w) {
+		for (int i = 0; i < 4; ++i)
+			m_code.push_back(static_cast<std::uint8_t>(w >> (8 * i)));
+	}
+	void quad(const std::uint64_t q) {
+		word(static_cast<std::uint32_t>(q));
+		word(static_cast<std::uint32_t>(q >> 32));
+	}
+
+	// A jump whose 8- or 32-bit displacement is filled in by land().
+	std::size_t jump8(const int opcode) {
+		bytes({ opcode, 0 });
+		return here();
+	}
+	void land8(const std::size_t from) { m_code[from - 1] = static_cast<std::uint8_t>(here() - from); }
+	std::size_t jump32(std::initializer_list<int> opcode) {
+		bytes(opcode);
+		word(0);
+		return here();
+	}
+	void land32(const std::size_t from) { patch32(from, here()); }
+	void patch32(const std::size_t from, const std::size_t to) {
+		const std::uint32_t rel = static_cast<std::uint32_t>(to - from);
+		std::memcpy(&m_code[from - 4], &rel, 4);
+	}
+
+	// mov between a register and a Machine field, [rbx + disp8]
+	void machine(const int opcode, const bool wide, const int reg, const std::size_t field) {
+		const int rex = (wide ? 0x48 : 0x40) | (reg >= 8 ? 4 : 0);
+		if (rex != 0x40)
+			bytes({ rex });
+		bytes({ opcode, 0x40 | (reg & 7) << 3 | rbx, static_cast<int>(field) });
+	}
+	void load(const int reg, const std::size_t field) { machine(0x8b, true, reg, field); }
+	void save(const int reg, const std::size_t field) { machine(0x89, true, reg, field); }
+
+	// mov between eax or ebp and a variable, [r13 or r14 + disp32]
+	void variable(const int opcode, const int reg, const int bank, const Word offset) {
+		bytes({ 0x41, opcode, 0x80 | (reg & 7) << 3 | (bank & 7) });
+		word(static_cast<std::uint32_t>(offset * 4));
+	}
+
+	// *sp++ = tos
+	void spill() {
+		bytes({ 0x41, 0x89, 0x2c, 0x24 }); // mov [r12], ebp
+		bytes({ 0x49, 0x83, 0xc4, 0x04 }); // add r12, 4
+	}
+	// tos = *--sp
+	void unspill() {
+		bytes({ 0x49, 0x83, 0xec, 0x04 }); // sub r12, 4
+		bytes({ 0x41, 0x8b, 0x2c, 0x24 }); // mov ebp, [r12]
+	}
+
+	void operate(const int op);
+};
+
+// eax = eax op ecx, as binary<op>() does.
+void Emitter::operate(const int op) {
+	switch (op) {
+	case Instruction::assign: bytes({ 0x89, 0xc8 }); break;       // mov eax, ecx
+	case Instruction::add: bytes({ 0x01, 0xc8 }); break;          // add eax, ecx
+	case Instruction::sub: bytes({ 0x29, 0xc8 }); break;          // sub eax, ecx
+	case Instruction::mul: bytes({ 0x0f, 0xaf, 0xc1 }); break;    // imul eax, ecx
+	case Instruction::div:
+	case Instruction::mod: {
+		// neither idiv by zero nor INT_MIN / -1 traps
+		bytes({ 0x85, 0xc9 });                           // test ecx, ecx
+		const std::size_t zero = jump8(0x74);            // jz
+		bytes({ 0x83, 0xf9, 0xff });                     // cmp ecx, -1
+		const std::size_t minus = jump8(0x74);           // je
+		bytes({ 0x99, 0xf7, 0xf9 });                     // cdq; idiv ecx
+		if (op == Instruction::mod)
+			bytes({ 0x89, 0xd0 });                       // mov eax, edx
+		const std::size_t done = jump8(0xeb);
+		land8(minus);
+		if (op == Instruction::div) {
+			bytes({ 0xf7, 0xd8 });                       // neg eax
+			const std::size_t negated = jump8(0xeb);
+			land8(zero);
+			bytes({ 0x31, 0xc0 });                       // xor eax, eax
+			land8(negated);
+		} else {
+			land8(zero);
+			bytes({ 0x31, 0xc0 });
+		}
+		land8(done);
+		break;
+	}
+	case Instruction::shl: bytes({ 0xd3, 0xe0 }); break;          // shl eax, cl
+	case Instruction::shr: bytes({ 0xd3, 0xf8 }); break;          // sar eax, cl
+	case Instruction::band: bytes({ 0x21, 0xc8 }); break;
+	case Instruction::bor: bytes({ 0x09, 0xc8 }); break;
+	case Instruction::bxor: bytes({ 0x31, 0xc8 }); break;
+	case Instruction::land:
+		bytes({ 0x85, 0xc0, 0x0f, 0x95, 0xc0 });                    // test eax, eax; setne al
+		bytes({ 0x85, 0xc9, 0x0f, 0x95, 0xc1 });                    // test ecx, ecx; setne cl
+		bytes({ 0x20, 0xc8, 0x0f, 0xb6, 0xc0 });                    // and al, cl; movzx eax, al
+		break;
+	case Instruction::lor:
+		bytes({ 0x09, 0xc8, 0x0f, 0x95, 0xc0, 0x0f, 0xb6, 0xc0 });  // or; setne al; movzx
+		break;
+	default: {
+		// cmp eax, ecx; setcc al; movzx eax, al
+		static const int setcc[] = { 0x9c, 0x9e, 0x94, 0x95, 0x9d, 0x9f }; // lt le eq ne ge gt
+		bytes({ 0x39, 0xc8, 0x0f, setcc[op - Instruction::lt], 0xc0, 0x0f, 0xb6, 0xc0 });
+		break;
+	}
+	}
+}
+
+bool isExternal(const Instruction& in) { return (in.operand & external) != 0; }
+
+// Whether 'in' can be part of a block: what the interpreter would run as
+// anything other than a call to a robot function, a RETSUB or a Restart.
+bool compilable(const Image& image, const Instruction& in) {
+	const Word offset = in.operand & ~external;
+	const bool variable = isExternal(in) ? offset >= 0 && offset < image.externals
+	                                     : in.operand >= 0 && in.operand < maxVariables;
+	switch (in.op) {
+	case Instruction::nop:
+	case Instruction::constant:
+	case Instruction::chop:
+	case Instruction::frame:
+		return true;
+	case Instruction::fetch:
+		return variable;
+	case Instruction::store:
+		return variable && in.opcode < Instruction::binops;
+	case Instruction::binop:
+		return in.opcode > Instruction::assign && in.opcode < Instruction::binops;
+	case Instruction::fcall:
+		return in.operand < 0 && -1 - in.operand < Intrinsic::count;
+	case Instruction::branch:
+		return in.operand >= 0 && in.operand <= static_cast<Word>(image.code.size());
+	default:
+		return false;
+	}
+}
+
+// The end of the block starting at 'start', and its reach: the most that
+// the stack pointer, less the call stack pointer, rises above where it
+// started at any push or FRAME, which is where the interpreter checks for
+// overflow.
+int measure(const Image& image, const std::vector<bool>& entered, const int start, int& reach) {
+	const int end = static_cast<int>(image.code.size());
+	std::vector<int> frames;   // the stack pointer at each FRAME
+	int sp = 0, csp = 0;
+	reach = 0;
+	for (int pc = start; pc < end; ++pc) {
+		const Instruction& in = image.code[pc];
+		if ((pc > start && entered[pc]) || !compilable(image, in))
+			return pc;
+		switch (in.op) {
+		case Instruction::fetch:
+		case Instruction::constant:
+			reach = std::max(reach, sp - csp + 1);
+			++sp;
+			break;
+		case Instruction::binop:
+		case Instruction::chop:
+			--sp;
+			break;
+		case Instruction::frame:
+			reach = std::max(reach, sp - csp + 1);
+			frames.push_back(sp);
+			--csp;
+			break;
+		case Instruction::fcall:
+			++csp;
+			if (frames.empty())
+				return pc + 1; // where the stack pointer ends up is not known here
+			sp = frames.back() + 1;
+			frames.pop_back();
+			break;
+		case Instruction::branch:
+			return pc + 1;
+		}
+	}
+	return end;
+}
+
+// What the blocks share: the way out to the Cpu, and the chains from one
+// block straight into another, patched once every block is in place.
+struct Layout {
+	std::vector<int> blockAt;           // per instruction and the end, or -1
+	std::vector<std::size_t> bodies;    // each block's code, past its way in
+	std::vector<std::pair<std::size_t, int> > chains; // jump, to block
+	std::size_t out;
+};
+
+typedef Jit::Machine M;
+static_assert(sizeof(M) <= 128, "Machine fields are addressed with 8-bit displacements");
+
+// Stores the registers back in the Machine and returns eax.
+void emitOut(Emitter& e) {
+	e.save(r12, offsetof(M, sp));
+	e.save(r15, offsetof(M, csp));
+	e.machine(0x89, false, rbp, offsetof(M, tos));
+	e.bytes({ 0x48, 0x83, 0xc4, 0x08 });                                 // add rsp, 8
+	e.bytes({ 0x41, 0x5f, 0x41, 0x5e, 0x41, 0x5d, 0x41, 0x5c, 0x5d, 0x5b }); // pop r15 ... rbx
+	e.bytes({ 0xc3 });
+}
+
+// Emits block 'b'.
+void emit(Emitter& e, const Image& image, const std::vector<Jit::Block>& blocks, const int b, Layout& layout) {
+	const int start = blocks[b].start;
+	const int stop = start + blocks[b].cost;
+
+	e.bytes({ 0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57 }); // push rbx ... r15
+	e.bytes({ 0x48, 0x83, 0xec, 0x08 });                                 // sub rsp, 8: aligned
+	e.bytes({ 0x48, 0x89, 0xfb });                                       // mov rbx, rdi
+	e.load(r12, offsetof(M, sp));
+	e.load(r15, offsetof(M, csp));
+	e.load(r13, offsetof(M, mark));
+	e.load(r14, offsetof(M, base));
+	e.machine(0x8b, false, rbp, offsetof(M, tos));
+	layout.bodies[b] = e.here();
+
+	// sub qword [rbx + cycles], cost
+	const auto charge = [&]() {
+		e.bytes({ 0x48, 0x81, 0x6b, static_cast<int>(offsetof(M, cycles)) });
+		e.word(static_cast<std::uint32_t>(stop - start));
+	};
+	// Goes on with 'pc': straight into its block if the Cpu would run the
+	// block now, otherwise back to the Cpu.
+	const auto leave = [&](const int pc) {
+		const int next = layout.blockAt[pc];
+		if (next >= 0) {
+			e.bytes({ 0x48, 0x81, 0x7b, static_cast<int>(offsetof(M, cycles)) }); // cmp qword [rbx + cycles], cost
+			e.word(static_cast<std::uint32_t>(blocks[next].cost));
+			const std::size_t few = e.jump8(0x7c);                               // jl
+			e.bytes({ 0x49, 0x8d, 0x84, 0x24 });                                 // lea rax, [r12 + reach * 4]
+			e.word(static_cast<std::uint32_t>(blocks[next].reach * 4));
+			e.bytes({ 0x4c, 0x39, 0xf8 });                                       // cmp rax, r15
+			const std::size_t full = e.jump8(0x73);                              // jae
+			layout.chains.push_back(std::make_pair(e.jump32({ 0xe9 }), next));
+			e.land8(few);
+			e.land8(full);
+		}
+		e.bytes({ 0xb8 });                                                       // mov eax, pc
+		e.word(static_cast<std::uint32_t>(pc));
+		e.patch32(e.jump32({ 0xe9 }), layout.out);
+	};
+
+	for (int pc = start; pc < stop; ++pc) {
+		const Instruction& in = image.code[pc];
+		const int bank = isExternal(in) ? r14 : r13;
+		const Word offset = in.operand & ~external;
+		switch (in.op) {
+		case Instruction::fetch:
+			e.spill();
+			e.variable(0x8b, rbp, bank, offset);               // mov ebp, variable
+			break;
+		case Instruction::constant:
+			e.spill();
+			e.bytes({ 0xbd });                                 // mov ebp, imm32
+			e.word(static_cast<std::uint32_t>(in.operand));
+			break;
+		case Instruction::store:
+			if (in.opcode == Instruction::assign) {
+				e.variable(0x89, rbp, bank, offset);           // mov variable, ebp
+				break;
+			}
+			e.variable(0x8b, rax, bank, offset);               // mov eax, variable
+			e.bytes({ 0x89, 0xe9 });                           // mov ecx, ebp
+			e.operate(in.opcode);
+			e.variable(0x89, rax, bank, offset);
+			e.bytes({ 0x89, 0xc5 });                           // mov ebp, eax
+			break;
+		case Instruction::binop:
+			e.bytes({ 0x49, 0x83, 0xec, 0x04 });               // sub r12, 4
+			e.bytes({ 0x41, 0x8b, 0x04, 0x24 });               // mov eax, [r12]
+			e.bytes({ 0x89, 0xe9 });                           // mov ecx, ebp
+			e.operate(in.opcode);
+			e.bytes({ 0x89, 0xc5 });                           // mov ebp, eax
+			break;
+		case Instruction::chop:
+			e.unspill();
+			break;
+		case Instruction::frame:
+			e.bytes({ 0x49, 0x83, 0xef, 0x04 });               // sub r15, 4
+			e.bytes({ 0x4c, 0x89, 0xe0, 0x4c, 0x29, 0xf0 });   // mov rax, r12; sub rax, r14
+			e.bytes({ 0x48, 0xc1, 0xf8, 0x02 });               // sar rax, 2
+			e.bytes({ 0x41, 0x89, 0x07 });                     // mov [r15], eax
+			break;
+		case Instruction::fcall: {
+			const int id = -1 - in.operand;
+			e.bytes({ 0x41, 0x89, 0x2c, 0x24 });               // mov [r12], ebp
+			e.bytes({ 0x49, 0x63, 0x07 });                     // movsxd rax, [r15]
+			e.bytes({ 0x49, 0x83, 0xc7, 0x04 });               // add r15, 4
+			e.bytes({ 0x49, 0x8d, 0x54, 0x86, 0x04 });         // lea rdx, [r14 + rax*4 + 4]: args
+			e.bytes({ 0x49, 0x8d, 0x44, 0x24, 0x04 });         // lea rax, [r12 + 4]
+			e.bytes({ 0x48, 0x29, 0xd0 });                     // sub rax, rdx: bytes pushed
+			e.bytes({ 0x49, 0x89, 0xd4 });                     // mov r12, rdx: sp after
+			if (intrinsics[id].arity > 0) {
+				// arguments that were not pushed are 0, from [rsp]
+				e.bytes({ 0x48, 0x83, 0xf8, 4 * intrinsics[id].arity }); // cmp rax, arity * 4
+				const std::size_t enough = e.jump8(0x7d);                 // jge
+				e.bytes({ 0x48, 0xc7, 0x04, 0x24, 0, 0, 0, 0 });          // mov qword [rsp], 0
+				e.bytes({ 0x48, 0x85, 0xc0 });                            // test rax, rax
+				const std::size_t none = e.jump8(0x7e);                   // jle
+				e.bytes({ 0x8b, 0x0a, 0x89, 0x0c, 0x24 });                // mov ecx, [rdx]; mov [rsp], ecx
+				e.land8(none);
+				e.bytes({ 0x48, 0x89, 0xe2 });                            // mov rdx, rsp
+				e.land8(enough);
+			}
+			e.load(rdi, offsetof(M, host));
+			e.load(rsi, offsetof(M, random));
+			e.bytes({ 0x48, 0xb8 });                           // mov rax, &intrinsics[id].call
+			e.quad(reinterpret_cast<std::uintptr_t>(&intrinsics[id].call));
+			e.bytes({ 0xff, 0x10 });                           // call [rax]
+			e.bytes({ 0x89, 0xc5 });                           // mov ebp, eax
+			break;
+		}
+		case Instruction::branch: {
+			e.bytes({ 0x89, 0xe8 });                           // mov eax, ebp
+			e.unspill();
+			charge();
+			e.bytes({ 0x85, 0xc0 });                           // test eax, eax
+			const std::size_t taken = e.jump32({ 0x0f, 0x84 }); // jz
+			leave(pc + 1);
+			e.land32(taken);
+			leave(in.operand);
+			break;
+		}
+		}
+	}
+	if (image.code[stop - 1].op != Instruction::branch) {
+		charge();
+		leave(stop);
+	}
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////
+// class Jit
+
+void Jit::release() {
+	if (m_memory)
+		munmap(m_memory, m_size);
+	m_memory = 0;
+	m_size = 0;
+	m_blocks.clear();
+}
+
+bool Jit::compile(const Image& image) {
+	release();
+	std::vector<bool> entered;
+	entries(image, entered);
+
+	const int end = static_cast<int>(image.code.size());
+	Layout layout;
+	layout.blockAt.assign(end + 1, -1);
+	for (int pc = 0; pc < end; ) {
+		int reach;
+		const int stop = measure(image, entered, pc, reach);
+		if (stop - pc < minimumCost) {
+			pc = std::max(stop, pc + 1);
+			continue;
+		}
+		const Block block = { pc, stop - pc, reach, 0 };
+		layout.blockAt[pc] = static_cast<int>(m_blocks.size());
+		m_blocks.push_back(block);
+		pc = stop;
+	}
+	if (m_blocks.empty())
+		return true;
+
+	std::vector<std::uint8_t> code;
+	Emitter e(code);
+	layout.out = e.here();
+	emitOut(e);
+	std::vector<std::size_t> offsets(m_blocks.size());
+	layout.bodies.resize(m_blocks.size());
+	for (std::size_t b = 0; b < m_blocks.size(); ++b) {
+		offsets[b] = e.here();
+		emit(e, image, m_blocks, static_cast<int>(b), layout);
+	}
+	for (std::size_t c = 0; c < layout.chains.size(); ++c)
+		e.patch32(layout.chains[c].first, layout.bodies[layout.chains[c].second]);
+
+	// written, then made executable instead
+	const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+	const std::size_t size = (code.size() + page - 1) / page * page;
+	void* const memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) {
+		m_blocks.clear();
+		return false;
+	}
+	std::memcpy(memory, code.data(), code.size());
+	if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+		munmap(memory, size);
+		m_blocks.clear();
+		return false;
+	}
+	m_memory = memory;
+	m_size = size;
+	for (std::size_t b = 0; b < m_blocks.size(); ++b)
+		m_blocks[b].entry = reinterpret_cast<Entry>(static_cast<std::uint8_t*>(memory) + offsets[b]);
+	return true;
+}
+
+#else
+
+void Jit::release() {
+	m_blocks.clear();
+}
+
+bool Jit::compile(const Image&) {
+	release();
+	return false;
+}
+
+#endif
+
+} // namespace Vm
@@ -0,0 +1,93 @@
+// Jit.h
+// Compiles CROBOTS basic blocks to x86-64 machine code, for the Cpu's
+// native tier.
+
+#ifndef Jit_h__
+#define Jit_h__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Bytecode.h"
+
+// The native tier needs x86-64, the System V calling convention and
+// mmap(); define JBOTS_JIT to 0 to leave it out anywhere.
+#if !defined(JBOTS_JIT)
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define JBOTS_JIT 1
+#else
+#define JBOTS_JIT 0
+#endif
+#endif
+
+namespace Vm {
+
+////////////////////////////////////////////////////////////
+//
+// class Jit
+//
+// Each basic block worth compiling -- a run of instructions entered only at
+// the top, ending at a BRANCH, a call to a robot function, a RETSUB or
+// another block's entry -- becomes a native function, stitched together
+// from one template per instruction.  Intrinsics are called through the
+// trampolines in the intrinsics[] table, like the interpreter calls them.
+//
+// A block takes the Cpu's registers in a Machine, and on the way out
+// stores them back, takes its instructions from the cycle counter and
+// returns the instruction to go on with.  Like a RegisterCode Segment, it
+// is only run when it would finish within the cycles left, and could not
+// overflow the stack where the interpreter would.
+
+class Jit {
+public:
+	// What a block reads and writes; native code knows the layout.
+	struct Machine {
+		Word* sp;
+		Word* csp;
+		Word* mark;
+		Word* base;
+		long long cycles;
+		Host* host;
+		std::uint32_t* random;
+		Word tos;
+	};
+
+	typedef int (*Entry)(Machine* machine);
+
+	struct Block {
+		int start;
+		int cost;              // its instructions
+		int reach;             // how far above the entry stack pointer it reaches
+		Entry entry;
+	};
+
+private:
+	std::vector<Block> m_blocks;
+	void* m_memory;            // executable
+	std::size_t m_size;
+
+	Jit(const Jit&);
+	Jit& operator=(const Jit&);
+
+	void release();
+
+public:
+	// Creators
+	Jit() : m_memory(0), m_size(0) {}
+	~Jit() { release(); }
+
+	// Accessors
+	// Whether this build and platform can run native code at all.
+	static bool available() { return JBOTS_JIT != 0; }
+	const std::vector<Block>& blocks() const { return m_blocks; }
+
+	// Modifiers
+	// Compiles 'image', replacing any earlier blocks.  Returns false, with
+	// no blocks, if executable memory could not be had.
+	bool compile(const Image& image);
+};
+
+} // namespace Vm
+
+#endif // Jit_h__
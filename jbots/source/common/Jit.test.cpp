@@ -0,0 +1,79 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <string>
+
+#include "../Shared/Compiler.h"
+#include "../Shared/Cpu.h"
+#include "../Shared/Jit.h"
+#include "../Shared/SampleRobots.h"
+#include "../Shared/Tiers.test.h"
+
+using TierTest::agree;
+
+SUITE(JitTestSuite) {
+
+TEST(CompilesBasicBlocks) {
+	Vm::Image image;
+	CHECK(Vm::compile(Vm::Samples::sniper, image));
+	Vm::Jit jit;
+	if (!Vm::Jit::available()) {
+		CHECK(!jit.compile(image));
+		CHECK(jit.blocks().empty());
+		return;
+	}
+	CHECK(jit.compile(image));
+	CHECK(!jit.blocks().empty());
+	for (std::size_t b = 0; b < jit.blocks().size(); ++b) {
+		CHECK(jit.blocks()[b].cost >= 3);
+		CHECK(jit.blocks()[b].entry != 0);
+	}
+}
+
+TEST(OperatorsMatchThePortableTier) {
+	for (int o = 0; o < TierTest::operatorCount; ++o) {
+		Vm::Image image;
+		CHECK(Vm::compile(TierTest::operatorProgram(o), image));
+		CHECK(agree(image, Vm::Cpu::native, 5000, 1));
+		CHECK(agree(image, Vm::Cpu::native, 5000, 200));
+	}
+}
+
+TEST(IntrinsicsWithMissingArguments) {
+	Vm::Image image;
+	CHECK(Vm::compile(
+		"int a, b, c, d;\n"
+		"main() { a = sqrt(); b = scan(10); c = rand(1000) + rand(); d = cannon(a, b, c); drive(); }\n", image));
+	CHECK(agree(image, Vm::Cpu::native, 10000, 1));
+	CHECK(agree(image, Vm::Cpu::native, 10000, 500));
+}
+
+TEST(SamplesMatchThePortableTier) {
+	const char* const robots[] = { Vm::Samples::rabbit, Vm::Samples::counter, Vm::Samples::rook, Vm::Samples::sniper };
+	for (int r = 0; r < 4; ++r) {
+		Vm::Image image;
+		CHECK(Vm::compile(robots[r], image));
+		CHECK(agree(image, Vm::Cpu::native, 200000, 1));
+		// stopping anywhere, inside a block or not
+		CHECK(agree(image, Vm::Cpu::native, 20000, 5000));
+	}
+}
+
+TEST(OverflowsWhereThePortableTierDoes) {
+	// recursion until the stack is full, with frames of every size so that
+	// it fills up at every push and FRAME
+	std::string locals = "a, v0";
+	for (int k = 0; k < 8; ++k, locals += ", v" + std::to_string(k)) {
+		Vm::Image image;
+		CHECK(Vm::compile(
+			"int depth, x;\n"
+			"main() { depth = 0; x = f(1); }\n"
+			"f(n) int n; { int " + locals + "; depth = n;\n"
+			"  a = 1 + (2 + (3 + (4 + (5 + damage())))) + sqrt(6 + n) * 3;\n"
+			"  while (v0 < 2) { v0 += 1; a = a + (1 + (2 + (3 + (4 + (5 + (6 + (7 + n))))))); }\n"
+			"  return (f(n + 1) + a); }\n", image));
+		CHECK(agree(image, Vm::Cpu::native, 100000, 1));
+		CHECK(agree(image, Vm::Cpu::native, 100000, 3000));
+	}
+}
+
+}
@@ -0,0 +1,92 @@
+// MissilePool.cpp
+// Fixed-capacity storage for the missiles in flight.
+
+#include "MissilePool.h"
+
+#include "Trig.h"
+
+namespace Server {
+
+////////////////////////////////////////////////////////////
+// class MissilePool
+
+MissilePool::MissilePool(const std::size_t owners, const int reloadTicks)
+	: m_slots(owners * perOwner), m_inFlight(owners, 0), m_reload(owners, 0),
+	  m_reloadTicks(reloadTicks)
+{
+	for (std::size_t i = 0; i < m_slots.size(); ++i) {
+		m_slots[i].generation = 0;
+		m_slots[i].live = false;
+	}
+	clear();
+}
+
+MissilePool::Handle MissilePool::handle(const std::size_t slot) const {
+	const Handle h = { static_cast<std::uint32_t>(slot), m_slots[slot].generation };
+	return h;
+}
+
+MissilePool::Handle MissilePool::fire(const Owner owner, const Geometry::Point& origin,
+                                      const Geometry::Angle& heading, const double range)
+{
+	if (!ready(owner) || m_free == endOfList) {
+		const Handle none = { endOfList, 0 };
+		return none;
+	}
+	const std::uint32_t slot = m_free;
+	Slot& s = m_slots[slot];
+	m_free = s.nextFree;
+	s.nextFree = endOfList;
+	s.live = true;
+
+	Missile& m = s.missile;
+	m.origin = origin;
+	m.heading = heading;
+	m.heading.normalize();
+	double sin, cos;
+	Geometry::fastSinCos(m.heading.as_r(), sin, cos);
+	m.direction = Geometry::Point(cos, sin);
+	m.range = range;
+	m.travelled = 0.0;
+	m.owner = owner;
+
+	++m_size;
+	++m_inFlight[owner];
+	m_reload[owner] = m_reloadTicks;
+	return handle(slot);
+}
+
+void MissilePool::explode(const Handle& h) {
+	if (!valid(h))
+		return;
+	Slot& s = m_slots[h.slot];
+	--m_inFlight[s.missile.owner];
+	--m_size;
+	s.live = false;
+	++s.generation;
+	s.nextFree = m_free;
+	m_free = h.slot;
+}
+
+void MissilePool::tick() {
+	for (std::size_t i = 0; i < m_reload.size(); ++i)
+		m_reload[i] -= m_reload[i] > 0;
+}
+
+void MissilePool::clear() {
+	// thread every slot onto the free list, lowest first
+	for (std::size_t i = 0; i < m_slots.size(); ++i) {
+		if (m_slots[i].live)
+			++m_slots[i].generation;
+		m_slots[i].live = false;
+		m_slots[i].nextFree = i + 1 < m_slots.size() ? static_cast<std::uint32_t>(i + 1) : endOfList;
+	}
+	m_free = m_slots.empty() ? endOfList : 0;
+	m_size = 0;
+	for (std::size_t i = 0; i < m_inFlight.size(); ++i) {
+		m_inFlight[i] = 0;
+		m_reload[i] = 0;
+	}
+}
+
+} // namespace Server
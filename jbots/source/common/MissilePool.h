@@ -0,0 +1,102 @@
+// MissilePool.h
+// Fixed-capacity storage for the missiles in flight, with the CROBOTS
+// cannon's reload accounting.
+
+#ifndef MissilePool_h__
+#define MissilePool_h__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Geometry.h"
+
+namespace Server {
+
+////////////////////////////////////////////////////////////
+//
+// class MissilePool
+//
+// Room for exactly two missiles per robot, allocated up front; a robot with
+// two missiles in flight, or whose cannon fired within the last reloadTicks
+// ticks, cannot fire.  Free slots are kept on a list threaded through the
+// slots themselves, so fire() and explode() are O(1) and never allocate.
+//
+// A Handle names a missile by slot and generation.  Every explode() bumps
+// the slot's generation, so a handle to a missile that has exploded stays
+// invalid even after its slot is reused.
+
+class MissilePool {
+public:
+	typedef std::size_t Owner;
+	static const int perOwner = 2;
+	static const int defaultReloadTicks = 15;
+
+	struct Handle {
+		std::uint32_t slot;
+		std::uint32_t generation;
+	};
+
+	struct Missile {
+		Geometry::Point origin;
+		Geometry::Point direction; // unit vector along the heading
+		Geometry::Angle heading;
+		double range;              // distance to fly before exploding
+		double travelled;
+		Owner owner;
+
+		Geometry::Point position() const { return origin + direction * travelled; }
+	};
+
+private:
+	static const std::uint32_t endOfList = static_cast<std::uint32_t>(-1);
+
+	struct Slot {
+		Missile missile;
+		std::uint32_t generation;
+		std::uint32_t nextFree;    // endOfList if last, or if the slot is live
+		bool live;
+	};
+
+	std::vector<Slot> m_slots;
+	std::uint32_t m_free;          // first free slot, or endOfList
+	std::size_t m_size;
+	std::vector<unsigned char> m_inFlight; // per owner
+	std::vector<int> m_reload;             // ticks until the owner can fire
+	int m_reloadTicks;
+
+public:
+	// Creators
+	explicit MissilePool(const std::size_t owners, const int reloadTicks = defaultReloadTicks);
+
+	// Accessors
+	std::size_t capacity() const { return m_slots.size(); }
+	std::size_t size() const { return m_size; }
+	bool valid(const Handle& h) const {
+		return h.slot < m_slots.size() && m_slots[h.slot].live && m_slots[h.slot].generation == h.generation;
+	}
+	const Missile& operator[](const Handle& h) const { return m_slots[h.slot].missile; }
+	int inFlight(const Owner owner) const { return m_inFlight[owner]; }
+	int reloading(const Owner owner) const { return m_reload[owner]; } // ticks
+	bool ready(const Owner owner) const { return m_inFlight[owner] < perOwner && m_reload[owner] == 0; }
+
+	// Slots can be walked directly, for the once-per-tick pass over every
+	// missile: slots 0 to capacity() - 1, of which live() ones hold missiles.
+	bool live(const std::size_t slot) const { return m_slots[slot].live; }
+	const Missile& missile(const std::size_t slot) const { return m_slots[slot].missile; }
+	Missile& missile(const std::size_t slot) { return m_slots[slot].missile; }
+	Handle handle(const std::size_t slot) const;
+
+	// Modifiers
+	// Fires a missile on behalf of 'owner', or returns an invalid handle if
+	// the owner is not ready().
+	Handle fire(const Owner owner, const Geometry::Point& origin,
+	            const Geometry::Angle& heading, const double range);
+	void explode(const Handle& h); // does nothing if h is not valid()
+	void tick();                   // counts down every reload timer
+	void clear();
+};
+
+} // namespace Server
+
+#endif // MissilePool_h__
@@ -0,0 +1,72 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include "../Shared/MissilePool.h"
+
+namespace {
+
+Geometry::Angle degrees(const double d) { return Geometry::Angle::d2r(d); }
+
+}
+
+SUITE(MissilePoolTestSuite) {
+
+TEST(FireAndExplode) {
+	Server::MissilePool pool(3, 0);
+	CHECK_EQUAL(6u, pool.capacity());
+
+	const Server::MissilePool::Handle a = pool.fire(1, Geometry::Point(10, 20), degrees(450), 100);
+	CHECK(pool.valid(a));
+	CHECK_EQUAL(1u, pool.size());
+	CHECK_EQUAL(1u, pool[a].owner);
+	CHECK(pool[a].heading.near(degrees(90), 1e-9));
+	CHECK(pool[a].direction.near(Geometry::Point(0, 1), 1e-6));
+
+	pool.explode(a);
+	CHECK(!pool.valid(a));
+	CHECK_EQUAL(0u, pool.size());
+	CHECK_EQUAL(0, pool.inFlight(1));
+	pool.explode(a); // a second time does nothing
+	CHECK_EQUAL(0, pool.inFlight(1));
+
+	// the slot is reused, but the old handle stays invalid
+	const Server::MissilePool::Handle b = pool.fire(2, Geometry::Point(0, 0), degrees(0), 100);
+	CHECK_EQUAL(a.slot, b.slot);
+	CHECK(pool.valid(b));
+	CHECK(!pool.valid(a));
+}
+
+TEST(TwoInFlightPerOwner) {
+	Server::MissilePool pool(2, 0);
+	CHECK(pool.valid(pool.fire(0, Geometry::Point(), 0.0, 100)));
+	CHECK(pool.valid(pool.fire(0, Geometry::Point(), 0.0, 100)));
+	CHECK(!pool.ready(0));
+	CHECK(!pool.valid(pool.fire(0, Geometry::Point(), 0.0, 100)));
+	CHECK(pool.valid(pool.fire(1, Geometry::Point(), 0.0, 100)));
+	CHECK(pool.valid(pool.fire(1, Geometry::Point(), 0.0, 100)));
+	CHECK_EQUAL(4u, pool.size());
+
+	std::size_t live = 0;
+	for (std::size_t slot = 0; slot < pool.capacity(); ++slot)
+		live += pool.live(slot);
+	CHECK_EQUAL(4u, live);
+
+	pool.clear();
+	CHECK_EQUAL(0u, pool.size());
+	CHECK(pool.ready(0));
+}
+
+TEST(ReloadTimer) {
+	Server::MissilePool pool(1, 2);
+	CHECK(pool.ready(0));
+	CHECK(pool.valid(pool.fire(0, Geometry::Point(), 0.0, 100)));
+	CHECK_EQUAL(2, pool.reloading(0));
+	CHECK(!pool.ready(0));
+	pool.tick();
+	CHECK(!pool.ready(0));
+	pool.tick();
+	CHECK(pool.ready(0));
+	pool.tick();
+	CHECK_EQUAL(0, pool.reloading(0));
+}
+
+}
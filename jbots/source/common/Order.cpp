@@ -0,0 +1,105 @@
+// Order.cpp
+// The per-tick command buffer through which bots act on the Arena.
+
+#include "Order.h"
+
+#include <algorithm> // sort()
+
+namespace Server {
+
+namespace {
+
+// The pass an order is applied in, then the robot, then submission order.
+inline bool before(const Order& a, const Order& b) {
+	if (a.type != b.type)
+		return a.type < b.type;
+	if (a.robot != b.robot)
+		return a.robot < b.robot;
+	return a.ticket < b.ticket;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////
+// struct Order
+
+Order Order::make(const Type type, const Arena::Id robot, const double parameter1, const double parameter2) {
+	Order order;
+	order.parameter1 = parameter1;
+	order.parameter2 = parameter2;
+	order.result = 0.0;
+	order.robot = static_cast<std::uint32_t>(robot);
+	order.ticket = 0;
+	order.type = static_cast<std::uint8_t>(type);
+	return order;
+}
+
+////////////////////////////////////////////////////////////
+// class OrderBuffer
+
+OrderBuffer::OrderBuffer(const std::size_t capacity)
+	: m_position(capacity), m_applied(false)
+{
+	m_orders.reserve(capacity);
+}
+
+double OrderBuffer::result(const Ticket ticket) const {
+	if (!m_applied || ticket >= m_orders.size())
+		return 0.0;
+	return m_orders[m_position[ticket]].result;
+}
+
+OrderBuffer::Ticket OrderBuffer::push(const Order& order) {
+	if (m_orders.size() == capacity() || m_applied)
+		return noTicket;
+	const Ticket ticket = static_cast<Ticket>(m_orders.size());
+	m_orders.push_back(order); // within the capacity reserved for it
+	m_orders.back().ticket = ticket;
+	m_orders.back().result = 0.0;
+	return ticket;
+}
+
+OrderBuffer::Ticket OrderBuffer::drive(const Arena::Id robot, const Geometry::Angle& heading, const double speed) {
+	return push(Order::make(Order::drive, robot, heading.as_r(), speed));
+}
+
+OrderBuffer::Ticket OrderBuffer::fire(const Arena::Id robot, const Geometry::Angle& direction, const double range) {
+	return push(Order::make(Order::fire, robot, direction.as_r(), range));
+}
+
+OrderBuffer::Ticket OrderBuffer::scan(const Arena::Id robot, const Geometry::Angle& direction,
+                                      const Geometry::Angle& resolution)
+{
+	return push(Order::make(Order::scan, robot, direction.as_r(), resolution.as_r()));
+}
+
+void OrderBuffer::apply(Arena& arena) {
+	std::sort(m_orders.begin(), m_orders.end(), before);
+	for (std::size_t i = 0; i < m_orders.size(); ++i) {
+		Order& order = m_orders[i];
+		m_position[order.ticket] = static_cast<std::uint32_t>(i);
+		if (order.robot >= arena.robots())
+			continue;
+		switch (order.type) {
+		case Order::drive:
+			arena.drive(order.robot, order.parameter1, order.parameter2);
+			break;
+		case Order::fire:
+			order.result = arena.launch(order.robot, order.parameter1, order.parameter2) ? 1.0 : 0.0;
+			break;
+		case Order::scan:
+			order.result = arena.scan(order.robot, order.parameter1, order.parameter2);
+			break;
+		default:
+			break;
+		}
+	}
+	m_applied = true;
+}
+
+void OrderBuffer::clear() {
+	m_orders.clear();
+	m_applied = false;
+}
+
+} // namespace Server
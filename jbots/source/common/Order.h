@@ -0,0 +1,124 @@
+// Order.h
+// The per-tick command buffer through which bots act on the Arena.
+
+#ifndef Order_h__
+#define Order_h__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Arena.h"
+#include "Geometry.h"
+
+namespace Server {
+
+////////////////////////////////////////////////////////////
+//
+// struct Order
+//
+// One thing a bot asks for in a tick.  A plain 40-byte value: the engine
+// copies and sorts these, and nothing here points anywhere.  The parameters
+// are kept at full precision, so an order does exactly what the same call
+// made straight on the Arena would.  CROBOTS sets heading and speed
+// together with drive(), so one drive order does both.
+
+struct Order {
+	enum Type { nothing, drive, fire, scan };
+
+	double parameter1;     // drive: heading, fire and scan: direction, in radians
+	double parameter2;     // drive: speed in percent, fire: range, scan: resolution
+	double result;         // after apply(): fire 1 or 0, scan the range or 0
+	std::uint32_t robot;
+	std::uint32_t ticket;  // submission order, set by OrderBuffer::push()
+	std::uint8_t type;
+
+	// An order of 'type' on robot's behalf, with no result and no ticket yet.
+	static Order make(const Type type, const Arena::Id robot, const double parameter1, const double parameter2);
+};
+
+////////////////////////////////////////////////////////////
+//
+// class OrderBuffer
+//
+// Collects every bot's orders for a tick, then applies them all at once in
+// a fixed order: every drive, then every fire, then every scan, each pass
+// by robot Id and then in the order submitted.  So no bot's orders can see
+// another's from the same tick half-applied, and the outcome does not
+// depend on the order in which bots were asked.  The buffer is sized up
+// front and sorted in place; nothing allocates during a match.
+//
+// push() returns a Ticket, by which the result of a fire or scan can be
+// read back after apply().
+
+class OrderBuffer {
+public:
+	typedef std::uint32_t Ticket;
+	static const Ticket noTicket = static_cast<Ticket>(-1);
+
+private:
+	std::vector<Order> m_orders;
+	std::vector<std::uint32_t> m_position; // ticket -> index, after apply()
+	bool m_applied;
+
+public:
+	// Creators
+	explicit OrderBuffer(const std::size_t capacity);
+
+	// Accessors
+	std::size_t size() const { return m_orders.size(); }
+	std::size_t capacity() const { return m_position.size(); }
+	bool applied() const { return m_applied; }
+	const Order& operator[](const std::size_t i) const { return m_orders[i]; }
+
+	// The result of an applied order: 1 or 0 for a fire, the range or 0 for
+	// a scan, and 0 for anything else.
+	double result(const Ticket ticket) const;
+
+	// Modifiers
+	// Queues an order, or returns noTicket if the buffer is full.
+	Ticket push(const Order& order);
+	Ticket drive(const Arena::Id robot, const Geometry::Angle& heading, const double speed);
+	Ticket fire(const Arena::Id robot, const Geometry::Angle& direction, const double range);
+	Ticket scan(const Arena::Id robot, const Geometry::Angle& direction, const Geometry::Angle& resolution);
+
+	// Sorts the orders into passes and applies them.  The orders stay in the
+	// buffer, sorted and with their results, until clear().
+	void apply(Arena& arena);
+	void clear();
+};
+
+////////////////////////////////////////////////////////////
+//
+// class Orders
+//
+// One bot's view of an OrderBuffer: everything it queues is on its own
+// behalf.
+
+class Orders {
+private:
+	OrderBuffer* m_buffer;
+	Arena::Id m_robot;
+
+public:
+	// Creators
+	Orders(OrderBuffer& buffer, const Arena::Id robot) : m_buffer(&buffer), m_robot(robot) {}
+
+	// Accessors
+	Arena::Id robot() const { return m_robot; }
+
+	// Modifiers
+	OrderBuffer::Ticket drive(const Geometry::Angle& heading, const double speed) {
+		return m_buffer->drive(m_robot, heading, speed);
+	}
+	OrderBuffer::Ticket fire(const Geometry::Angle& direction, const double range) {
+		return m_buffer->fire(m_robot, direction, range);
+	}
+	OrderBuffer::Ticket scan(const Geometry::Angle& direction, const Geometry::Angle& resolution) {
+		return m_buffer->scan(m_robot, direction, resolution);
+	}
+};
+
+} // namespace Server
+
+#endif // Order_h__
@@ -0,0 +1,148 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include "../Shared/Arena.h"
+#include "../Shared/Order.h"
+
+namespace {
+
+Geometry::Angle degrees(const double d) { return Geometry::Angle::d2r(d); }
+
+}
+
+SUITE(OrderTestSuite) {
+
+TEST(OrderIsCompact) {
+	CHECK_EQUAL(40u, sizeof(Server::Order));
+}
+
+TEST(ApplySortsIntoPasses) {
+	Server::Arena arena(2, 0);
+	const Server::Arena::Id a = arena.enter(Geometry::Point(100, 100));
+	const Server::Arena::Id b = arena.enter(Geometry::Point(300, 100));
+
+	Server::OrderBuffer buffer(8);
+	Server::Orders first(buffer, a), second(buffer, b);
+	second.scan(degrees(180), degrees(5));
+	second.fire(degrees(180), 100);
+	const Server::OrderBuffer::Ticket found = first.scan(degrees(0), degrees(5));
+	const Server::OrderBuffer::Ticket hit = second.fire(degrees(180), 200);
+	first.drive(degrees(90), 50);
+	const Server::OrderBuffer::Ticket refused = second.fire(degrees(180), 300);
+	CHECK_EQUAL(6u, buffer.size());
+	CHECK(!buffer.applied());
+
+	buffer.apply(arena);
+	CHECK(buffer.applied());
+	const Server::Order::Type passes[] = { Server::Order::drive, Server::Order::fire, Server::Order::fire,
+	                                       Server::Order::fire, Server::Order::scan, Server::Order::scan };
+	const Server::Arena::Id robots[] = { a, b, b, b, a, b };
+	const Server::OrderBuffer::Ticket tickets[] = { 4, 1, 3, 5, 2, 0 };
+	for (std::size_t i = 0; i < buffer.size(); ++i) {
+		CHECK_EQUAL(passes[i], buffer[i].type);
+		CHECK_EQUAL(robots[i], buffer[i].robot);
+		CHECK_EQUAL(tickets[i], buffer[i].ticket);
+	}
+
+	// b fires in the order it asked, and only two missiles fit in flight
+	CHECK_EQUAL(1.0, buffer.result(hit));
+	CHECK_EQUAL(0.0, buffer.result(refused));
+	CHECK_EQUAL(2, arena.missiles().inFlight(b));
+	CHECK_CLOSE(200.0, buffer.result(found), 1e-4);
+	CHECK_CLOSE(200.0, buffer.result(0), 1e-4);
+	CHECK_EQUAL(2, arena.stats(b).shots);
+	CHECK_EQUAL(1, arena.stats(a).scans);
+
+	// nothing more is taken until the buffer is cleared
+	CHECK_EQUAL(Server::OrderBuffer::noTicket, first.drive(degrees(0), 100));
+	buffer.clear();
+	CHECK_EQUAL(0u, buffer.size());
+	CHECK_EQUAL(0u, first.drive(degrees(0), 100));
+}
+
+TEST(ResultsDoNotDependOnSubmissionOrder) {
+	Server::Arena one(3, 0), other(3, 0);
+	for (int i = 0; i < 3; ++i) {
+		one.enter(Geometry::Point(100 + 200 * i, 100));
+		other.enter(Geometry::Point(100 + 200 * i, 100));
+	}
+
+	// every robot fires twice, so the third shot at robot 1 is refused
+	// whichever robot asked first
+	Server::OrderBuffer forward(16), backward(16);
+	for (Server::Arena::Id i = 0; i < 3; ++i)
+		forward.fire(i, degrees(0), 100 * (i + 1));
+	for (Server::Arena::Id i = 3; i-- > 0; )
+		backward.fire(i, degrees(0), 100 * (i + 1));
+	for (Server::Arena::Id i = 0; i < 3; ++i) {
+		forward.fire(i, degrees(90), 50);
+		backward.fire(i, degrees(90), 50);
+	}
+	forward.fire(1, degrees(0), 10);
+	backward.fire(1, degrees(0), 10);
+	forward.apply(one);
+	backward.apply(other);
+
+	CHECK_EQUAL(forward.size(), backward.size());
+	for (std::size_t i = 0; i < forward.size(); ++i) {
+		CHECK_EQUAL(forward[i].robot, backward[i].robot);
+		CHECK_EQUAL(forward[i].parameter2, backward[i].parameter2);
+		CHECK_EQUAL(forward[i].result, backward[i].result);
+	}
+	for (Server::Arena::Id i = 0; i < 3; ++i)
+		CHECK_EQUAL(one.missiles().inFlight(i), other.missiles().inFlight(i));
+	CHECK_EQUAL(0.0, forward.result(6));
+}
+
+TEST(FullBufferRefusesOrders) {
+	Server::Arena arena(1);
+	const Server::Arena::Id a = arena.enter(Geometry::Point(500, 500));
+	Server::OrderBuffer buffer(2);
+	CHECK_EQUAL(0u, buffer.drive(a, degrees(0), 100));
+	CHECK_EQUAL(1u, buffer.drive(a, degrees(90), 40));
+	CHECK_EQUAL(Server::OrderBuffer::noTicket, buffer.drive(a, degrees(180), 10));
+
+	// the later drive wins, exactly as if it had been the only one
+	Server::Arena direct(1);
+	direct.enter(Geometry::Point(500, 500));
+	direct.drive(a, degrees(90), 40);
+	buffer.apply(arena);
+	arena.tick();
+	direct.tick();
+	CHECK_EQUAL(direct.position(a).x(), arena.position(a).x());
+	CHECK_EQUAL(direct.position(a).y(), arena.position(a).y());
+	CHECK(arena.position(a).y() > 500.0);
+}
+
+TEST(OrdersDoWhatDirectCallsDo) {
+	// headings and ranges that no float holds exactly
+	Server::Arena ordered(2, 0), direct(2, 0);
+	for (int i = 0; i < 2; ++i) {
+		ordered.enter(Geometry::Point(123.456 + 400 * i, 234.567 + 300 * i));
+		direct.enter(Geometry::Point(123.456 + 400 * i, 234.567 + 300 * i));
+	}
+	const Geometry::Angle toB = Geometry::Angle(0.6435011087932844);
+	Server::OrderBuffer buffer(8);
+	for (int t = 0; t < 40; ++t) {
+		buffer.clear();
+		buffer.drive(0, Geometry::Angle(1.2345678901234567), 33.3);
+		buffer.drive(1, degrees(217.3), 71.7);
+		const Server::OrderBuffer::Ticket shot = buffer.fire(0, toB, 456.789);
+		const Server::OrderBuffer::Ticket found = buffer.scan(0, toB, degrees(3.3));
+		buffer.apply(ordered);
+
+		direct.drive(0, Geometry::Angle(1.2345678901234567), 33.3);
+		direct.drive(1, degrees(217.3), 71.7);
+		CHECK_EQUAL(direct.launch(0, toB, 456.789) ? 1.0 : 0.0, buffer.result(shot));
+		CHECK_EQUAL(direct.scan(0, toB, degrees(3.3)), buffer.result(found));
+
+		ordered.tick();
+		direct.tick();
+		for (Server::Arena::Id i = 0; i < 2; ++i) {
+			CHECK_EQUAL(direct.position(i).x(), ordered.position(i).x());
+			CHECK_EQUAL(direct.position(i).y(), ordered.position(i).y());
+			CHECK_EQUAL(direct.damage(i), ordered.damage(i));
+		}
+	}
+}
+
+}
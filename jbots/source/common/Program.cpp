@@ -0,0 +1,117 @@
+// Program.cpp
+// Native bots written as straight-line C++20 coroutines.
+
+#include "Program.h"
+
+#if JBOTS_COROUTINES
+
+namespace Client {
+
+////////////////////////////////////////////////////////////
+// class FramePool
+
+FramePool::FramePool(const std::size_t frames, const std::size_t frameBytes)
+	: m_blockBytes((frameBytes + 2 * header - 1) / header * header),
+	  m_capacity(frames), m_size(0), m_free(0)
+{
+	m_storage.resize(frames * m_blockBytes / sizeof(std::max_align_t));
+	unsigned char* const base = reinterpret_cast<unsigned char*>(m_storage.data());
+	for (std::size_t i = frames; i-- > 0; ) {
+		void* const block = base + i * m_blockBytes;
+		*static_cast<void**>(block) = m_free;
+		m_free = block;
+	}
+}
+
+void* FramePool::allocate(const std::size_t bytes) noexcept {
+	if (bytes > frameBytes() || !m_free)
+		return 0;
+	void* const block = m_free;
+	m_free = *static_cast<void**>(block);
+	*static_cast<FramePool**>(block) = this;
+	++m_size;
+	return static_cast<unsigned char*>(block) + header;
+}
+
+void FramePool::deallocate(void* frame) noexcept {
+	void* const block = static_cast<unsigned char*>(frame) - header;
+	FramePool* const pool = *static_cast<FramePool**>(block);
+	*static_cast<void**>(block) = pool->m_free;
+	pool->m_free = block;
+	--pool->m_size;
+}
+
+////////////////////////////////////////////////////////////
+// class Program
+
+Program& Program::operator=(Program&& other) noexcept {
+	if (this != &other) {
+		if (m_frame)
+			m_frame.destroy();
+		m_frame = other.m_frame;
+		other.m_frame = nullptr;
+	}
+	return *this;
+}
+
+std::coroutine_handle<> Program::release() {
+	const std::coroutine_handle<> frame = m_frame;
+	m_frame = nullptr;
+	return frame;
+}
+
+////////////////////////////////////////////////////////////
+// class Robot
+
+void Robot::queue(const Server::Order& order) {
+	m_ticket = m_scheduler->m_orders.push(order);
+}
+
+Robot::Request Robot::request(const Server::Order::Type type, const double parameter1, const double parameter2) {
+	return Request(*this, Server::Order::make(type, m_id, parameter1, parameter2));
+}
+
+////////////////////////////////////////////////////////////
+// class Scheduler
+
+Scheduler::Scheduler(Server::Arena& arena, const std::size_t frameBytes)
+	: m_arena(&arena), m_frames(arena.capacity(), frameBytes), m_orders(arena.capacity()),
+	  m_slots(arena.capacity(), noSlot), m_running(0)
+{
+	m_robots.reserve(arena.capacity());
+}
+
+Scheduler::~Scheduler() {
+	for (std::size_t i = 0; i < m_robots.size(); ++i)
+		if (m_robots[i].m_frame)
+			m_robots[i].m_frame.destroy();
+}
+
+void Scheduler::tick() {
+	m_orders.clear();
+	for (std::size_t i = 0; i < m_robots.size(); ++i) {
+		Robot& robot = m_robots[i];
+		if (!robot.m_frame)
+			continue;
+		robot.m_ticket = Server::OrderBuffer::noTicket;
+		if (m_arena->alive(robot.m_id))
+			robot.m_frame.resume(); // runs to its next co_await, which queues one order
+		if (robot.m_frame.done() || !m_arena->alive(robot.m_id)) {
+			robot.m_frame.destroy();
+			robot.m_frame = nullptr;
+			--m_running;
+		}
+	}
+
+	m_orders.apply(*m_arena);
+	for (std::size_t i = 0; i < m_robots.size(); ++i) {
+		Robot& robot = m_robots[i];
+		if (robot.m_ticket != Server::OrderBuffer::noTicket)
+			robot.m_result = m_orders.result(robot.m_ticket);
+	}
+	m_arena->tick();
+}
+
+} // namespace Client
+
+#endif // JBOTS_COROUTINES
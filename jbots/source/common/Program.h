@@ -0,0 +1,269 @@
+// Program.h
+// Native bots written as straight-line C++20 coroutines.
+
+#ifndef Program_h__
+#define Program_h__
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define JBOTS_COROUTINES 1
+#endif
+#endif
+
+#if JBOTS_COROUTINES
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <vector>
+
+#include "Arena.h"
+#include "Geometry.h"
+#include "Order.h"
+
+namespace Client {
+
+class Robot;
+
+////////////////////////////////////////////////////////////
+//
+// class FramePool
+//
+// Fixed-size blocks for coroutine frames, allocated up front and kept on a
+// free list threaded through the blocks themselves.  Each block starts
+// with a pointer back to its pool, so a frame can be returned without
+// knowing where it came from.
+
+class FramePool {
+public:
+	static const std::size_t defaultFrameBytes = 1024;
+
+private:
+	static const std::size_t header = alignof(std::max_align_t);
+
+	std::vector<std::max_align_t> m_storage;
+	std::size_t m_blockBytes;    // header included
+	std::size_t m_capacity;
+	std::size_t m_size;
+	void* m_free;                // first free block, or 0
+
+public:
+	// Creators
+	FramePool(const std::size_t frames, const std::size_t frameBytes = defaultFrameBytes);
+	FramePool(const FramePool&) = delete;
+	FramePool& operator=(const FramePool&) = delete;
+
+	// Accessors
+	std::size_t capacity() const { return m_capacity; }
+	std::size_t size() const { return m_size; }
+	std::size_t frameBytes() const { return m_blockBytes - header; }
+
+	// Modifiers
+	// A frame of 'bytes' bytes, or 0 if it is too big or the pool is empty.
+	void* allocate(const std::size_t bytes) noexcept;
+	static void deallocate(void* frame) noexcept;
+};
+
+////////////////////////////////////////////////////////////
+//
+// class Program
+//
+// What a bot's coroutine returns.  A bot is written as a function taking
+// its Robot first,
+//
+//	Client::Program sitter(Client::Robot& self) {
+//		for (;;)
+//			if (double range = co_await self.scan(0, 0.1))
+//				co_await self.fire(0, range);
+//	}
+//
+// and every co_await queues one order and sleeps until the tick that
+// applies it is over.  The frame comes from the Robot's Scheduler's
+// FramePool; a Program is empty if the pool could not hold it.
+
+class Program {
+public:
+	struct promise_type {
+		Program get_return_object() { return Program(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		static Program get_return_object_on_allocation_failure() { return Program(); }
+		std::suspend_always initial_suspend() noexcept { return std::suspend_always(); }
+		std::suspend_always final_suspend() noexcept { return std::suspend_always(); }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+
+		template <typename... Args>
+		static void* operator new(const std::size_t bytes, Robot& self, Args&&...) noexcept;
+		static void operator delete(void* frame) noexcept { FramePool::deallocate(frame); }
+	};
+
+private:
+	std::coroutine_handle<promise_type> m_frame;
+
+	explicit Program(const std::coroutine_handle<promise_type> frame) : m_frame(frame) {}
+
+public:
+	// Creators
+	Program() : m_frame() {}
+	Program(Program&& other) noexcept : m_frame(other.m_frame) { other.m_frame = nullptr; }
+	Program& operator=(Program&& other) noexcept;
+	~Program() { if (m_frame) m_frame.destroy(); }
+
+	// Accessors
+	explicit operator bool() const { return static_cast<bool>(m_frame); }
+
+	// Modifiers
+	// Hands the frame over to the caller, who must destroy() it.
+	std::coroutine_handle<> release();
+};
+
+class Scheduler;
+
+////////////////////////////////////////////////////////////
+//
+// class Robot
+//
+// A Program's view of its robot: the state it can read at any time, and
+// the orders it can co_await.  scan() resumes with the range, or 0;
+// fire() with 1 if a missile left, else 0; drive() with 0.
+
+class Robot {
+	friend class Scheduler;
+
+public:
+	// The awaitable every order returns.
+	class Request {
+	private:
+		Robot* m_robot;
+		Server::Order m_order;
+
+	public:
+		Request(Robot& robot, const Server::Order& order) : m_robot(&robot), m_order(order) {}
+		bool await_ready() const { return false; }
+		void await_suspend(std::coroutine_handle<>) { m_robot->queue(m_order); }
+		double await_resume() const { return m_robot->m_result; }
+	};
+
+private:
+	Scheduler* m_scheduler;
+	Server::Arena::Id m_id;
+	std::coroutine_handle<> m_frame;
+	Server::OrderBuffer::Ticket m_ticket; // this tick's order
+	double m_result;                      // the last order's
+
+	void queue(const Server::Order& order);
+	Request request(const Server::Order::Type type, const double parameter1, const double parameter2);
+
+public:
+	// Creators
+	Robot(Scheduler& scheduler, const Server::Arena::Id id)
+		: m_scheduler(&scheduler), m_id(id), m_frame(), m_ticket(Server::OrderBuffer::noTicket), m_result(0.0) {}
+
+	// Accessors
+	Server::Arena::Id id() const { return m_id; }
+	FramePool& frames() const;
+	const Server::Arena& arena() const;
+	Geometry::Point position() const { return arena().position(m_id); }
+	double speed() const { return arena().speed(m_id); }
+	int damage() const { return arena().damage(m_id); }
+
+	// Orders
+	Request scan(const Geometry::Angle& direction, const Geometry::Angle& resolution) {
+		return request(Server::Order::scan, direction.as_r(), resolution.as_r());
+	}
+	Request fire(const Geometry::Angle& direction, const double range) {
+		return request(Server::Order::fire, direction.as_r(), range);
+	}
+	Request drive(const Geometry::Angle& heading, const double speed) {
+		return request(Server::Order::drive, heading.as_r(), speed);
+	}
+};
+
+////////////////////////////////////////////////////////////
+//
+// class Scheduler
+//
+// Runs a Program for each robot in an Arena, all on the calling thread.
+// Each tick() resumes every suspended Program once, applies the orders
+// they queued through an OrderBuffer, then ticks the Arena.  Robots,
+// frames and orders are all sized up front, so a tick never allocates; a
+// resume is one indirect call.  A Program that returns, or whose robot
+// has died, has its frame freed.
+
+class Scheduler {
+	friend class Robot;
+
+private:
+	Server::Arena* m_arena;
+	FramePool m_frames;
+	Server::OrderBuffer m_orders;
+	std::vector<Robot> m_robots; // never reallocated; Programs hold references
+	std::vector<std::uint32_t> m_slots; // robot Id -> index in m_robots, or noSlot
+	std::size_t m_running;
+
+	static constexpr std::uint32_t noSlot = static_cast<std::uint32_t>(-1);
+
+public:
+	// Creators
+	explicit Scheduler(Server::Arena& arena, const std::size_t frameBytes = FramePool::defaultFrameBytes);
+	Scheduler(const Scheduler&) = delete;
+	Scheduler& operator=(const Scheduler&) = delete;
+	~Scheduler();
+
+	// Accessors
+	std::size_t size() const { return m_robots.size(); }
+	std::size_t running() const { return m_running; }
+	const FramePool& frames() const { return m_frames; }
+	const Robot& operator[](const std::size_t i) const { return m_robots[i]; }
+
+	// Modifiers
+	// Starts body(robot, args...) as robot 'id''s Program, to run from the
+	// next tick().  Returns false if 'id' is none or not in the Arena, its
+	// robot already has a Program running, or the frame does not fit the
+	// pool.  A robot whose Program has finished may be given another.
+	template <typename Body, typename... Args>
+	bool spawn(const Server::Arena::Id id, Body body, Args&&... args);
+
+	void tick();
+};
+
+////////////////////////////////////////////////////////////
+// Implementation
+
+template <typename... Args>
+void* Program::promise_type::operator new(const std::size_t bytes, Robot& self, Args&&...) noexcept {
+	return self.frames().allocate(bytes);
+}
+
+template <typename Body, typename... Args>
+bool Scheduler::spawn(const Server::Arena::Id id, Body body, Args&&... args) {
+	if (id >= m_arena->robots())
+		return false;
+	const bool known = m_slots[id] != noSlot;
+	if (known && m_robots[m_slots[id]].m_frame)
+		return false;
+	if (known)
+		m_robots[m_slots[id]] = Robot(*this, id);
+	else
+		m_robots.push_back(Robot(*this, id)); // within the capacity reserved for it
+	Robot& robot = known ? m_robots[m_slots[id]] : m_robots.back();
+	Program program = body(robot, static_cast<Args&&>(args)...);
+	if (!program) {
+		if (!known)
+			m_robots.pop_back();
+		return false;
+	}
+	robot.m_frame = program.release();
+	m_slots[id] = static_cast<std::uint32_t>(&robot - m_robots.data());
+	++m_running;
+	return true;
+}
+
+inline FramePool& Robot::frames() const { return m_scheduler->m_frames; }
+inline const Server::Arena& Robot::arena() const { return *m_scheduler->m_arena; }
+
+} // namespace Client
+
+#endif // JBOTS_COROUTINES
+
+#endif // Program_h__
@@ -0,0 +1,192 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include "../Shared/Program.h"
+
+#if JBOTS_COROUTINES
+
+namespace {
+
+Geometry::Angle degrees(const double d) { return Geometry::Angle::d2r(d); }
+
+// Scans due east, and fires at whatever it finds.
+Client::Program gunner(Client::Robot& self, double* lastRange, int* hits) {
+	for (;;) {
+		const double range = co_await self.scan(degrees(0), degrees(5));
+		*lastRange = range;
+		if (range > 0.0 && co_await self.fire(degrees(0), range))
+			++*hits;
+	}
+}
+
+// Drives north for a while, then stops and returns.
+Client::Program walker(Client::Robot& self, const int ticks) {
+	co_await self.drive(degrees(90), 100);
+	for (int i = 1; i < ticks; ++i)
+		co_await self.drive(degrees(90), 100);
+	co_await self.drive(degrees(90), 0);
+}
+
+// Drives and scans with parameters that no float holds exactly.
+Client::Program sweeper(Client::Robot& self, double* lastRange) {
+	for (double heading = 1.2345678901234567; ; heading += 0.1234567890123457) {
+		co_await self.drive(Geometry::Angle(heading), 33.3);
+		*lastRange = co_await self.scan(Geometry::Angle(heading), degrees(3.3));
+	}
+}
+
+Client::Program idler(Client::Robot& self) {
+	for (;;)
+		co_await self.drive(degrees(0), 0);
+}
+
+}
+
+SUITE(ProgramTestSuite) {
+
+TEST(FramePoolRecyclesBlocks) {
+	Client::FramePool pool(2, 100);
+	CHECK(pool.frameBytes() >= 100u);
+	void* a = pool.allocate(100);
+	void* b = pool.allocate(10);
+	CHECK(a && b && a != b);
+	CHECK(!pool.allocate(1));
+	CHECK(!pool.allocate(pool.frameBytes() + 1));
+	CHECK_EQUAL(2u, pool.size());
+	Client::FramePool::deallocate(a);
+	CHECK_EQUAL(1u, pool.size());
+	CHECK_EQUAL(a, pool.allocate(50));
+}
+
+TEST(AwaitedOrdersReturnTheirResults) {
+	Server::Arena arena(2, 0);
+	const Server::Arena::Id a = arena.enter(Geometry::Point(100, 500));
+	const Server::Arena::Id b = arena.enter(Geometry::Point(400, 300));
+	Client::Scheduler scheduler(arena);
+	double range = -1.0;
+	int hits = 0;
+	CHECK(scheduler.spawn(a, gunner, &range, &hits));
+	CHECK(scheduler.spawn(b, walker, 300));
+	CHECK(!scheduler.spawn(b, idler));
+	CHECK_EQUAL(2u, scheduler.running());
+	CHECK_EQUAL(2u, scheduler.frames().size());
+
+	// Programs start on the first tick; the scan's result arrives on the next
+	scheduler.tick();
+	CHECK_EQUAL(-1.0, range);
+	scheduler.tick();
+	CHECK_EQUAL(0.0, range);
+	CHECK_EQUAL(2, arena.stats(a).scans);
+
+	// b walks north into the scan's cone, 300 tan 5.5 degrees either side
+	// of y = 500
+	for (int i = 0; i < 300 && hits == 0; ++i)
+		scheduler.tick();
+	CHECK(range > 300.0 && range < 302.0);
+	CHECK_EQUAL(1, hits);
+	CHECK_EQUAL(1, arena.stats(a).shots);
+}
+
+TEST(AwaitedOrdersDoWhatDirectCallsDo) {
+	Server::Arena arena(2, 0), direct(2, 0);
+	for (int i = 0; i < 2; ++i) {
+		arena.enter(Geometry::Point(123.456 + 400 * i, 234.567 + 300 * i));
+		direct.enter(Geometry::Point(123.456 + 400 * i, 234.567 + 300 * i));
+	}
+	Client::Scheduler scheduler(arena);
+	double range = -1.0;
+	CHECK(scheduler.spawn(0, sweeper, &range));
+
+	// the coroutine drives on even ticks and scans on odd ones, and sees
+	// each scan's range when it resumes on the tick after
+	double heading = 1.2345678901234567, expected = -1.0;
+	for (int t = 0; t < 40; ++t) {
+		if (t % 2 == 0)
+			direct.drive(0, Geometry::Angle(heading), 33.3);
+		else {
+			expected = direct.scan(0, Geometry::Angle(heading), degrees(3.3));
+			heading += 0.1234567890123457;
+		}
+		scheduler.tick();
+		direct.tick();
+		CHECK_EQUAL(direct.position(0).x(), arena.position(0).x());
+		CHECK_EQUAL(direct.position(0).y(), arena.position(0).y());
+		if (t > 0 && t % 2 == 0)
+			CHECK_EQUAL(expected, range);
+	}
+	CHECK_EQUAL(20, arena.stats(0).scans);
+}
+
+TEST(FinishedAndDeadProgramsFreeTheirFrames) {
+	Server::Arena arena(3);
+	const Server::Arena::Id a = arena.enter(Geometry::Point(500, 100));
+	const Server::Arena::Id b = arena.enter(Geometry::Point(100, 100));
+	const Server::Arena::Id c = arena.enter(Geometry::Point(900, 100));
+	Client::Scheduler scheduler(arena);
+	CHECK(scheduler.spawn(a, walker, 10));
+	CHECK(scheduler.spawn(b, idler));
+	CHECK(scheduler.spawn(c, idler));
+
+	// ten drives at full speed and one to stop, then it returns
+	for (int i = 0; i < 11; ++i)
+		scheduler.tick();
+	CHECK_EQUAL(3u, scheduler.running());
+	scheduler.tick();
+	CHECK_EQUAL(2u, scheduler.running());
+	CHECK_EQUAL(2u, scheduler.frames().size());
+	CHECK(arena.position(a).y() > 105.0);
+
+	arena.leave(b);
+	scheduler.tick();
+	CHECK_EQUAL(1u, scheduler.running());
+	CHECK_EQUAL(1u, scheduler.frames().size());
+}
+
+TEST(OneProgramPerRobot) {
+	Server::Arena arena(3);
+	const Server::Arena::Id a = arena.enter(Geometry::Point(500, 100));
+	const Server::Arena::Id b = arena.enter(Geometry::Point(100, 100));
+	Client::Scheduler scheduler(arena);
+	CHECK(scheduler.spawn(a, walker, 2));
+	CHECK(!scheduler.spawn(a, idler));
+	CHECK(!scheduler.spawn(2, idler)); // not entered
+	CHECK(!scheduler.spawn(Server::Arena::none, idler));
+	CHECK(scheduler.spawn(b, idler));
+	CHECK_EQUAL(2u, scheduler.size());
+	CHECK_EQUAL(2u, scheduler.running());
+	CHECK_EQUAL(2u, scheduler.frames().size());
+
+	// once a's walker returns, a may run another Program, in the same place
+	for (int i = 0; i < 4; ++i)
+		scheduler.tick();
+	CHECK_EQUAL(1u, scheduler.running());
+	CHECK(scheduler.spawn(a, idler));
+	CHECK(!scheduler.spawn(a, idler));
+	CHECK_EQUAL(2u, scheduler.size());
+	CHECK_EQUAL(2u, scheduler.running());
+	CHECK_EQUAL(2u, scheduler.frames().size());
+	CHECK_EQUAL(a, scheduler[0].id());
+}
+
+TEST(ThousandsOfProgramsShareOnePool) {
+	const std::size_t n = 2000;
+	Server::Arena arena(n);
+	Client::Scheduler scheduler(arena);
+	for (std::size_t i = 0; i < n; ++i)
+		CHECK(scheduler.spawn(arena.enter(Geometry::Point(i % 50 * 20.0, i / 50 * 20.0)), idler));
+	CHECK(!scheduler.spawn(arena.enter(Geometry::Point(0, 0)), idler));
+	for (int i = 0; i < 5; ++i)
+		scheduler.tick();
+	CHECK_EQUAL(n, scheduler.running());
+	CHECK_EQUAL(n, scheduler.frames().size());
+}
+
+TEST(FramesTooBigForThePoolAreRefused) {
+	Server::Arena arena(1);
+	Client::Scheduler scheduler(arena, 8);
+	CHECK(!scheduler.spawn(arena.enter(Geometry::Point(0, 0)), idler));
+	CHECK_EQUAL(0u, scheduler.size());
+}
+
+}
+
+#endif // JBOTS_COROUTINES
@@ -0,0 +1,92 @@
+// Proximity.cpp
+// Batch distance and bearing queries between sets of points.
+
+#include "Proximity.h"
+
+#include "Geometry.h"
+#include "Simd.h"
+
+namespace Geometry {
+
+namespace {
+
+// The 'to' set is processed in blocks small enough that a block's x and y
+// arrays, and the distances computed against it, stay in L1 while every
+// 'from' point is run past it.
+const std::size_t blockSize = 512;
+
+// Squared distances from (x, y) to to[begin, end), into out[0, end - begin),
+// by the kernel for this machine's instruction set.
+inline void blockDistances(const double x, const double y, const PointSet& to,
+                           const std::size_t begin, const std::size_t end,
+                           double* out)
+{
+	kernels().distances(x, y, to.x + begin, to.y + begin, end - begin, out);
+}
+
+inline std::size_t blockEnd(const std::size_t begin, const std::size_t count) {
+	return begin + blockSize < count ? begin + blockSize : count;
+}
+
+} // namespace
+
+PointSet points(const EntityBatch& batch) {
+	return PointSet(batch.x(), batch.y(), batch.size());
+}
+
+void distancesSquared(const PointSet& from, const PointSet& to, double* result) {
+	for (std::size_t begin = 0; begin < to.count; begin += blockSize) {
+		const std::size_t end = blockEnd(begin, to.count);
+		for (std::size_t i = 0; i < from.count; ++i)
+			blockDistances(from.x[i], from.y[i], to, begin, end, result + i * to.count + begin);
+	}
+}
+
+void withinRadius(const PointSet& from, const PointSet& to, const double radius,
+                  unsigned char* mask)
+{
+	const double limit = radius < 0.0 ? 0.0 : radius * radius;
+	double d2[blockSize];
+	for (std::size_t begin = 0; begin < to.count; begin += blockSize) {
+		const std::size_t end = blockEnd(begin, to.count);
+		const std::size_t n = end - begin;
+		for (std::size_t i = 0; i < from.count; ++i) {
+			blockDistances(from.x[i], from.y[i], to, begin, end, d2);
+			unsigned char* const row = mask + i * to.count + begin;
+			for (std::size_t j = 0; j < n; ++j)
+				row[j] = d2[j] < limit;
+		}
+	}
+}
+
+void nearest(const PointSet& from, const PointSet& to, NearestHit* hits,
+             const double range, const bool excludeSelf)
+{
+	const double limit = range < 0.0 ? 0.0 : range * range;
+	for (std::size_t i = 0; i < from.count; ++i) {
+		hits[i].index = noHit;
+		hits[i].distanceSquared = limit;
+	}
+
+	double d2[blockSize];
+	for (std::size_t begin = 0; begin < to.count; begin += blockSize) {
+		const std::size_t end = blockEnd(begin, to.count);
+		const std::size_t n = end - begin;
+		for (std::size_t i = 0; i < from.count; ++i) {
+			blockDistances(from.x[i], from.y[i], to, begin, end, d2);
+			NearestHit& hit = hits[i];
+			for (std::size_t j = 0; j < n; ++j) {
+				if (d2[j] < hit.distanceSquared && !(excludeSelf && begin + j == i)) {
+					hit.distanceSquared = d2[j];
+					hit.index = begin + j;
+				}
+			}
+		}
+	}
+}
+
+void bearings(const double x, const double y, const PointSet& to, double* radians) {
+	kernels().bearings(x, y, to.x, to.y, to.count, radians);
+}
+
+} // namespace Geometry
@@ -0,0 +1,75 @@
+// Proximity.h
+// Batch distance and bearing queries between sets of points, for collision
+// checks, scans and missile blasts.  Everything here compares squared
+// distances; nothing takes a square root.
+
+#ifndef Proximity_h__
+#define Proximity_h__
+
+#include <cstddef>
+#include <limits>
+
+namespace Geometry {
+
+class EntityBatch;
+
+////////////////////////////////////////////////////////////
+//
+// struct PointSet
+//
+// A read-only view of points stored as separate x and y arrays, such as the
+// ones EntityBatch keeps.  The view does not own the arrays.
+
+struct PointSet {
+	const double* x;
+	const double* y;
+	std::size_t count;
+
+	PointSet() : x(0), y(0), count(0) {}
+	PointSet(const double* x, const double* y, const std::size_t count)
+		: x(x), y(y), count(count) {}
+};
+
+// The positions of every entity in a batch.
+PointSet points(const EntityBatch& batch);
+
+////////////////////////////////////////////////////////////
+//
+// struct NearestHit
+//
+// Result of a nearest point query.  index is noHit if nothing was in range.
+
+const std::size_t noHit = static_cast<std::size_t>(-1);
+
+struct NearestHit {
+	std::size_t index;
+	double distanceSquared;
+};
+
+////////////////////////////////////////////////////////////
+
+// Writes the squared distance from every point in 'from' to every point in
+// 'to' into 'result', row-major: result[i * to.count + j].
+void distancesSquared(const PointSet& from, const PointSet& to, double* result);
+
+// Sets mask[i * to.count + j] to 1 if from[i] is strictly closer than
+// 'radius' to to[j], and to 0 otherwise.
+void withinRadius(const PointSet& from, const PointSet& to, const double radius,
+                  unsigned char* mask);
+
+// For every point in 'from', finds the nearest point in 'to' that is strictly
+// closer than 'range'.  Ties go to the lower index.  With 'excludeSelf' the
+// two sets are taken to be the same, and each point ignores itself.
+void nearest(const PointSet& from, const PointSet& to, NearestHit* hits,
+             const double range = std::numeric_limits<double>::infinity(),
+             const bool excludeSelf = false);
+
+// Writes the bearing from (x, y) to every point in 'to' into 'radians', in
+// [0, twopi) as bearing() measures it.  Uses a polynomial atan2 that the
+// compiler can vectorize, with an absolute error below 2e-8 radians; the
+// bearing from a point to itself is zero.
+void bearings(const double x, const double y, const PointSet& to, double* radians);
+
+} // namespace Geometry
+
+#endif // Proximity_h__
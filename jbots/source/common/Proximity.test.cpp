@@ -0,0 +1,110 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <vector>
+
+#include "../Shared/Geometry.h"
+#include "../Shared/Proximity.h"
+
+SUITE(ProximityTestSuite) {
+
+TEST(DistanceSquared) {
+	Geometry::Point a(1,2);
+	Geometry::Point b(4,6);
+	CHECK_EQUAL(25.0, Geometry::distanceSquared(a, b));
+	CHECK_EQUAL(5.0, Geometry::distance(a, b));
+	CHECK(a.near(b, 5.001));
+	CHECK(!a.near(b, 5.0));
+	CHECK(!a.near(b, -1.0));
+}
+
+TEST(DistancesSquaredMatrix) {
+	const double ax[] = { 0, 10 };
+	const double ay[] = { 0, 0 };
+	const double bx[] = { 3, 10, 0 };
+	const double by[] = { 4, 1, 0 };
+	double result[6];
+	Geometry::distancesSquared(Geometry::PointSet(ax, ay, 2), Geometry::PointSet(bx, by, 3), result);
+	CHECK_EQUAL(25.0, result[0]);
+	CHECK_EQUAL(101.0, result[1]);
+	CHECK_EQUAL(0.0, result[2]);
+	CHECK_EQUAL(65.0, result[3]);
+	CHECK_EQUAL(1.0, result[4]);
+	CHECK_EQUAL(100.0, result[5]);
+}
+
+TEST(WithinRadiusMask) {
+	const double ax[] = { 0 };
+	const double ay[] = { 0 };
+	const double bx[] = { 3, 5, 6 };
+	const double by[] = { 4, 0, 0 };
+	unsigned char mask[3];
+	Geometry::withinRadius(Geometry::PointSet(ax, ay, 1), Geometry::PointSet(bx, by, 3), 5.5, mask);
+	CHECK_EQUAL(1, mask[0]);
+	CHECK_EQUAL(1, mask[1]);
+	CHECK_EQUAL(0, mask[2]);
+}
+
+TEST(NearestAcrossBlocks) {
+	// enough targets to span several blocks
+	const std::size_t n = 2000;
+	std::vector<double> x(n), y(n);
+	for (std::size_t j = 0; j < n; ++j) {
+		x[j] = static_cast<double>(j);
+		y[j] = 100.0;
+	}
+	const double ax[] = { 1500.2, 10.0, -500.0 };
+	const double ay[] = { 99.0, 100.0, 100.0 };
+	Geometry::NearestHit hits[3];
+	Geometry::nearest(Geometry::PointSet(ax, ay, 3), Geometry::PointSet(&x[0], &y[0], n), hits, 50.0);
+	CHECK_EQUAL(1500u, hits[0].index);
+	CHECK_CLOSE(1.04, hits[0].distanceSquared, 0.0001);
+	CHECK_EQUAL(10u, hits[1].index);
+	CHECK_EQUAL(Geometry::noHit, hits[2].index);
+}
+
+TEST(NearestExcludeSelf) {
+	const double x[] = { 0, 5, 1 };
+	const double y[] = { 0, 0, 0 };
+	Geometry::PointSet set(x, y, 3);
+	Geometry::NearestHit hits[3];
+	Geometry::nearest(set, set, hits, 100.0, true);
+	CHECK_EQUAL(2u, hits[0].index);
+	CHECK_EQUAL(2u, hits[1].index);
+	CHECK_EQUAL(0u, hits[2].index);
+}
+
+TEST(PointsOfBatch) {
+	Geometry::EntityBatch batch;
+	batch.add(Geometry::Entity(Geometry::Point(1,2), Geometry::Angle(0), 0));
+	Geometry::PointSet set = Geometry::points(batch);
+	CHECK_EQUAL(1u, set.count);
+	CHECK_EQUAL(1.0, set.x[0]);
+	CHECK_EQUAL(2.0, set.y[0]);
+}
+
+TEST(BearingsMatchScalarBearing) {
+	// every quadrant, both axes, the diagonals, and the origin itself
+	std::vector<double> x, y;
+	for (int i = -20; i <= 20; ++i) {
+		for (int j = -20; j <= 20; ++j) {
+			x.push_back(500.0 + i * 13.7);
+			y.push_back(500.0 + j * 9.1);
+		}
+	}
+	x.push_back(500.0); y.push_back(500.0);
+	x.push_back(600.0); y.push_back(400.0);
+	x.push_back(400.0); y.push_back(600.0);
+	x.push_back(500.0); y.push_back(500.0 - 1e-12);
+
+	std::vector<double> radians(x.size());
+	const Geometry::Point origin(500.0, 500.0);
+	Geometry::bearings(origin.x(), origin.y(), Geometry::PointSet(x.data(), y.data(), x.size()), radians.data());
+	for (std::size_t i = 0; i < x.size(); ++i) {
+		const double expected = Geometry::bearing(origin, Geometry::Point(x[i], y[i])).as_r();
+		CHECK_CLOSE(expected, radians[i], 2e-8);
+		CHECK(radians[i] >= 0.0 && radians[i] < Geometry::twopi);
+	}
+	CHECK_EQUAL(0.0, radians[x.size() - 4]);
+}
+
+} // suite
@@ -0,0 +1,265 @@
+// Registers.cpp
+// Translates CROBOTS stack code into register code for the Cpu's second
+// tier.
+
+#include "Registers.h"
+
+#include <algorithm> // fill(), max(), min(), sort()
+#include <utility>   // pair
+
+namespace Vm {
+
+namespace {
+
+typedef RegisterCode::Register Register;
+typedef RegisterCode::Operation Operation;
+
+Register reg(const int bank, const int index) {
+	const Register r = { static_cast<std::uint8_t>(bank), static_cast<std::uint16_t>(index) };
+	return r;
+}
+
+bool same(const Register& a, const Register& b) { return a.bank == b.bank && a.index == b.index; }
+
+////////////////////////////////////////////////////////////
+//
+// class Builder
+//
+// Runs one stretch of stack code symbolically: the stack holds registers
+// instead of values, and only operators and stores emit operations.
+
+class Builder {
+private:
+	const Image& m_image;
+	const std::vector<int>& m_locals;     // of the function at each pc
+	const std::vector<bool>& m_entered;   // pcs reached other than in order
+	RegisterCode& m_code;
+
+	std::vector<Register> m_stack;
+	std::vector<Register> m_inputs;
+	std::vector<Operation> m_operations;
+	int m_temporaries;
+	int m_depth;                          // relative to the entry
+	int m_reach;
+
+	std::vector<Word> m_constants;        // new, for m_code.constants
+	bool m_branched;
+
+	bool variable(const Instruction& in, const int pc, Register& r) const;
+	bool pop(Register& r);
+	bool temporary(Register& r);
+	void emit(const int kind, const Register& dst, const Register& a, const Register& b, const Word target = 0);
+	bool step(const Instruction& in, const int pc);
+	// Runs from 'start' to at most 'limit'; returns false if an instruction
+	// on the way cannot be taken.  'stop' is where it stopped.
+	bool run(const int start, const int limit, int& stop);
+
+public:
+	Builder(const Image& image, const std::vector<int>& locals, const std::vector<bool>& entered, RegisterCode& code)
+		: m_image(image), m_locals(locals), m_entered(entered), m_code(code) {}
+
+	// The exit of a Segment starting at 'start', or 'start' if there is
+	// none worth having.
+	int build(const int start);
+};
+
+bool Builder::variable(const Instruction& in, const int pc, Register& r) const {
+	if (in.operand & external) {
+		const Word offset = in.operand & ~external;
+		if (offset < 0 || offset >= m_image.externals)
+			return false;
+		r = reg(Register::external, offset);
+		return true;
+	}
+	// only the function's own locals: past them lie its temporaries, which
+	// this tier does not keep on the stack
+	if (in.operand < 0 || in.operand >= m_locals[pc])
+		return false;
+	r = reg(Register::local, in.operand);
+	return true;
+}
+
+bool Builder::temporary(Register& r) {
+	if (m_temporaries == RegisterCode::maxTemporaries)
+		return false;
+	r = reg(Register::temporary, m_temporaries++);
+	return true;
+}
+
+bool Builder::pop(Register& r) {
+	--m_depth;
+	if (!m_stack.empty()) {
+		r = m_stack.back();
+		m_stack.pop_back();
+		return true;
+	}
+	// from below the entry
+	if (!temporary(r))
+		return false;
+	m_inputs.push_back(r);
+	return true;
+}
+
+void Builder::emit(const int kind, const Register& dst, const Register& a, const Register& b, const Word target) {
+	Operation op;
+	op.kind = static_cast<std::uint8_t>(kind);
+	op.dst = dst;
+	op.a = a;
+	op.b = b;
+	op.target = target;
+	m_operations.push_back(op);
+}
+
+bool Builder::step(const Instruction& in, const int pc) {
+	Register a, b, r;
+	switch (in.op) {
+	case Instruction::nop:
+		return true;
+	case Instruction::fetch:
+		if (!variable(in, pc, r))
+			return false;
+		m_reach = std::max(m_reach, ++m_depth);
+		m_stack.push_back(r);
+		return true;
+	case Instruction::constant:
+		if (m_code.constants.size() + m_constants.size() > 0xffff)
+			return false;
+		m_reach = std::max(m_reach, ++m_depth);
+		m_stack.push_back(reg(Register::constant, static_cast<int>(m_code.constants.size() + m_constants.size())));
+		m_constants.push_back(in.operand);
+		return true;
+	case Instruction::binop:
+		if (in.opcode <= Instruction::assign || in.opcode >= Instruction::binops ||
+		    !pop(b) || !pop(a) || !temporary(r))
+			return false;
+		emit(Operation::compute + in.opcode, r, a, b);
+		m_stack.push_back(r);
+		++m_depth;
+		return true;
+	case Instruction::store:
+		if (in.opcode >= Instruction::binops || !variable(in, pc, r) || !pop(b))
+			return false;
+		// values already on the stack that were read from the variable keep
+		// what they read
+		for (std::size_t k = 0; k < m_stack.size(); ++k)
+			if (same(m_stack[k], r)) {
+				Register t;
+				if (!temporary(t))
+					return false;
+				emit(static_cast<int>(Operation::compute) + static_cast<int>(Instruction::assign), t, t, r);
+				m_stack[k] = t;
+			}
+		if (in.opcode == Instruction::assign && b.bank == Register::temporary &&
+		    !m_operations.empty() && same(m_operations.back().dst, b))
+			m_operations.back().dst = r; // computed straight into the variable
+		else
+			emit(Operation::compute + in.opcode, r, r, b);
+		m_stack.push_back(r);
+		++m_depth;
+		return true;
+	case Instruction::chop:
+		return pop(r);
+	case Instruction::branch:
+		if (in.operand < 0 || in.operand > static_cast<int>(m_image.code.size()) || !pop(r))
+			return false;
+		m_branched = true;
+		if (r.bank == Register::constant) {
+			if (m_constants[r.index - m_code.constants.size()] == 0)
+				emit(Operation::jump, r, r, r, in.operand);
+		} else if (r.bank == Register::temporary && !m_operations.empty() && same(m_operations.back().dst, r)) {
+			// test the operands directly
+			Operation& last = m_operations.back();
+			last.kind = static_cast<std::uint8_t>(Operation::branch + last.kind);
+			last.target = in.operand;
+		} else
+			emit(static_cast<int>(Operation::branch) + static_cast<int>(Instruction::assign), r, r, r, in.operand);
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool Builder::run(const int start, const int limit, int& stop) {
+	m_stack.clear();
+	m_inputs.clear();
+	m_operations.clear();
+	m_constants.clear();
+	m_temporaries = 0;
+	m_depth = 0;
+	m_reach = 0;
+	m_branched = false;
+	for (stop = start; stop < limit && !m_branched; ++stop) {
+		if (stop > start && m_entered[stop])
+			return true;
+		if (!step(m_image.code[stop], stop))
+			return false;
+	}
+	return true;
+}
+
+int Builder::build(const int start) {
+	int stop;
+	if (!run(start, static_cast<int>(m_image.code.size()), stop)) {
+		// take what came before the instruction that could not be
+		if (stop - start < 2 || !run(start, stop, stop))
+			return start;
+	}
+	// only worth having if it saves dispatches: one for the Segment, then
+	// one per input, operation and output, and one to leave
+	const int cost = stop - start;
+	const int dispatches = static_cast<int>(m_inputs.size() + m_operations.size() + m_stack.size()) + 2;
+	if (cost <= dispatches || (m_operations.empty() && !m_branched))
+		return start;
+
+	RegisterCode::Segment segment;
+	segment.start = start;
+	segment.exit = stop;
+	segment.cost = cost;
+	segment.reach = m_reach;
+	segment.first = static_cast<int>(m_code.operations.size());
+	segment.count = static_cast<int>(m_operations.size());
+	segment.inputs = static_cast<int>(m_code.registers.size());
+	segment.inputCount = static_cast<int>(m_inputs.size());
+	m_code.registers.insert(m_code.registers.end(), m_inputs.begin(), m_inputs.end());
+	segment.outputs = static_cast<int>(m_code.registers.size());
+	segment.outputCount = static_cast<int>(m_stack.size());
+	m_code.registers.insert(m_code.registers.end(), m_stack.begin(), m_stack.end());
+	m_code.operations.insert(m_code.operations.end(), m_operations.begin(), m_operations.end());
+	m_code.constants.insert(m_code.constants.end(), m_constants.begin(), m_constants.end());
+	m_code.segments.push_back(segment);
+	return stop;
+}
+
+} // namespace
+
+void translate(const Image& image, RegisterCode& code) {
+	code.segments.clear();
+	code.operations.clear();
+	code.registers.clear();
+	code.constants.clear();
+
+	const int end = static_cast<int>(image.code.size());
+	std::vector<bool> entered;
+	entries(image, entered);
+	std::vector<int> locals(end + 1, 0);
+	std::vector<std::pair<int, int> > functions; // entry, locals
+	for (std::size_t f = 0; f < image.links.size(); ++f) {
+		const Link& link = image.links[f];
+		if (link.entry >= 0 && link.entry < end)
+			functions.push_back(std::make_pair(link.entry, std::min(link.locals, maxVariables)));
+	}
+	// each function runs to the next one's entry
+	std::sort(functions.begin(), functions.end());
+	for (std::size_t f = 0; f < functions.size(); ++f) {
+		const int next = f + 1 < functions.size() ? functions[f + 1].first : end;
+		std::fill(locals.begin() + functions[f].first, locals.begin() + next, functions[f].second);
+	}
+
+	Builder builder(image, locals, entered, code);
+	for (int pc = 0; pc < end; ) {
+		const int exit = builder.build(pc);
+		pc = exit > pc ? exit : pc + 1;
+	}
+}
+
+} // namespace Vm
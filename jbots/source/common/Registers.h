@@ -0,0 +1,68 @@
+// Registers.h
+// Translates CROBOTS stack code into register code for the Cpu's second
+// tier.
+
+#ifndef Registers_h__
+#define Registers_h__
+
+#include <cstdint>
+#include <vector>
+
+#include "Bytecode.h"
+
+namespace Vm {
+
+////////////////////////////////////////////////////////////
+//
+// struct RegisterCode
+//
+// Straight runs of stack code -- FETCH, CONST, BINOP, STORE, CHOP and a
+// final BRANCH, entered only at the top -- rewritten as Segments of
+// three-address operations whose operands are the variables themselves.
+// So 'x = x + i * 3;', seven stack instructions, becomes two operations,
+// with nothing pushed or popped.
+//
+// A Segment stands in for the stack code from 'start' to 'exit' and
+// charges exactly the cycles that code would have.  It is only taken when
+// it would run to the end within the cycles left, and could not overflow
+// the stack where the stack code would; otherwise the stack code runs
+// instead, so that both tiers always agree.
+
+struct RegisterCode {
+	struct Register {
+		enum Bank { local, external, constant, temporary };
+		std::uint8_t bank;
+		std::uint16_t index;
+	};
+
+	// The stack instructions' operators, then BRANCH-unless and JUMP.
+	struct Operation {
+		enum Kind { compute = 0, branch = Instruction::binops, jump = 2 * Instruction::binops };
+		std::uint8_t kind;     // compute + operator, branch + operator or jump
+		Register dst, a, b;    // dst = a op b, or branch unless a op b
+		Word target;
+	};
+
+	struct Segment {
+		int start, exit;       // stack code replaced
+		int cost;              // its instructions
+		int reach;             // how far above the entry stack pointer it pushes
+		int first, count;      // operations
+		int inputs, inputCount;   // registers taking values from the stack at entry
+		int outputs, outputCount; // registers left on the stack at exit
+	};
+
+	static const int maxTemporaries = 32;
+
+	std::vector<Segment> segments;
+	std::vector<Operation> operations;
+	std::vector<Register> registers;  // segments' inputs and outputs
+	std::vector<Word> constants;
+};
+
+// Builds the register code for every Segment worth having in 'image'.
+void translate(const Image& image, RegisterCode& code);
+
+} // namespace Vm
+
+#endif // Registers_h__
@@ -0,0 +1,89 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <string>
+
+#include "../Shared/Compiler.h"
+#include "../Shared/Cpu.h"
+#include "../Shared/Registers.h"
+#include "../Shared/SampleRobots.h"
+#include "../Shared/Tiers.test.h"
+
+using TierTest::agree;
+
+SUITE(RegistersTestSuite) {
+
+TEST(TranslatesStraightCode) {
+	// eleven instructions up to the RETSUB, of which 'r = r + x * 3;' is
+	// FETCH r; FETCH x; CONST 3; BINOP *; BINOP +; STORE r; CHOP
+	Vm::Image image;
+	CHECK(Vm::compile("int r; main() { int x; x = 6; r = r + x * 3; }", image));
+	Vm::RegisterCode code;
+	Vm::translate(image, code);
+	CHECK(!code.segments.empty());
+	bool found = false;
+	for (std::size_t s = 0; s < code.segments.size(); ++s) {
+		const Vm::RegisterCode::Segment& segment = code.segments[s];
+		CHECK(segment.exit - segment.start == segment.cost);
+		if (segment.cost == 11 && segment.count == 3)
+			found = true;
+	}
+	CHECK(found);
+
+	Vm::Cpu cpu(image, 0, 1, Vm::Cpu::registers);
+	cpu.run(15);
+	CHECK_EQUAL(18, cpu.external(0));
+	CHECK(agree(image, Vm::Cpu::registers, 1000, 1));
+	CHECK(agree(image, Vm::Cpu::registers, 1000, 300));
+}
+
+TEST(StoresDoNotChangeWhatWasRead) {
+	Vm::Image image;
+	CHECK(Vm::compile("int r, s; main() { int x; x = 2; r = x + (x = 5); s = (x += 1) * x; while (1) ; }", image));
+	Vm::Cpu cpu(image, 0, 1, Vm::Cpu::registers);
+	cpu.run(100);
+	CHECK_EQUAL(7, cpu.external(0));
+	CHECK_EQUAL(36, cpu.external(1));
+	CHECK(agree(image, Vm::Cpu::registers, 100, 1));
+}
+
+TEST(OperatorsMatchTheStackTier) {
+	for (int o = 0; o < TierTest::operatorCount; ++o) {
+		Vm::Image image;
+		CHECK(Vm::compile(TierTest::operatorProgram(o), image));
+		CHECK(agree(image, Vm::Cpu::registers, 5000, 1));
+		CHECK(agree(image, Vm::Cpu::registers, 5000, 200));
+	}
+}
+
+TEST(SamplesMatchTheStackTier) {
+	const char* const robots[] = { Vm::Samples::rabbit, Vm::Samples::counter, Vm::Samples::rook, Vm::Samples::sniper };
+	for (int r = 0; r < 4; ++r) {
+		Vm::Image image;
+		CHECK(Vm::compile(robots[r], image));
+		CHECK(agree(image, Vm::Cpu::registers, 200000, 1));
+		// stopping anywhere, inside a Segment or not
+		CHECK(agree(image, Vm::Cpu::registers, 20000, 5000));
+	}
+}
+
+TEST(OverflowsWhereTheStackTierDoes) {
+	// recursion until the stack is full, with frames of every size so that
+	// it fills up at every point of the expression
+	std::string locals = "a";
+	for (int k = 0; k < 8; ++k, locals += ", v" + std::to_string(k)) {
+		Vm::Image image;
+		CHECK(Vm::compile(
+			"int depth, x;\n"
+			"main() { depth = 0; x = f(1); }\n"
+			"f(n) int n; { int " + locals + "; depth = n;\n"
+			"  a = 1 + (2 + (3 + (4 + (5 + (6 + n * 3)))));\n"
+			"  return (f(n + 1) + a); }\n", image));
+		Vm::Cpu cpu(image, 0, 1, Vm::Cpu::registers);
+		cpu.run(100000);
+		CHECK(cpu.overflows() > 0);
+		CHECK(agree(image, Vm::Cpu::registers, 100000, 1));
+		CHECK(agree(image, Vm::Cpu::registers, 100000, 3000));
+	}
+}
+
+}
@@ -0,0 +1,120 @@
+// Scalar.h
+// The scalar policies that the geometry classes are templated on.
+
+#ifndef Scalar_h__
+#define Scalar_h__
+
+#include <cmath> // sqrt(), atan2(), trunc()
+
+#include "Fixed.h"
+#include "Trig.h"
+
+namespace Geometry {
+
+////////////////////////////////////////////////////////////
+
+// Useful constants
+constexpr double pi    = 3.14159265358979323846;
+constexpr double twopi = 2 * pi;
+
+////////////////////////////////////////////////////////////
+//
+// struct ScalarTraits
+//
+// Everything BasicPoint, BasicAngle and BasicEntity need from their number
+// type beyond + - * and comparisons.  Wide is the type of products: squared
+// distances, dot and cross products.  Three policies are provided:
+//
+//   double  the default, and what Point, Angle and Entity use
+//   float   half the memory traffic, for throughput
+//   Fixed   integer arithmetic only, bit-identical everywhere, for replays
+//
+// The choice is made at compile time; there is no virtual dispatch.
+
+template <typename S> struct ScalarTraits;
+
+template <>
+struct ScalarTraits<double> {
+	typedef double Wide;
+
+	static constexpr double pi = Geometry::pi;
+	static constexpr double twopi = Geometry::twopi;
+
+	static constexpr double fromDouble(const double value) { return value; }
+	static constexpr double toDouble(const double value) { return value; }
+	static constexpr Wide multiply(const double a, const double b) { return a * b; }
+	static double sqrt(const Wide value) { return std::sqrt(value); }
+	static void sinCos(const double radians, double& s, double& c) { fastSinCos(radians, s, c); }
+
+	// anti-clockwise from the positive x axis, 0 to twopi
+	static double direction(const double dy, const double dx) {
+		const double r = std::atan2(dy, dx);
+		return r < 0.0 ? r + twopi : r;
+	}
+
+	// Wraps an angle into (-twopi, twopi), keeping its sign, in constant
+	// time.  Values too large to carry a meaningful fraction of a turn, and
+	// NaN, come back as zero.  Written as selects so that loops over it
+	// vectorize; Clang does so by default, GCC needs -fno-trapping-math.
+	static double wrap(const double r) {
+		double result = r - twopi * std::trunc(r / twopi);
+		// the quotient can round across an integer; fix up the last step
+		result = result >= twopi ? result - twopi : result;
+		result = result <= -twopi ? result + twopi : result;
+		return (result < twopi && result > -twopi) ? result : 0.0;
+	}
+};
+
+template <>
+struct ScalarTraits<float> {
+	typedef float Wide;
+
+	static constexpr float pi = static_cast<float>(Geometry::pi);
+	static constexpr float twopi = static_cast<float>(Geometry::twopi);
+
+	static constexpr float fromDouble(const double value) { return static_cast<float>(value); }
+	static constexpr double toDouble(const float value) { return value; }
+	static constexpr Wide multiply(const float a, const float b) { return a * b; }
+	static float sqrt(const Wide value) { return std::sqrt(value); }
+
+	static void sinCos(const float radians, float& s, float& c) {
+		double sd, cd;
+		fastSinCos(static_cast<double>(radians), sd, cd);
+		s = static_cast<float>(sd);
+		c = static_cast<float>(cd);
+	}
+
+	static float direction(const float dy, const float dx) {
+		const float r = std::atan2(dy, dx);
+		return r < 0.0f ? r + twopi : r;
+	}
+
+	static float wrap(const float r) {
+		float result = r - twopi * std::trunc(r / twopi);
+		result = result >= twopi ? result - twopi : result;
+		result = result <= -twopi ? result + twopi : result;
+		return (result < twopi && result > -twopi) ? result : 0.0f;
+	}
+};
+
+template <>
+struct ScalarTraits<Fixed> {
+	typedef Fixed::Wide Wide;
+
+	static constexpr Fixed pi = Fixed(Geometry::pi);
+	static constexpr Fixed twopi = Fixed(Geometry::twopi);
+
+	static constexpr Fixed fromDouble(const double value) { return Fixed(value); }
+	static constexpr double toDouble(const Fixed value) { return value.toDouble(); }
+	static constexpr Wide multiply(const Fixed a, const Fixed b) { return Wide::product(a, b); }
+	static Fixed sqrt(const Wide value) { return value.sqrt(); }
+	static void sinCos(const Fixed radians, Fixed& s, Fixed& c) { fastSinCos(radians, s, c); }
+	static Fixed direction(const Fixed dy, const Fixed dx) { return fixedDirection(dy, dx); }
+
+	// the remainder keeps the sign, as for the floating-point policies
+	static Fixed wrap(const Fixed r) { return Fixed::fromRaw(r.raw() % twopi.raw()); }
+};
+
+} // namespace Geometry
+
+#endif // Scalar_h__
@@ -0,0 +1,98 @@
+// ScanTable.cpp
+// Per-tick polar range tables for CROBOTS scan() calls.
+
+#include "ScanTable.h"
+
+#include "Trig.h"
+
+namespace Server {
+
+namespace {
+
+// Robots whose bearings are computed per call of the batch kernel.
+const std::size_t blockSize = 256;
+
+} // namespace
+
+////////////////////////////////////////////////////////////
+// class ScanTable
+
+ScanTable::ScanTable() : m_tick(-1) {
+	for (int i = 0; i < bins; ++i)
+		m_range[i] = 0;
+}
+
+int ScanTable::range(const int degree) const {
+	return m_range[Geometry::wrapDegrees(degree)];
+}
+
+int ScanTable::scan(const int degree, const int resolution) const {
+	int width = resolution < 0 ? -resolution : resolution;
+	if (width > maxResolution)
+		width = maxResolution;
+
+	// Walk degree - width .. degree + width; the starting bin is wrapped once
+	// and the walk wraps by a single compare rather than a modulo per bin.
+	int bin = Geometry::wrapDegrees(degree - width);
+	int nearest = 0;
+	for (int i = 0; i <= 2 * width; ++i) {
+		const int r = m_range[bin];
+		if (r != 0 && (nearest == 0 || r < nearest))
+			nearest = r;
+		if (++bin == bins)
+			bin = 0;
+	}
+	return nearest;
+}
+
+void ScanTable::build(const Tick tick, const Geometry::Point& origin,
+                      const Geometry::PointSet& robots, const std::size_t self,
+                      const unsigned char* alive)
+{
+	for (int i = 0; i < bins; ++i)
+		m_range[i] = 0;
+	// Bearings come from the batch kernel a block at a time, so a large
+	// field needs no scratch beyond the stack.
+	double radians[blockSize];
+	for (std::size_t begin = 0; begin < robots.count; begin += blockSize) {
+		const std::size_t n = robots.count - begin < blockSize ? robots.count - begin : blockSize;
+		Geometry::bearings(origin.x(), origin.y(),
+		                   Geometry::PointSet(robots.x + begin, robots.y + begin, n), radians);
+		for (std::size_t j = 0; j < n; ++j) {
+			const std::size_t i = begin + j;
+			if (i == self || (alive && !alive[i]))
+				continue;
+			const double degrees = Geometry::Angle::r2d(radians[j]);
+			const int bin = Geometry::wrapDegrees(static_cast<int>(degrees + 0.5));
+			const Geometry::Point target(robots.x[i], robots.y[i]);
+			int r = static_cast<int>(Geometry::distance(origin, target) + 0.5);
+			if (r < 1)
+				r = 1;
+			if (m_range[bin] == 0 || r < m_range[bin])
+				m_range[bin] = r;
+		}
+	}
+	m_tick = tick;
+}
+
+////////////////////////////////////////////////////////////
+// class ScanTables
+
+void ScanTables::invalidate() {
+	for (std::size_t i = 0; i < m_tables.size(); ++i)
+		m_tables[i].invalidate();
+}
+
+int ScanTables::scan(const std::size_t self, const ScanTable::Tick tick,
+                     const Geometry::PointSet& robots, const int degree, const int resolution,
+                     const unsigned char* alive)
+{
+	if (self >= m_tables.size())
+		m_tables.resize(robots.count > self ? robots.count : self + 1);
+	ScanTable& table = m_tables[self];
+	if (!table.current(tick))
+		table.build(tick, Geometry::Point(robots.x[self], robots.y[self]), robots, self, alive);
+	return table.scan(degree, resolution);
+}
+
+} // namespace Server
@@ -0,0 +1,87 @@
+// ScanTable.h
+// Per-tick polar range tables that answer CROBOTS scan() calls in time
+// proportional to the scan resolution.
+
+#ifndef ScanTable_h__
+#define ScanTable_h__
+
+#include <cstddef>
+#include <vector>
+
+#include "Geometry.h"
+#include "Proximity.h"
+
+namespace Server {
+
+////////////////////////////////////////////////////////////
+//
+// class ScanTable
+//
+// What one robot's scanner can see during one tick: for each whole degree
+// of bearing, the range to the nearest other robot, or 0 if there is none.
+// Built once per tick from the robot positions, after which every scan() is
+// a walk over at most 2 * maxResolution + 1 bins.
+
+class ScanTable {
+public:
+	typedef long Tick;
+	static const int bins = 360;
+	static const int maxResolution = 10;
+
+private:
+	int m_range[bins];
+	Tick m_tick;
+
+public:
+	// Creators
+	ScanTable();
+
+	// Accessors
+	bool current(const Tick tick) const { return m_tick == tick; }
+	int range(const int degree) const; // the bin's range, or 0
+
+	// CROBOTS scan(): degree is forced into 0-359 and resolution is made
+	// positive and limited to maxResolution.  Returns the range to the nearest
+	// robot within degree +/- resolution, or 0 if there is none.
+	int scan(const int degree, const int resolution) const;
+
+	// Modifiers
+	// Fills the table for 'tick' as seen from 'origin'.  Point 'self' of
+	// 'robots' is the scanning robot and is skipped, as is any point whose
+	// 'alive' entry is 0 when 'alive' is given.  Ranges are rounded to whole
+	// meters, and are at least 1 so that they never read as "nothing".
+	void build(const Tick tick, const Geometry::Point& origin,
+	           const Geometry::PointSet& robots, const std::size_t self,
+	           const unsigned char* alive = 0);
+	void invalidate() { m_tick = -1; }
+};
+
+////////////////////////////////////////////////////////////
+//
+// class ScanTables
+//
+// One ScanTable per robot, behind Arena::scan().  A robot's table is built
+// lazily by its first scan in a tick; robots that do not scan in a tick
+// cost nothing.
+
+class ScanTables {
+private:
+	std::vector<ScanTable> m_tables;
+
+public:
+	// Creators
+	explicit ScanTables(const std::size_t robots = 0) : m_tables(robots) {}
+
+	// Modifiers
+	void resize(const std::size_t robots) { m_tables.resize(robots); }
+	void invalidate();
+
+	// scan() on behalf of robots[self] during 'tick'.
+	int scan(const std::size_t self, const ScanTable::Tick tick,
+	         const Geometry::PointSet& robots, const int degree, const int resolution,
+	         const unsigned char* alive = 0);
+};
+
+} // namespace Server
+
+#endif // ScanTable_h__
@@ -0,0 +1,72 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include "../Shared/ScanTable.h"
+
+SUITE(ScanTableTestSuite) {
+
+TEST(EmptyTable) {
+	Server::ScanTable table;
+	CHECK(!table.current(0));
+	CHECK_EQUAL(0, table.scan(45, 10));
+}
+
+TEST(ScanBins) {
+	// robot 0 scans; the others sit due east, north-east and just below east
+	const double x[] = { 500, 600, 571, 800 };
+	const double y[] = { 500, 500, 571, 490 };
+	Server::ScanTable table;
+	table.build(7, Geometry::Point(x[0], y[0]), Geometry::PointSet(x, y, 4), 0);
+	CHECK(table.current(7));
+	CHECK(!table.current(8));
+
+	CHECK_EQUAL(100, table.range(0));
+	CHECK_EQUAL(100, table.range(45));
+	CHECK_EQUAL(300, table.range(358));
+
+	CHECK_EQUAL(100, table.scan(0, 0));
+	CHECK_EQUAL(100, table.scan(45, 0));
+	CHECK_EQUAL(0, table.scan(90, 10));
+	CHECK_EQUAL(300, table.scan(355, 3));
+	CHECK_EQUAL(100, table.scan(355, 5));
+}
+
+TEST(ScanWrapsAndClamps) {
+	const double x[] = { 500, 600 };
+	const double y[] = { 500, 500 };
+	Server::ScanTable table;
+	table.build(0, Geometry::Point(x[0], y[0]), Geometry::PointSet(x, y, 2), 0);
+
+	// scan(365,10) covers 355 through 15
+	CHECK_EQUAL(100, table.scan(365, 10));
+	CHECK_EQUAL(100, table.scan(-5, 10));
+	CHECK_EQUAL(100, table.scan(350, 10));
+	CHECK_EQUAL(0, table.scan(349, 10));
+	// resolution is made positive and limited to +/- 10
+	CHECK_EQUAL(100, table.scan(10, -10));
+	CHECK_EQUAL(0, table.scan(20, 45));
+}
+
+TEST(DeadRobotsAreInvisible) {
+	const double x[] = { 500, 600, 700 };
+	const double y[] = { 500, 500, 500 };
+	const unsigned char alive[] = { 1, 0, 1 };
+	Server::ScanTable table;
+	table.build(0, Geometry::Point(x[0], y[0]), Geometry::PointSet(x, y, 3), 0, alive);
+	CHECK_EQUAL(200, table.scan(0, 0));
+}
+
+TEST(TablesBuildLazilyPerTick) {
+	double x[] = { 500, 600 };
+	double y[] = { 500, 500 };
+	Geometry::PointSet robots(x, y, 2);
+	Server::ScanTables tables(2);
+	CHECK_EQUAL(100, tables.scan(0, 1, robots, 0, 0));
+	CHECK_EQUAL(100, tables.scan(1, 1, robots, 180, 0));
+
+	// positions change, but the tick has not; the table is reused
+	x[1] = 700;
+	CHECK_EQUAL(100, tables.scan(0, 1, robots, 0, 0));
+	CHECK_EQUAL(200, tables.scan(0, 2, robots, 0, 0));
+}
+
+} // suite
@@ -0,0 +1,165 @@
+// Simd.cpp
+// Runtime selection of the batch geometry kernels by CPU feature.
+
+// The kernels must give the same bits at every level, so floating-point
+// contraction is off: with FMA available, a * b + c would otherwise be
+// fused in some levels and not in others.  GCC also only vectorizes the
+// cheapest loops at -O2, which would leave every level scalar, and will not
+// turn a select between floating-point results into a blend while it
+// assumes that FP exceptions can trap; nothing here reads the exception
+// flags, and the results are the same.  Clang does both by default.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off", "no-trapping-math", "tree-vectorize", "vect-cost-model=dynamic")
+#endif
+
+#include "Simd.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "SimdKernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define JBOTS_SIMD_X86 1
+#include <cpuid.h>
+#endif
+
+namespace Geometry {
+
+namespace {
+
+////////////////////////////////////////////////////////////
+// One set of kernels per level
+//
+// Each set wraps the same inline bodies in functions compiled for its
+// instruction set; the compiler vectorizes each copy to suit.
+
+#define JBOTS_KERNEL_SET(suffix, attributes) \
+	attributes void distances_##suffix(double x, double y, const double* tx, const double* ty, \
+	                                   std::size_t n, double* out) \
+	{ SimdKernels::distances(x, y, tx, ty, n, out); } \
+	attributes void move_##suffix(double* x, double* y, const double* vx, const double* vy, \
+	                              std::size_t n) \
+	{ SimdKernels::move(x, y, vx, vy, n); } \
+	attributes void bearings_##suffix(double x, double y, const double* tx, const double* ty, \
+	                                  std::size_t n, double* out) \
+	{ SimdKernels::bearings(x, y, tx, ty, n, out); } \
+	attributes void rings_##suffix(double x, double y, const double* bx, const double* by, \
+	                               const unsigned char* alive, std::size_t n, const Rings& r, \
+	                               int* damage) \
+	{ SimdKernels::rings(x, y, bx, by, alive, n, r, damage); } \
+	attributes void normalize_##suffix(double* radians, std::size_t n) \
+	{ SimdKernels::normalize(radians, n); } \
+	const Kernels kernels_##suffix = { distances_##suffix, move_##suffix, bearings_##suffix, rings_##suffix, \
+	                                   normalize_##suffix };
+
+JBOTS_KERNEL_SET(scalar, )
+
+#if JBOTS_SIMD_X86
+JBOTS_KERNEL_SET(sse42, __attribute__((target("sse4.2"))))
+JBOTS_KERNEL_SET(avx2, __attribute__((target("avx2"))))
+JBOTS_KERNEL_SET(avx512, __attribute__((target("avx512f"))))
+#endif
+
+#undef JBOTS_KERNEL_SET
+
+////////////////////////////////////////////////////////////
+// Detection
+
+#if JBOTS_SIMD_X86
+// Which register state the operating system saves on a context switch.
+inline unsigned long long enabledState() {
+	unsigned lo, hi;
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return (static_cast<unsigned long long>(hi) << 32) | lo;
+}
+#endif
+
+SimdLevel detect() {
+#if JBOTS_SIMD_X86
+	unsigned a, b, c, d;
+	if (!__get_cpuid(1, &a, &b, &c, &d))
+		return simdScalar;
+	const bool sse42 = (c & bit_SSE4_2) != 0;
+	const bool osxsave = (c & bit_OSXSAVE) != 0;
+	if (!sse42)
+		return simdScalar;
+	if (!osxsave || !(c & bit_AVX))
+		return simdSse42;
+	const unsigned long long state = enabledState();
+	if ((state & 0x6) != 0x6)                  // XMM and YMM
+		return simdSse42;
+	if (!__get_cpuid_count(7, 0, &a, &b, &c, &d) || !(b & bit_AVX2))
+		return simdSse42;
+	if ((b & bit_AVX512F) && (state & 0xe6) == 0xe6) // plus opmask and ZMM
+		return simdAvx512;
+	return simdAvx2;
+#else
+	return simdScalar;
+#endif
+}
+
+// The level named by JBOTS_SIMD, or simdLevels if it is unset or unknown.
+SimdLevel requested() {
+	const char* const value = std::getenv("JBOTS_SIMD");
+	if (!value)
+		return simdLevels;
+	for (int level = simdScalar; level < simdLevels; ++level)
+		if (std::strcmp(value, simdName(static_cast<SimdLevel>(level))) == 0)
+			return static_cast<SimdLevel>(level);
+	return simdLevels;
+}
+
+SimdLevel clamp(const SimdLevel level) {
+	const SimdLevel best = detectedSimd();
+	return level < best ? level : best;
+}
+
+SimdLevel& active() {
+	static SimdLevel level = clamp(requested());
+	return level;
+}
+
+} // namespace
+
+const char* simdName(const SimdLevel level) {
+	switch (level) {
+		case simdScalar: return "scalar";
+		case simdSse42:  return "sse4.2";
+		case simdAvx2:   return "avx2";
+		case simdAvx512: return "avx512";
+		default:         return "unknown";
+	}
+}
+
+SimdLevel detectedSimd() {
+	static const SimdLevel level = detect();
+	return level;
+}
+
+SimdLevel activeSimd() {
+	return active();
+}
+
+SimdLevel forceSimd(const SimdLevel level) {
+	return active() = clamp(level);
+}
+
+const Kernels& kernels(const SimdLevel level) {
+	switch (level) {
+#if JBOTS_SIMD_X86
+		case simdSse42:  return kernels_sse42;
+		case simdAvx2:   return kernels_avx2;
+		case simdAvx512: return kernels_avx512;
+#endif
+		default:         return kernels_scalar;
+	}
+}
+
+const Kernels& kernels() {
+	return kernels(active());
+}
+
+} // namespace Geometry
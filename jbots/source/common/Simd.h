@@ -0,0 +1,64 @@
+// Simd.h
+// Runtime selection of the batch geometry kernels by CPU feature, so that
+// one binary uses AVX-512 or AVX2 where the CPU has them and still runs on
+// machines with only SSE4.2.
+
+#ifndef Simd_h__
+#define Simd_h__
+
+#include <cstddef>
+
+namespace Geometry {
+
+////////////////////////////////////////////////////////////
+//
+// SIMD levels
+//
+// Every level is built into the binary.  At startup the best level the CPU
+// and operating system support is chosen through CPUID.  The environment
+// variable JBOTS_SIMD (scalar, sse4.2, avx2 or avx512) forces a lower
+// level, for testing and for comparing speeds; a level the machine cannot
+// run is never chosen.  Every level gives bit-identical results.
+
+enum SimdLevel { simdScalar, simdSse42, simdAvx2, simdAvx512, simdLevels };
+
+const char* simdName(const SimdLevel level);
+SimdLevel detectedSimd();              // the best this machine supports
+SimdLevel activeSimd();                // what kernels() currently uses
+SimdLevel forceSimd(SimdLevel level);  // clamped to detectedSimd(); returns the level used
+
+////////////////////////////////////////////////////////////
+//
+// struct Kernels
+//
+// The batch kernels behind Proximity, EntityBatch::moveAll and turnAll,
+// normalizeAll and the blast damage stage.  Arrays are structure-of-arrays; 'n' is the element count.
+
+// Blast rings as squared radii, innermost first, with their damage.
+struct Rings {
+	double squared[3];
+	int damage[3];
+};
+
+struct Kernels {
+	// out[j] = squared distance from (x, y) to (tx[j], ty[j])
+	void (*distances)(double x, double y, const double* tx, const double* ty,
+	                  std::size_t n, double* out);
+	// x[i] += vx[i], y[i] += vy[i]
+	void (*move)(double* x, double* y, const double* vx, const double* vy, std::size_t n);
+	// out[j] = bearing from (x, y) to (tx[j], ty[j]), see Proximity.h
+	void (*bearings)(double x, double y, const double* tx, const double* ty,
+	                 std::size_t n, double* out);
+	// damage[i] += ring damage of an explosion at (x, y), unless alive[i] is 0
+	void (*rings)(double x, double y, const double* bx, const double* by,
+	              const unsigned char* alive, std::size_t n, const Rings& rings, int* damage);
+	// radians[i] wrapped as Angle::normalize() does
+	void (*normalize)(double* radians, std::size_t n);
+};
+
+const Kernels& kernels();                        // for activeSimd()
+const Kernels& kernels(const SimdLevel level);   // for a given level
+
+} // namespace Geometry
+
+#endif // Simd_h__
@@ -0,0 +1,97 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <cstring>
+#include <vector>
+
+#include "../Shared/Simd.h"
+
+namespace {
+
+// Inputs that exercise every branch-free select: all four quadrants, the
+// axes, coincident points, and lengths that are not a multiple of any
+// vector width.
+struct Inputs {
+	std::vector<double> x, y, vx, vy;
+	std::vector<unsigned char> alive;
+
+	explicit Inputs(const std::size_t n) {
+		unsigned long state = 7;
+		for (std::size_t i = 0; i < n; ++i) {
+			state = (state * 1103515245ul + 12345ul) & 0x7ffffffful;
+			x.push_back(i % 17 == 0 ? 500.0 : 400.0 + (state % 20000) / 100.0);
+			state = (state * 1103515245ul + 12345ul) & 0x7ffffffful;
+			y.push_back(i % 13 == 0 ? 500.0 : 400.0 + (state % 20000) / 100.0);
+			vx.push_back((state % 200) / 100.0 - 1.0);
+			vy.push_back((state % 300) / 150.0 - 1.0);
+			alive.push_back(i % 5 != 0);
+		}
+	}
+};
+
+bool sameBits(const std::vector<double>& a, const std::vector<double>& b) {
+	if (a.size() != b.size())
+		return false;
+	if (a.empty())
+		return true; // data() may be null, which memcmp() must not be given
+	return std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+}
+
+} // namespace
+
+SUITE(SimdTestSuite) {
+
+TEST(SimdLevels) {
+	CHECK(std::strcmp("avx2", Geometry::simdName(Geometry::simdAvx2)) == 0);
+	CHECK(Geometry::activeSimd() <= Geometry::detectedSimd());
+
+	// forcing never picks a level the machine cannot run
+	const Geometry::SimdLevel saved = Geometry::activeSimd();
+	CHECK_EQUAL(Geometry::simdScalar, Geometry::forceSimd(Geometry::simdScalar));
+	CHECK_EQUAL(Geometry::simdScalar, Geometry::activeSimd());
+	CHECK_EQUAL(Geometry::detectedSimd(), Geometry::forceSimd(Geometry::simdAvx512));
+	Geometry::forceSimd(saved);
+}
+
+TEST(SimdVariantsAgree) {
+	const Geometry::Rings rings = { { 25.0, 400.0, 1600.0 }, { 10, 5, 3 } };
+	const std::size_t sizes[] = { 0, 1, 3, 7, 8, 9, 31, 100, 1027 };
+	for (std::size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+		const std::size_t n = sizes[s];
+		const Inputs in(n);
+		const Geometry::Kernels& scalar = Geometry::kernels(Geometry::simdScalar);
+
+		std::vector<double> distances(n), bearings(n), x(in.x), y(in.y), radians(n);
+		std::vector<int> damage(n, 1), damageAlive(n, 1);
+		for (std::size_t i = 0; i < n; ++i)
+			radians[i] = (in.x[i] - 500.0) * in.vy[i] * 97.0;
+		const std::vector<double> turns(radians);
+		scalar.normalize(radians.data(), n);
+		scalar.distances(500.0, 500.0, in.x.data(), in.y.data(), n, distances.data());
+		scalar.bearings(500.0, 500.0, in.x.data(), in.y.data(), n, bearings.data());
+		scalar.move(x.data(), y.data(), in.vx.data(), in.vy.data(), n);
+		scalar.rings(500.0, 500.0, in.x.data(), in.y.data(), 0, n, rings, damage.data());
+		scalar.rings(510.0, 490.0, in.x.data(), in.y.data(), in.alive.data(), n, rings, damageAlive.data());
+
+		for (int level = Geometry::simdSse42; level <= Geometry::detectedSimd(); ++level) {
+			const Geometry::Kernels& k = Geometry::kernels(static_cast<Geometry::SimdLevel>(level));
+			std::vector<double> d(n), b(n), mx(in.x), my(in.y), r(turns);
+			std::vector<int> dmg(n, 1), dmgAlive(n, 1);
+			k.normalize(r.data(), n);
+			k.distances(500.0, 500.0, in.x.data(), in.y.data(), n, d.data());
+			k.bearings(500.0, 500.0, in.x.data(), in.y.data(), n, b.data());
+			k.move(mx.data(), my.data(), in.vx.data(), in.vy.data(), n);
+			k.rings(500.0, 500.0, in.x.data(), in.y.data(), 0, n, rings, dmg.data());
+			k.rings(510.0, 490.0, in.x.data(), in.y.data(), in.alive.data(), n, rings, dmgAlive.data());
+
+			CHECK(sameBits(distances, d));
+			CHECK(sameBits(bearings, b));
+			CHECK(sameBits(x, mx));
+			CHECK(sameBits(y, my));
+			CHECK(sameBits(radians, r));
+			CHECK(damage == dmg);
+			CHECK(damageAlive == dmgAlive);
+		}
+	}
+}
+
+} // suite
@@ -0,0 +1,119 @@
+// SimdKernels.h
+// Bodies of the batch kernels that Simd.cpp compiles once per instruction
+// set.  Internal to Simd.cpp; everyone else calls them through kernels().
+
+#ifndef SimdKernels_h__
+#define SimdKernels_h__
+
+#include <cmath>   // trunc()
+#include <cstddef>
+
+#include "Scalar.h"
+#include "Simd.h"
+
+namespace Geometry {
+
+namespace SimdKernels {
+
+// Every loop below is straight-line arithmetic and selects, so that the
+// compiler vectorizes it for whichever instruction set the calling wrapper
+// targets: no short-circuit operators, no division that only happens on
+// one side of a select, and nothing read through a pointer that a store in
+// the loop might alias.
+
+inline void distances(const double x, const double y, const double* tx, const double* ty,
+                      const std::size_t n, double* out)
+{
+	for (std::size_t j = 0; j < n; ++j) {
+		const double dx = tx[j] - x;
+		const double dy = ty[j] - y;
+		out[j] = dx * dx + dy * dy;
+	}
+}
+
+inline void move(double* x, double* y, const double* vx, const double* vy, const std::size_t n) {
+	for (std::size_t i = 0; i < n; ++i) {
+		x[i] += vx[i];
+		y[i] += vy[i];
+	}
+}
+
+// ScalarTraits<double>::wrap(), with the fix-ups and the final range check
+// as selects: the comparisons are combined with &, not &&.
+inline double wrap(const double r) {
+	double result = r - twopi * std::trunc(r / twopi);
+	result = result >= twopi ? result - twopi : result;
+	result = result <= -twopi ? result + twopi : result;
+	return ((result < twopi) & (result > -twopi)) ? result : 0.0;
+}
+
+inline void normalize(double* radians, const std::size_t n) {
+	for (std::size_t i = 0; i < n; ++i)
+		radians[i] = wrap(radians[i]);
+}
+
+// atan(t) for 0 <= t <= 1; Abramowitz and Stegun 4.4.49, absolute error
+// below 2e-8.
+inline double atanUnit(const double t) {
+	const double t2 = t * t;
+	return t * (1.0 + t2 * (-0.3333314528 + t2 * (0.1999355085 + t2 * (-0.1420889944
+	          + t2 * (0.1065626393 + t2 * (-0.0752896400 + t2 * (0.0429096138
+	          + t2 * (-0.0161657367 + t2 * 0.0028662257))))))));
+}
+
+// The direction of (dx, dy) in [0, twopi).  The ratio is always the smaller
+// magnitude over the larger, so it stays within the polynomial's range and
+// never divides by zero; each quadrant fix-up is a select, not a branch.
+inline double direction(const double dx, const double dy) {
+	const double ax = dx < 0.0 ? -dx : dx;
+	const double ay = dy < 0.0 ? -dy : dy;
+	const double big = ax > ay ? ax : ay;
+	const double small = ax > ay ? ay : ax;
+	double a = atanUnit(small / (big > 0.0 ? big : 1.0)); // small is 0 if big is
+	a = ay > ax ? pi / 2 - a : a;
+	a = dx < 0.0 ? pi - a : a;
+	a = dy < 0.0 ? twopi - a : a;
+	return a < twopi ? a : 0.0;
+}
+
+inline void bearings(const double x, const double y, const double* tx, const double* ty,
+                     const std::size_t n, double* out)
+{
+	for (std::size_t j = 0; j < n; ++j)
+		out[j] = direction(tx[j] - x, ty[j] - y);
+}
+
+// The damage of the innermost ring that holds a blast d2 away, squared, or
+// 0: each ring, outermost first, overrides the one outside it.
+inline int ring(const double d2, const double* squared, const int* damage) {
+	int d = damage[2] & -static_cast<int>(d2 < squared[2]);
+	d = d2 < squared[1] ? damage[1] : d;
+	return d2 < squared[0] ? damage[0] : d;
+}
+
+inline void rings(const double x, const double y, const double* bx, const double* by,
+                  const unsigned char* alive, const std::size_t n, const Rings& r, int* damage)
+{
+	// copies, which stores to damage[] cannot be taken to change
+	const double squared[3] = { r.squared[0], r.squared[1], r.squared[2] };
+	const int hit[3] = { r.damage[0], r.damage[1], r.damage[2] };
+	if (!alive) {
+		for (std::size_t i = 0; i < n; ++i) {
+			const double dx = bx[i] - x;
+			const double dy = by[i] - y;
+			damage[i] += ring(dx * dx + dy * dy, squared, hit);
+		}
+		return;
+	}
+	for (std::size_t i = 0; i < n; ++i) {
+		const double dx = bx[i] - x;
+		const double dy = by[i] - y;
+		damage[i] += ring(dx * dx + dy * dy, squared, hit) & -static_cast<int>(alive[i] != 0);
+	}
+}
+
+} // namespace SimdKernels
+
+} // namespace Geometry
+
+#endif // SimdKernels_h__
@@ -0,0 +1,455 @@
+// SpatialGrid.cpp
+// A uniform grid over the battlefield for scan and proximity queries.
+
+#include "SpatialGrid.h"
+
+#include <algorithm> // min(), max(), swap()
+#include <cmath> // fabs()
+
+#include "Proximity.h"
+#include "Trig.h"
+
+namespace Geometry {
+
+namespace {
+
+// Tests whether an offset from the cone's origin lies within +/- halfWidth of
+// its axis, using a dot product against the unit axis instead of computing
+// the offset's bearing.
+class Cone {
+private:
+	double m_ux, m_uy;  // unit vector along the axis
+	double m_cos2;      // cos(halfWidth) squared
+	bool m_acute;       // halfWidth below a right angle
+	bool m_everything;  // halfWidth covers the full circle
+public:
+	Cone(const Angle& direction, const Angle& halfWidth) {
+		fastSinCos(direction.as_r(), m_uy, m_ux);
+		double w = halfWidth.as_r();
+		if (w < 0.0)
+			w = -w;
+		const double c = fastCos(w);
+		m_cos2 = c * c;
+		m_acute = c >= 0.0;
+		m_everything = w >= pi;
+	}
+
+	bool contains(const double dx, const double dy) const {
+		if (m_everything)
+			return true;
+		const double length2 = dx * dx + dy * dy;
+		if (length2 == 0.0)
+			return true;
+		const double dot = dx * m_ux + dy * m_uy;
+		if (m_acute)
+			return dot >= 0.0 && dot * dot >= m_cos2 * length2;
+		return dot >= 0.0 || dot * dot <= m_cos2 * length2;
+	}
+};
+
+inline void extend(const double x, const double y,
+                   double& left, double& bottom, double& right, double& top)
+{
+	if (x < left) left = x;
+	if (x > right) right = x;
+	if (y < bottom) bottom = y;
+	if (y > top) top = y;
+}
+
+// The bounding box of a circular sector: its origin, the ends of its two
+// edges, and any compass extreme of the arc that falls inside the cone.
+void sectorBounds(const Point& origin, const Angle& direction, const Angle& halfWidth,
+                  const double range, const Cone& cone,
+                  double& left, double& bottom, double& right, double& top)
+{
+	left = right = origin.x();
+	bottom = top = origin.y();
+	const double w = halfWidth.as_r() < 0.0 ? -halfWidth.as_r() : halfWidth.as_r();
+	const double edges[2] = { direction.as_r() - w, direction.as_r() + w };
+	for (int e = 0; e < 2; ++e) {
+		double s, c;
+		fastSinCos(edges[e], s, c);
+		extend(origin.x() + range * c, origin.y() + range * s, left, bottom, right, top);
+	}
+	const double axes[4][2] = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+	for (int a = 0; a < 4; ++a) {
+		if (cone.contains(axes[a][0], axes[a][1]))
+			extend(origin.x() + range * axes[a][0], origin.y() + range * axes[a][1],
+			       left, bottom, right, top);
+	}
+}
+
+// Distance from a coordinate to the nearest point of an interval.
+inline double gap(const double v, const double low, const double high) {
+	return v < low ? low - v : v > high ? v - high : 0.0;
+}
+
+// A triangle that covers a circular sector whose half width is below a right
+// angle: the origin and the ends of the two edges, lengthened so that the
+// far side passes outside the arc.  The edges are widened a little, so that
+// everything Cone::contains() accepts is inside despite rounding.
+class SectorCover {
+private:
+	double m_x[3], m_y[3];
+public:
+	SectorCover(const Point& origin, const Angle& direction, const double halfWidth,
+	            const double range)
+	{
+		const double w = halfWidth + 1e-6;
+		const double reach = range / fastCos(w);
+		m_x[0] = origin.x();
+		m_y[0] = origin.y();
+		for (int e = 1; e < 3; ++e) {
+			double s, c;
+			fastSinCos(direction.as_r() + (e == 1 ? -w : w), s, c);
+			m_x[e] = origin.x() + reach * c;
+			m_y[e] = origin.y() + reach * s;
+		}
+	}
+
+	// Narrows [left, right] to the triangle's extent within the strip
+	// bottom <= y <= top.  Returns false if the triangle misses the strip.
+	bool span(const double bottom, const double top, double& left, double& right) const {
+		double lo = right, hi = left;
+		for (int i = 0; i < 3; ++i) {
+			const int j = i == 2 ? 0 : i + 1;
+			double x0 = m_x[i], y0 = m_y[i], x1 = m_x[j], y1 = m_y[j];
+			if (y0 > y1) {
+				std::swap(x0, x1);
+				std::swap(y0, y1);
+			}
+			if (y1 < bottom || y0 > top)
+				continue;
+			// clip the side to the strip
+			const double dy = y1 - y0;
+			const double xb = y0 < bottom ? x0 + (x1 - x0) * (bottom - y0) / dy : x0;
+			const double xt = y1 > top ? x0 + (x1 - x0) * (top - y0) / dy : x1;
+			lo = std::min(lo, std::min(xb, xt));
+			hi = std::max(hi, std::max(xb, xt));
+		}
+		if (lo > hi)
+			return false;
+		left = std::max(left, lo);
+		right = std::min(right, hi);
+		return left <= right;
+	}
+};
+
+} // namespace
+
+////////////////////////////////////////////////////////////
+// class SpatialGrid
+
+SpatialGrid::SpatialGrid(const double width, const double height, const double cellSize)
+	: m_width(width), m_height(height), m_cellSize(cellSize), m_size(0)
+{
+	m_columns = static_cast<std::size_t>(width / cellSize);
+	if (m_columns * cellSize < width)
+		++m_columns;
+	m_rows = static_cast<std::size_t>(height / cellSize);
+	if (m_rows * cellSize < height)
+		++m_rows;
+	if (m_columns == 0) m_columns = 1;
+	if (m_rows == 0) m_rows = 1;
+	m_cells.resize(m_columns * m_rows);
+}
+
+void SpatialGrid::column(const double x, std::size_t& c) const {
+	const double t = x / m_cellSize;
+	c = t > 0.0 ? static_cast<std::size_t>(t) : 0; // NaN lands in column 0
+	if (c >= m_columns)
+		c = m_columns - 1;
+}
+
+void SpatialGrid::row(const double y, std::size_t& r) const {
+	const double t = y / m_cellSize;
+	r = t > 0.0 ? static_cast<std::size_t>(t) : 0;
+	if (r >= m_rows)
+		r = m_rows - 1;
+}
+
+std::size_t SpatialGrid::cellOf(const double x, const double y) const {
+	std::size_t c, r;
+	column(x, c);
+	row(y, r);
+	return r * m_columns + c;
+}
+
+bool SpatialGrid::contains(const Id id) const {
+	return id < m_records.size() && m_records[id].cell != none;
+}
+
+Point SpatialGrid::position(const Id id) const {
+	return Point(m_records[id].x, m_records[id].y);
+}
+
+void SpatialGrid::link(const Id id, const std::size_t cell) {
+	std::vector<Id>& members = m_cells[cell];
+	m_records[id].cell = cell;
+	m_records[id].slot = members.size();
+	members.push_back(id);
+}
+
+void SpatialGrid::unlink(const Id id) {
+	// swap the last member of the cell into the vacated slot
+	Record& record = m_records[id];
+	std::vector<Id>& members = m_cells[record.cell];
+	const Id moved = members.back();
+	members[record.slot] = moved;
+	m_records[moved].slot = record.slot;
+	members.pop_back();
+	record.cell = none;
+}
+
+void SpatialGrid::insert(const Id id, const Point& position) {
+	if (contains(id)) {
+		update(id, position);
+		return;
+	}
+	if (id >= m_records.size()) {
+		const Record empty = { 0.0, 0.0, none, 0 };
+		m_records.resize(id + 1, empty);
+	}
+	m_records[id].x = position.x();
+	m_records[id].y = position.y();
+	link(id, cellOf(position.x(), position.y()));
+	++m_size;
+}
+
+void SpatialGrid::update(const Id id, const Point& position) {
+	Record& record = m_records[id];
+	record.x = position.x();
+	record.y = position.y();
+	const std::size_t cell = cellOf(record.x, record.y);
+	if (cell != record.cell) {
+		unlink(id);
+		link(id, cell);
+	}
+}
+
+void SpatialGrid::remove(const Id id) {
+	if (!contains(id))
+		return;
+	unlink(id);
+	--m_size;
+}
+
+void SpatialGrid::clear() {
+	for (std::size_t i = 0; i < m_cells.size(); ++i)
+		m_cells[i].clear();
+	m_records.clear();
+	m_size = 0;
+}
+
+void SpatialGrid::updateAll(const PointSet& points) {
+	for (std::size_t i = 0; i < points.count; ++i) {
+		const Point p(points.x[i], points.y[i]);
+		if (contains(i))
+			update(i, p);
+		else
+			insert(i, p);
+	}
+}
+
+void SpatialGrid::within(const Point& center, const double radius, std::vector<Id>& out) const {
+	if (radius < 0.0)
+		return;
+	const double r2 = radius * radius;
+	std::size_t c0, c1, r0, r1;
+	column(center.x() - radius, c0);
+	column(center.x() + radius, c1);
+	row(center.y() - radius, r0);
+	row(center.y() + radius, r1);
+	for (std::size_t r = r0; r <= r1; ++r) {
+		for (std::size_t c = c0; c <= c1; ++c) {
+			const std::vector<Id>& members = m_cells[r * m_columns + c];
+			for (std::size_t m = 0; m < members.size(); ++m) {
+				const Record& record = m_records[members[m]];
+				const double dx = record.x - center.x();
+				const double dy = record.y - center.y();
+				if (dx * dx + dy * dy <= r2)
+					out.push_back(members[m]);
+			}
+		}
+	}
+}
+
+void SpatialGrid::inCone(const Point& origin, const Angle& direction, const Angle& halfWidth,
+                         const double range, std::vector<Id>& out, const Id exclude) const
+{
+	if (range < 0.0)
+		return;
+	const Cone cone(direction, halfWidth);
+	double left, bottom, right, top;
+	sectorBounds(origin, direction, halfWidth, range, cone, left, bottom, right, top);
+	const double r2 = range * range;
+	std::size_t c0, c1, r0, r1;
+	column(left, c0);
+	column(right, c1);
+	row(bottom, r0);
+	row(top, r1);
+	for (std::size_t r = r0; r <= r1; ++r) {
+		for (std::size_t c = c0; c <= c1; ++c) {
+			const std::vector<Id>& members = m_cells[r * m_columns + c];
+			for (std::size_t m = 0; m < members.size(); ++m) {
+				if (members[m] == exclude)
+					continue;
+				const Record& record = m_records[members[m]];
+				const double dx = record.x - origin.x();
+				const double dy = record.y - origin.y();
+				if (dx * dx + dy * dy <= r2 && cone.contains(dx, dy))
+					out.push_back(members[m]);
+			}
+		}
+	}
+}
+
+SpatialGrid::Id SpatialGrid::nearestInCone(const Point& origin, const Angle& direction,
+                                           const Angle& halfWidth, const double range,
+                                           const Id exclude, double* distanceSquared) const
+{
+	if (range < 0.0)
+		return none;
+	const Cone cone(direction, halfWidth);
+	double left, bottom, right, top;
+	sectorBounds(origin, direction, halfWidth, range, cone, left, bottom, right, top);
+	double best = range * range;
+	Id found = none;
+	std::size_t c0, c1, r0, r1;
+	column(left, c0);
+	column(right, c1);
+	row(bottom, r0);
+	row(top, r1);
+
+	// An entity outside the grid is filed in the edge cell nearest to it, so
+	// from an origin inside the grid it is never closer than its cell, but it
+	// may be in the cone when its cell is not.  Edge cells are therefore
+	// always searched, and from outside the grid whatever their distance.
+	const bool inside = origin.x() >= 0.0 && origin.x() <= m_columns * m_cellSize
+	                 && origin.y() >= 0.0 && origin.y() <= m_rows * m_cellSize;
+	const double w = std::fabs(halfWidth.as_r());
+	const bool narrow = w < pi / 3;
+	const SectorCover cover(origin, direction, narrow ? w : 0.0, range);
+
+	const auto search = [&](const std::size_t c, const std::size_t r, const double dy2) {
+		const std::vector<Id>& members = m_cells[r * m_columns + c];
+		if (members.empty())
+			return;
+		const double dx = gap(origin.x(), c * m_cellSize, (c + 1) * m_cellSize);
+		// skip cells that cannot hold anything closer than the best so far
+		if (dx * dx + dy2 > best && (inside || (c != 0 && r != 0 && c != m_columns - 1 && r != m_rows - 1)))
+			return;
+		for (std::size_t m = 0; m < members.size(); ++m) {
+			const Id id = members[m];
+			if (id == exclude)
+				continue;
+			const Record& record = m_records[id];
+			const double ex = record.x - origin.x();
+			const double ey = record.y - origin.y();
+			const double d2 = ex * ex + ey * ey;
+			if ((d2 < best || (d2 == best && id < found)) && cone.contains(ex, ey)) {
+				best = d2;
+				found = id;
+			}
+		}
+	};
+
+	// Visit rows outward from the origin's row, and in each row only the
+	// cells under a triangle covering the cone, outward from the origin's
+	// column.  Once a row, or the rest of a row, is further away than the
+	// best so far, nothing beyond it can do better.
+	std::size_t originColumn, originRow;
+	column(origin.x(), originColumn);
+	row(origin.y(), originRow);
+	const std::size_t rows = std::max(originRow - r0, r1 - originRow);
+	for (std::size_t d = 0; d <= rows; ++d) {
+		if (inside && d > 0) {
+			const double reach = (d - 1) * m_cellSize;
+			if (reach * reach > best)
+				break;
+		}
+		for (int side = 0; side < (d == 0 ? 1 : 2); ++side) {
+			if (side == 0 ? originRow < r0 + d : originRow + d > r1)
+				continue;
+			const std::size_t r = side == 0 ? originRow - d : originRow + d;
+			const double rowBottom = r * m_cellSize;
+			const double dy = gap(origin.y(), rowBottom, rowBottom + m_cellSize);
+			const double dy2 = dy * dy;
+			std::size_t cLow = c0, cHigh = c1;
+			double spanLeft = c0 * m_cellSize, spanRight = (c1 + 1) * m_cellSize;
+			if (narrow && r != 0 && r != m_rows - 1) {
+				if (cover.span(rowBottom, rowBottom + m_cellSize, spanLeft, spanRight)) {
+					column(spanLeft - 1e-3, cLow);
+					column(spanRight + 1e-3, cHigh);
+					cLow = std::max(cLow, c0);
+					cHigh = std::min(cHigh, c1);
+				} else {
+					cLow = c1 + 1; // only the edge cells below
+				}
+				if (c0 == 0 && cLow > 0)
+					search(0, r, dy2);
+				if (c1 == m_columns - 1 && (cHigh < c1 || cLow > c1) && c1 != 0)
+					search(c1, r, dy2);
+				if (cLow > cHigh)
+					continue;
+			}
+			// outward from the origin's column, or the nearer end of the span
+			const std::size_t start = std::min(std::max(originColumn, cLow), cHigh);
+			for (std::size_t c = start; c <= cHigh; ++c) {
+				const double dx = c * m_cellSize - origin.x();
+				if (inside && c > start && dx * dx + dy2 > best)
+					break;
+				search(c, r, dy2);
+			}
+			for (std::size_t c = start; c-- > cLow; ) {
+				const double dx = origin.x() - (c + 1) * m_cellSize;
+				if (inside && dx * dx + dy2 > best)
+					break;
+				search(c, r, dy2);
+			}
+		}
+	}
+	if (found != none && distanceSquared)
+		*distanceSquared = best;
+	return found;
+}
+
+////////////////////////////////////////////////////////////
+// class TrackedEntity
+
+const Point& TrackedEntity::setPosition(const Point& position) {
+	m_entity.setPosition(position);
+	if (m_grid)
+		m_grid->update(m_gridId, position);
+	return this->position();
+}
+
+void TrackedEntity::move() {
+	setPosition(position() + velocity());
+}
+
+TrackedEntity& TrackedEntity::operator=(const Entity& other) {
+	m_entity = other;
+	if (m_grid)
+		m_grid->update(m_gridId, position());
+	return *this;
+}
+
+TrackedEntity& TrackedEntity::operator=(const TrackedEntity& other) {
+	return *this = other.m_entity;
+}
+
+void TrackedEntity::track(SpatialGrid& grid, const SpatialGrid::Id id) {
+	untrack();
+	m_grid = &grid;
+	m_gridId = id;
+	m_grid->insert(m_gridId, position());
+}
+
+void TrackedEntity::untrack() {
+	if (m_grid)
+		m_grid->remove(m_gridId);
+	m_grid = 0;
+}
+
+} // namespace Geometry
@@ -0,0 +1,139 @@
+// SpatialGrid.h
+// A uniform grid over the battlefield for scan and proximity queries whose
+// cost depends on how crowded the neighbourhood is, not on how many entities
+// exist.
+
+#ifndef SpatialGrid_h__
+#define SpatialGrid_h__
+
+#include <cstddef>
+#include <vector>
+
+#include "Geometry.h"
+
+namespace Geometry {
+
+struct PointSet;
+
+////////////////////////////////////////////////////////////
+//
+// class SpatialGrid
+//
+// Buckets entities by position into square cells.  Entities are identified
+// by a caller-chosen Id, typically an index into some other container, and
+// Ids should be dense because the grid keeps a table indexed by Id.
+// Positions outside the grid are kept in the nearest edge cell, so nothing
+// is ever lost.  Moving within a cell is O(1) and only touches the entity's
+// own record; crossing into another cell is O(1) amortized.
+//
+// Query results are appended to a caller-provided vector so that a caller
+// who keeps the vector around does not allocate per query.  Boundaries are
+// inclusive: an entity exactly 'range' away is found.
+
+class SpatialGrid {
+public:
+	typedef std::size_t Id;
+	static const Id none = static_cast<Id>(-1);
+
+private:
+	struct Record {
+		double x, y;
+		std::size_t cell;  // none if the Id is not in the grid
+		std::size_t slot;  // position within the cell's member list
+	};
+
+	double m_width, m_height, m_cellSize;
+	std::size_t m_columns, m_rows;
+	std::vector<std::vector<Id> > m_cells;
+	std::vector<Record> m_records;
+	std::size_t m_size;
+
+	std::size_t cellOf(const double x, const double y) const;
+	void column(const double x, std::size_t& c) const;
+	void row(const double y, std::size_t& r) const;
+	void unlink(const Id id);
+	void link(const Id id, const std::size_t cell);
+
+public:
+	// Creators
+	explicit SpatialGrid(const double width = 1000.0, const double height = 1000.0,
+	                     const double cellSize = 50.0);
+
+	// Accessors
+	std::size_t size() const { return m_size; }
+	bool contains(const Id id) const;
+	Point position(const Id id) const;
+	double cellSize() const { return m_cellSize; }
+
+	// Appends every entity within 'radius' of 'center'.
+	void within(const Point& center, const double radius, std::vector<Id>& out) const;
+
+	// Appends every entity within 'range' of 'origin' whose bearing is within
+	// +/- 'halfWidth' of 'direction'.  An entity at 'origin' itself is
+	// included; pass its Id as 'exclude' to skip it.
+	void inCone(const Point& origin, const Angle& direction, const Angle& halfWidth,
+	            const double range, std::vector<Id>& out, const Id exclude = none) const;
+
+	// The closest entity in the cone described above, or none.  If found and
+	// 'distanceSquared' is given, it receives the squared distance.
+	Id nearestInCone(const Point& origin, const Angle& direction, const Angle& halfWidth,
+	                 const double range, const Id exclude = none,
+	                 double* distanceSquared = 0) const;
+
+	// Modifiers
+	void insert(const Id id, const Point& position);
+	void update(const Id id, const Point& position);
+	void remove(const Id id);
+	void clear();
+
+	// Re-files every point of 'points' under its index, inserting any index
+	// not yet in the grid.  Use after EntityBatch::moveAll().
+	void updateAll(const PointSet& points);
+};
+
+////////////////////////////////////////////////////////////
+//
+// class TrackedEntity
+//
+// An Entity that keeps its record in a SpatialGrid up to date: every
+// position change, including move(), is passed on to the grid.  It holds
+// its Entity rather than being one, so that nothing can move it through an
+// Entity& behind the grid's back; BasicDrive steps it like an Entity.
+// Unlike Entity this is not a plain value; copies are not tracked, and the
+// record is removed when the entity is destroyed.
+
+class TrackedEntity {
+private:
+	Entity m_entity;
+	SpatialGrid* m_grid;
+	SpatialGrid::Id m_gridId;
+
+public:
+	// Creators
+	TrackedEntity() : m_grid(0), m_gridId(0) {}
+	explicit TrackedEntity(const Entity& entity) : m_entity(entity), m_grid(0), m_gridId(0) {}
+	TrackedEntity(const TrackedEntity& other) : m_entity(other.m_entity), m_grid(0), m_gridId(0) {}
+	~TrackedEntity() { untrack(); }
+
+	// Accessors
+	const Entity& entity() const { return m_entity; }
+	const Point& position() const { return m_entity.position(); }
+	const Angle& facing() const { return m_entity.facing(); }
+	double speed() const { return m_entity.speed(); }
+	const Point& velocity() const { return m_entity.velocity(); }
+	bool tracked() const { return m_grid != 0; }
+
+	// Modifiers
+	const Point& setPosition(const Point& position);
+	const Angle& setFacing(const Angle& facing) { return m_entity.setFacing(facing); }
+	double setSpeed(const double speed) { return m_entity.setSpeed(speed); }
+	void move();
+	TrackedEntity& operator=(const Entity& other);
+	TrackedEntity& operator=(const TrackedEntity& other);
+	void track(SpatialGrid& grid, const SpatialGrid::Id id); // inserts into the grid
+	void untrack();                                          // removes from the grid
+};
+
+} // namespace Geometry
+
+#endif // SpatialGrid_h__
@@ -0,0 +1,206 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "../Shared/Geometry.h"
+#include "../Shared/Proximity.h"
+#include "../Shared/SpatialGrid.h"
+
+// Moving a TrackedEntity through an Entity& would leave its grid record
+// behind.
+static_assert(!std::is_convertible<Geometry::TrackedEntity&, Geometry::Entity&>::value,
+              "a TrackedEntity must not bind to an Entity&");
+
+namespace {
+
+std::vector<Geometry::SpatialGrid::Id> sorted(std::vector<Geometry::SpatialGrid::Id> ids) {
+	std::sort(ids.begin(), ids.end());
+	return ids;
+}
+
+double degrees(double d) { return Geometry::Angle::d2r(d); }
+
+}
+
+SUITE(SpatialGridTestSuite) {
+
+TEST(InsertUpdateRemove) {
+	Geometry::SpatialGrid grid;
+	grid.insert(3, Geometry::Point(10, 10));
+	grid.insert(7, Geometry::Point(900, 900));
+	CHECK_EQUAL(2u, grid.size());
+	CHECK(grid.contains(3));
+	CHECK(!grid.contains(4));
+
+	grid.update(3, Geometry::Point(880, 880));
+	CHECK(grid.position(3) == Geometry::Point(880, 880));
+
+	std::vector<Geometry::SpatialGrid::Id> found;
+	grid.within(Geometry::Point(890, 890), 30, found);
+	CHECK_EQUAL(2u, found.size());
+
+	grid.remove(7);
+	CHECK_EQUAL(1u, grid.size());
+	found.clear();
+	grid.within(Geometry::Point(890, 890), 30, found);
+	CHECK_EQUAL(1u, found.size());
+	CHECK_EQUAL(3u, found[0]);
+}
+
+TEST(RadiusQueryMatchesBruteForce) {
+	Geometry::SpatialGrid grid;
+	std::vector<Geometry::Point> points;
+	for (int i = 0; i < 500; ++i) {
+		Geometry::Point p((i * 37) % 1000, (i * 91) % 1000);
+		points.push_back(p);
+		grid.insert(i, p);
+	}
+	const Geometry::Point center(480, 520);
+	std::vector<Geometry::SpatialGrid::Id> found;
+	grid.within(center, 120, found);
+	std::vector<Geometry::SpatialGrid::Id> expected;
+	for (std::size_t i = 0; i < points.size(); ++i)
+		if (Geometry::distanceSquared(center, points[i]) <= 120 * 120)
+			expected.push_back(i);
+	CHECK(sorted(found) == expected);
+}
+
+TEST(OutsideGridIsKept) {
+	Geometry::SpatialGrid grid;
+	grid.insert(0, Geometry::Point(-20, 1200));
+	std::vector<Geometry::SpatialGrid::Id> found;
+	grid.within(Geometry::Point(0, 1000), 250, found);
+	CHECK_EQUAL(1u, found.size());
+}
+
+TEST(ConeQuery) {
+	Geometry::SpatialGrid grid;
+	const Geometry::Point origin(500, 500);
+	grid.insert(0, origin);                              // the scanner itself
+	grid.insert(1, Geometry::Point(600, 505));           // east, ~3 degrees
+	grid.insert(2, Geometry::Point(700, 560));           // east, ~17 degrees
+	grid.insert(3, Geometry::Point(400, 500));           // west
+	grid.insert(4, Geometry::Point(950, 500));           // east, out of range
+	grid.insert(5, Geometry::Point(600, 490));           // just below east
+
+	std::vector<Geometry::SpatialGrid::Id> found;
+	grid.inCone(origin, degrees(0), degrees(10), 400, found, 0);
+	std::vector<Geometry::SpatialGrid::Id> expected;
+	expected.push_back(1);
+	expected.push_back(5);
+	CHECK(sorted(found) == expected);
+
+	double d2 = 0;
+	CHECK_EQUAL(1u, grid.nearestInCone(origin, degrees(0), degrees(10), 400, 0, &d2));
+	CHECK_CLOSE(100 * 100 + 5 * 5, d2, 0.0001);
+	CHECK_EQUAL(2u, grid.nearestInCone(origin, degrees(17), degrees(1), 400, 0));
+	CHECK_EQUAL(3u, grid.nearestInCone(origin, degrees(180), degrees(10), 400, 0));
+	CHECK_EQUAL(Geometry::SpatialGrid::none, grid.nearestInCone(origin, degrees(90), degrees(10), 400, 0));
+
+	// a full-circle cone is a radius query
+	found.clear();
+	grid.inCone(origin, 0, degrees(180), 1000, found, 0);
+	CHECK_EQUAL(5u, found.size());
+}
+
+TEST(ConeWrapsAroundZero) {
+	Geometry::SpatialGrid grid;
+	grid.insert(0, Geometry::Point(600, 480));  // about 349 degrees from origin
+	const Geometry::Point origin(500, 500);
+	CHECK_EQUAL(0u, grid.nearestInCone(origin, degrees(5), degrees(20), 200));
+	CHECK_EQUAL(0u, grid.nearestInCone(origin, degrees(-10), degrees(5), 200));
+	CHECK_EQUAL(Geometry::SpatialGrid::none, grid.nearestInCone(origin, degrees(10), degrees(5), 200));
+}
+
+TEST(NearestInConeMatchesBruteForce) {
+	// a crowded field with a few entities off the grid, searched from inside
+	// and outside the grid in every direction and at several widths
+	Geometry::SpatialGrid grid;
+	std::vector<Geometry::Point> points;
+	for (int i = 0; i < 400; ++i) {
+		Geometry::Point p((i * 37) % 1100 - 50.0, (i * 91) % 1100 - 50.0);
+		points.push_back(p);
+		grid.insert(i, p);
+	}
+	const Geometry::Point origins[] = {
+		Geometry::Point(480, 520), Geometry::Point(3, 997), Geometry::Point(-30, 500), Geometry::Point(1040, 1040)
+	};
+	const double widths[] = { 0.5, 3, 10.5, 60, 120 };
+	for (int o = 0; o < 4; ++o) {
+		for (int w = 0; w < 5; ++w) {
+			for (int d = 0; d < 360; d += 7) {
+				const Geometry::Angle direction = degrees(d), halfWidth = degrees(widths[w]);
+				std::vector<Geometry::SpatialGrid::Id> cone;
+				grid.inCone(origins[o], direction, halfWidth, 1500, cone);
+				Geometry::SpatialGrid::Id expected = Geometry::SpatialGrid::none;
+				for (std::size_t i = 0; i < cone.size(); ++i) {
+					if (expected == Geometry::SpatialGrid::none
+					    || Geometry::distanceSquared(origins[o], points[cone[i]]) < Geometry::distanceSquared(origins[o], points[expected])
+					    || (Geometry::distanceSquared(origins[o], points[cone[i]]) == Geometry::distanceSquared(origins[o], points[expected])
+					        && cone[i] < expected))
+						expected = cone[i];
+				}
+				CHECK_EQUAL(expected, grid.nearestInCone(origins[o], direction, halfWidth, 1500));
+			}
+		}
+	}
+}
+
+TEST(EntityTracking) {
+	Geometry::SpatialGrid grid;
+	{
+		Geometry::TrackedEntity e(Geometry::Entity(Geometry::Point(100, 100), Geometry::Angle(0), 100));
+		e.track(grid, 2);
+		CHECK(e.tracked());
+		CHECK(grid.contains(2));
+		e.move();
+		CHECK(grid.position(2).near(Geometry::Point(200, 100), 0.001));
+
+		Geometry::TrackedEntity copy(e);
+		CHECK(!copy.tracked());
+		copy.setPosition(Geometry::Point(0, 0));
+		CHECK(grid.position(2).near(Geometry::Point(200, 100), 0.001));
+	}
+	CHECK(!grid.contains(2));
+}
+
+TEST(DrivenEntityStaysTracked) {
+	// a Drive moves it like an Entity, and every query sees where it went
+	Geometry::SpatialGrid grid;
+	Geometry::TrackedEntity e(Geometry::Entity(Geometry::Point(100, 100), Geometry::Angle(0), 0));
+	e.track(grid, 3);
+	Geometry::Drive drive = Geometry::Drive::crobots(30);
+	drive.set(Geometry::Angle(0), 30);
+	for (int i = 0; i < 20; ++i)
+		drive.step(e);
+	CHECK(e.position().x() > 400);
+	CHECK(grid.position(3).near(e.position(), 0.001));
+
+	std::vector<Geometry::SpatialGrid::Id> found;
+	grid.within(e.position(), 1, found);
+	CHECK_EQUAL(1u, found.size());
+	found.clear();
+	grid.within(Geometry::Point(100, 100), 50, found);
+	CHECK(found.empty());
+	CHECK_EQUAL(3u, grid.nearestInCone(Geometry::Point(0, e.position().y()), Geometry::Angle(0),
+	                                   Geometry::Angle(0.01), 1000));
+
+	e = Geometry::Entity(Geometry::Point(900, 900), Geometry::Angle(0), 0);
+	CHECK(grid.position(3).near(Geometry::Point(900, 900), 0.001));
+}
+
+TEST(UpdateAllFromBatch) {
+	Geometry::EntityBatch batch;
+	batch.add(Geometry::Entity(Geometry::Point(10, 10), Geometry::Angle(0), 100));
+	batch.add(Geometry::Entity(Geometry::Point(500, 500), Geometry::Angle(0), 0));
+	Geometry::SpatialGrid grid;
+	grid.updateAll(Geometry::points(batch));
+	batch.moveAll();
+	grid.updateAll(Geometry::points(batch));
+	CHECK(grid.position(0).near(Geometry::Point(110, 10), 0.001));
+	CHECK_EQUAL(2u, grid.size());
+}
+
+} // suite
@@ -0,0 +1,110 @@
+// Tiers.test.h
+// What the tests of the Cpu's faster tiers share: a host that logs every
+// call, a harness that runs a robot on the stack tier and on another tier
+// side by side, and robots that try every operator on awkward values.
+
+#ifndef Tiers_test_h__
+#define Tiers_test_h__
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Aot.h"
+#include "Cpu.h"
+
+namespace TierTest {
+
+// Answers from a fixed sequence, and logs every call, so that two runs of
+// the same robot can be compared call for call.
+struct Logger : Vm::Host {
+	std::vector<Vm::Word> log;
+	Vm::Word next;
+
+	Logger() : next(12345) {}
+
+	Vm::Word answer(const int call, const Vm::Word x, const Vm::Word y) {
+		log.push_back(call);
+		log.push_back(x);
+		log.push_back(y);
+		next = static_cast<Vm::Word>(static_cast<std::uint32_t>(next) * 1103515245u + 12345u);
+		return (next >> 16) & 1023;
+	}
+	Vm::Word scan(const Vm::Word degree, const Vm::Word resolution) { return answer(0, degree, resolution) % 700; }
+	Vm::Word cannon(const Vm::Word degree, const Vm::Word range) { return answer(1, degree, range) & 1; }
+	void drive(const Vm::Word degree, const Vm::Word speed) { answer(2, degree, speed); }
+	Vm::Word damage() { return answer(3, 0, 0) % 100; }
+	Vm::Word speed() { return answer(4, 0, 0) % 101; }
+	Vm::Word locX() { return answer(5, 0, 0) % 1000; }
+	Vm::Word locY() { return answer(6, 0, 0) % 1000; }
+};
+
+// Runs 'stack' and 'other', both on 'image', in the same chunks of cycles,
+// and checks that they agree after every chunk.  One chunk runs them
+// straight through; more stop them at random points along the way.
+inline bool agree(const Vm::Image& image, Vm::Cpu& stack, const Logger& stackHost,
+                  Vm::Cpu& other, const Logger& otherHost, const long cycles, const unsigned chunks)
+{
+	std::srand(chunks);
+	for (long done = 0; done < cycles; ) {
+		const long chunk = chunks == 1 ? cycles : 1 + std::rand() % (2 * cycles / chunks);
+		stack.run(chunk);
+		other.run(chunk);
+		done += chunk;
+		if (stackHost.log != otherHost.log || stack.overflows() != other.overflows() ||
+		    stack.random() != other.random() || stack.cycles() != other.cycles())
+			return false;
+		for (int i = 0; i < image.externals; ++i)
+			if (stack.external(i) != other.external(i))
+				return false;
+	}
+	return true;
+}
+
+// 'image' on 'tier' against the stack tier.
+inline bool agree(const Vm::Image& image, const Vm::Cpu::Tier tier, const long cycles, const unsigned chunks = 1) {
+	Logger stackHost, otherHost;
+	Vm::Cpu stack(image, &stackHost, 7, Vm::Cpu::stack);
+	Vm::Cpu other(image, &otherHost, 7, tier);
+	return agree(image, stack, stackHost, other, otherHost, cycles, chunks);
+}
+
+// 'image' compiled to 'module' against the stack tier.
+inline bool agree(const Vm::Image& image, const Vm::Module& module, const long cycles, const unsigned chunks = 1) {
+	Logger stackHost, otherHost;
+	Vm::Cpu stack(image, &stackHost, 7, Vm::Cpu::stack);
+	Vm::Cpu other(image, module, &otherHost, 7);
+	return agree(image, stack, stackHost, other, otherHost, cycles, chunks);
+}
+
+// Every binary operator, and the values on which real hardware traps or
+// wraps.
+const char* const operators[] = { "+", "-", "*", "/", "%", "<<", ">>", "&", "|", "^",
+                                  "&&", "||", "<", "<=", "==", "!=", ">=", ">" };
+const int operatorCount = sizeof(operators) / sizeof(operators[0]);
+const char* const values[] = { "0", "1", "-1", "-7", "33", "2147483647", "(-2147483647 - 1)" };
+const int valueCount = sizeof(values) / sizeof(values[0]);
+
+// A robot that applies operators[o] to every pair of values, once as
+// constants, each into an external of its own, and once as arguments.
+inline std::string operatorProgram(const int o) {
+	std::string externals = "int r", constants, main, each = "each(x) int x; {\n";
+	for (int x = 0; x < valueCount; ++x) {
+		main += std::string("  each(") + values[x] + ");\n";
+		each += std::string("  both(x, ") + values[x] + ");\n";
+		for (int y = 0; y < valueCount; ++y) {
+			const std::string r = "r" + std::to_string(x * valueCount + y);
+			externals += ", " + r;
+			constants += "  " + r + " = " + values[x] + " " + operators[o] + " " + values[y] + ";\n";
+		}
+	}
+	return externals + ";\n" +
+	       "main() {\n" + constants + main + "}\n" +
+	       each + "}\n" +
+	       "both(x, y) int x, y; {\n  r = r * 31 + (x " + operators[o] + " y);\n}\n";
+}
+
+} // namespace TierTest
+
+#endif // Tiers_test_h__
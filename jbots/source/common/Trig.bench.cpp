@@ -0,0 +1,122 @@
+// Trig.bench.cpp
+// Compares the table-driven trigonometry in Trig.h with the libm path it
+// replaced.  Built on its own, outside of jbots-test, from this directory:
+//   mkdir -p /tmp/jbots/include && ln -sfn "$PWD" /tmp/jbots/Shared
+//   c++ -std=c++20 -O2 -I/tmp/jbots/include Trig.bench.cpp Trig.cpp Geometry.cpp Simd.cpp Fixed.cpp -o trig-bench
+// The sources include "../Shared/X.h", which the first line makes resolve
+// from /tmp/jbots/include to this directory.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../Shared/Geometry.h"
+#include "../Shared/Trig.h"
+
+namespace {
+
+const int iterations = 10000000;
+
+// Keeps the optimizer from discarding the measured work.
+volatile double sink;
+
+template <typename Function>
+void report(const char* name, Function f) {
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point start = Clock::now();
+	const double result = f();
+	const Clock::time_point stop = Clock::now();
+	sink = result;
+	const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+	std::printf("%-28s %8.2f ns/op\n", name, ns / iterations);
+}
+
+const double degToRad = 3.14159265358979323846 / 180.0;
+
+double libmIntegerSin() {
+	long total = 0;
+	for (int i = 0; i < iterations; ++i)
+		total += static_cast<int>(sin((i % 360) * degToRad) * Geometry::trigScale);
+	return static_cast<double>(total);
+}
+
+double tableIntegerSin() {
+	long total = 0;
+	for (int i = 0; i < iterations; ++i)
+		total += Geometry::isin(i);
+	return static_cast<double>(total);
+}
+
+double libmAtan() {
+	long total = 0;
+	for (int i = 0; i < iterations; ++i)
+		total += static_cast<int>(atan((i - iterations / 2) / 1000.0) / degToRad);
+	return static_cast<double>(total);
+}
+
+double tableAtan() {
+	long total = 0;
+	for (int i = 0; i < iterations; ++i)
+		total += Geometry::iatan((i - iterations / 2) * 100);
+	return static_cast<double>(total);
+}
+
+double libmSinCos() {
+	double total = 0.0;
+	for (int i = 0; i < iterations; ++i) {
+		const double r = i * 0.001;
+		total += sin(r) + cos(r);
+	}
+	return total;
+}
+
+double tableSinCos() {
+	double total = 0.0;
+	for (int i = 0; i < iterations; ++i) {
+		double s, c;
+		Geometry::fastSinCos(i * 0.001, s, c);
+		total += s + c;
+	}
+	return total;
+}
+
+// The body of Entity::move() before it switched to the lookup tables.
+double libmMove() {
+	std::vector<Geometry::Entity> entities(100);
+	for (std::size_t i = 0; i < entities.size(); ++i)
+		entities[i] = Geometry::Entity(Geometry::Point(), Geometry::Angle(i * 0.1), 1.0);
+	for (int n = 0; n < iterations / 100; ++n) {
+		for (std::size_t i = 0; i < entities.size(); ++i) {
+			Geometry::Entity& e = entities[i];
+			const double r = e.facing().as_r();
+			Geometry::Point velocity(e.speed() * cos(r), e.speed() * sin(r));
+			e.setPosition(e.position() + velocity);
+		}
+	}
+	return entities[1].position().x();
+}
+
+double tableMove() {
+	std::vector<Geometry::Entity> entities(100);
+	for (std::size_t i = 0; i < entities.size(); ++i)
+		entities[i] = Geometry::Entity(Geometry::Point(), Geometry::Angle(i * 0.1), 1.0);
+	for (int n = 0; n < iterations / 100; ++n)
+		for (std::size_t i = 0; i < entities.size(); ++i)
+			entities[i].move();
+	return entities[1].position().x();
+}
+
+} // namespace
+
+int main(const int, char const**) {
+	report("isin (libm)", libmIntegerSin);
+	report("isin (table)", tableIntegerSin);
+	report("iatan (libm)", libmAtan);
+	report("iatan (table)", tableAtan);
+	report("sin+cos (libm)", libmSinCos);
+	report("sin+cos (table)", tableSinCos);
+	report("Entity::move (libm)", libmMove);
+	report("Entity::move (table)", tableMove);
+	return 0;
+}
@@ -0,0 +1,293 @@
+// Trig.cpp
+// Table-driven trigonometry for the physics engine and the robot intrinsic
+// library.
+
+#include "Trig.h"
+
+#include <climits>
+#include <cstdint>
+
+#include "Geometry.h"
+
+namespace Geometry {
+
+namespace {
+
+constexpr double degreesToRadians = pi / 180.0;
+
+// Radian table: one full turn in fineSteps entries, plus one so that
+// interpolation never has to wrap.  Cosine reads the same table a quarter
+// turn ahead.
+const int fineSteps = 4096;
+const int fineMask = fineSteps - 1;
+const int quarterTurn = fineSteps / 4;
+constexpr double stepsPerRadian = fineSteps / twopi;
+
+// Fixed-point reads: an angle's raw value times stepsPerRawAngle is its
+// table position with 16 fraction bits.  The atan table covers ratios 0 to 1
+// in 16.16, atanShift bits per step.
+const std::int64_t stepsPerRawAngle = static_cast<std::int64_t>(stepsPerRadian * Fixed::one + 0.5);
+const int atanShift = 6;
+const int atanSteps = Fixed::one >> atanShift;
+const std::int32_t fixedHalfPi = Fixed(pi / 2).raw();
+const std::int32_t fixedPi = Fixed(pi).raw();
+const std::int32_t fixedTwoPi = Fixed(twopi).raw();
+
+// Beyond this the table index no longer fits in 64 bits.
+constexpr double fineLimit = 9.0e18;
+
+////////////////////////////////////////////////////////////
+// Compile-time sine and cosine
+//
+// Evaluated in long double and rounded once to double, which reproduces a
+// correctly rounded libm for every table entry.  Only used to build the
+// tables, so speed does not matter.
+
+constexpr long double longPi = 3.14159265358979323846264338327950288L;
+
+// Taylor series, for |x| <= pi/4
+constexpr long double seriesSin(const long double x) {
+	long double term = x, sum = x;
+	for (int n = 1; n < 14; ++n) {
+		term *= -x * x / ((2 * n) * (2 * n + 1));
+		sum += term;
+	}
+	return sum;
+}
+
+constexpr long double seriesCos(const long double x) {
+	long double term = 1.0L, sum = 1.0L;
+	for (int n = 1; n < 14; ++n) {
+		term *= -x * x / ((2 * n - 1) * (2 * n));
+		sum += term;
+	}
+	return sum;
+}
+
+// Reduces x, 0 <= x <= 2pi, to a quarter turn and the remainder within
+// +/- pi/4 of it.
+constexpr void quarterReduce(const long double x, int& quarter, long double& rest) {
+	quarter = static_cast<int>(x / (longPi / 2) + 0.5L);
+	rest = x - quarter * (longPi / 2);
+}
+
+constexpr double compileSin(const double x) {
+	int q = 0;
+	long double r = 0.0L;
+	quarterReduce(x, q, r);
+	switch (q & 3) {
+		case 0:  return static_cast<double>(seriesSin(r));
+		case 1:  return static_cast<double>(seriesCos(r));
+		case 2:  return static_cast<double>(-seriesSin(r));
+		default: return static_cast<double>(-seriesCos(r));
+	}
+}
+
+constexpr double compileCos(const double x) {
+	int q = 0;
+	long double r = 0.0L;
+	quarterReduce(x, q, r);
+	switch (q & 3) {
+		case 0:  return static_cast<double>(seriesCos(r));
+		case 1:  return static_cast<double>(-seriesSin(r));
+		case 2:  return static_cast<double>(-seriesCos(r));
+		default: return static_cast<double>(seriesSin(r));
+	}
+}
+
+constexpr double compileTan(const double x) {
+	int q = 0;
+	long double r = 0.0L;
+	quarterReduce(x, q, r);
+	const long double s = seriesSin(r), c = seriesCos(r);
+	return static_cast<double>((q & 1) ? -c / s : s / c);
+}
+
+// Solves tan(a) = x, 0 <= x <= 1, by Newton's method.
+constexpr double compileAtan(const double x) {
+	double a = x * (longPi / 4);
+	for (int n = 0; n < 8; ++n) {
+		const double t = compileTan(a);
+		a -= (t - x) / (1.0 + t * t);
+	}
+	return a;
+}
+
+constexpr std::int32_t roundToFixed(const double value) {
+	return value >= 0.0 ? static_cast<std::int32_t>(value * Fixed::one + 0.5)
+	                    : -static_cast<std::int32_t>(-value * Fixed::one + 0.5);
+}
+
+constexpr int clampToInt(const double value) {
+	return value >= INT_MAX ? INT_MAX
+	     : value <= INT_MIN ? INT_MIN
+	     : static_cast<int>(value);
+}
+
+////////////////////////////////////////////////////////////
+// The tables
+
+struct Tables {
+	double fineSin[fineSteps + 1];
+
+	// Integer tables, indexed by whole degree 0-359.
+	int degreeSin[360];
+	int degreeCos[360];
+	int degreeTan[360];
+
+	// atanLimit[d] is tan(d) * trigScale for d = 1..89; iatan() counts how
+	// many of these a ratio reaches.
+	double atanLimit[90];
+
+	// Fixed-point copies: fineSin in 16.16, and atan over ratios 0 to 1 in
+	// atanSteps steps.
+	std::int32_t fixedSin[fineSteps + 1];
+	std::int32_t fixedAtan[atanSteps + 1];
+};
+
+constexpr Tables buildTables() {
+	Tables t = {};
+	for (int i = 0; i <= fineSteps; ++i)
+		t.fineSin[i] = compileSin(i / stepsPerRadian);
+	for (int d = 0; d < 360; ++d) {
+		const double r = d * degreesToRadians;
+		t.degreeSin[d] = static_cast<int>(compileSin(r) * trigScale);
+		t.degreeCos[d] = static_cast<int>(compileCos(r) * trigScale);
+		t.degreeTan[d] = clampToInt(compileTan(r) * trigScale);
+	}
+	// tan() of the nearest double to a right angle is finite; pin the sign
+	t.degreeTan[90] = INT_MAX;
+	t.degreeTan[270] = INT_MIN;
+	for (int d = 1; d < 90; ++d)
+		t.atanLimit[d] = compileTan(d * degreesToRadians) * trigScale;
+	for (int i = 0; i <= fineSteps; ++i)
+		t.fixedSin[i] = roundToFixed(t.fineSin[i]);
+	for (int i = 0; i <= atanSteps; ++i)
+		t.fixedAtan[i] = roundToFixed(compileAtan(static_cast<double>(i) / atanSteps));
+	return t;
+}
+
+constexpr Tables tables = buildTables();
+
+// Splits an angle into a table index and the fraction toward the next entry.
+inline void fineIndex(const double radians, int& index, double& fraction) {
+	double t = radians * stepsPerRadian;
+	if (!(t > -fineLimit && t < fineLimit))
+		t = 0.0; // non-finite or meaningless; read as zero
+	long long whole = static_cast<long long>(t);
+	if (t < whole)
+		--whole; // floor for negative angles
+	fraction = t - whole;
+	index = static_cast<int>(whole & fineMask);
+}
+
+inline double interpolate(const int index, const double fraction) {
+	return tables.fineSin[index] + fraction * (tables.fineSin[index + 1] - tables.fineSin[index]);
+}
+
+inline std::int32_t interpolateFixed(const std::int32_t* table, const int index,
+                                     const std::int64_t fraction, const int fractionBits)
+{
+	const std::int64_t step = table[index + 1] - table[index];
+	return table[index] + static_cast<std::int32_t>((step * fraction) >> fractionBits);
+}
+
+// atan of a 16.16 ratio between 0 and 1
+inline std::int32_t fixedAtan(const std::int64_t ratio) {
+	const int index = static_cast<int>(ratio >> atanShift);
+	if (index >= atanSteps)
+		return tables.fixedAtan[atanSteps];
+	return interpolateFixed(tables.fixedAtan, index, ratio & ((1 << atanShift) - 1), atanShift);
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////
+// CROBOTS intrinsics
+
+int wrapDegrees(const int degrees) {
+	const int d = degrees % 360;
+	return d < 0 ? d + 360 : d;
+}
+
+int isin(const int degrees) {
+	return tables.degreeSin[wrapDegrees(degrees)];
+}
+
+int icos(const int degrees) {
+	return tables.degreeCos[wrapDegrees(degrees)];
+}
+
+int itan(const int degrees) {
+	return tables.degreeTan[wrapDegrees(degrees)];
+}
+
+int iatan(const int ratio) {
+	// Binary search for the number of whole degrees whose tangent the ratio
+	// reaches; the sign is restored afterward so truncation is toward zero.
+	const double r = ratio < 0 ? -static_cast<double>(ratio) : ratio;
+	int lo = 0, hi = 89;
+	while (lo < hi) {
+		const int mid = (lo + hi + 1) / 2;
+		if (tables.atanLimit[mid] <= r)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return ratio < 0 ? -lo : lo;
+}
+
+////////////////////////////////////////////////////////////
+// Radian lookups
+
+double fastSin(const double radians) {
+	int i;
+	double f;
+	fineIndex(radians, i, f);
+	return interpolate(i, f);
+}
+
+double fastCos(const double radians) {
+	int i;
+	double f;
+	fineIndex(radians, i, f);
+	return interpolate((i + quarterTurn) & fineMask, f);
+}
+
+void fastSinCos(const double radians, double& s, double& c) {
+	int i;
+	double f;
+	fineIndex(radians, i, f);
+	s = interpolate(i, f);
+	c = interpolate((i + quarterTurn) & fineMask, f);
+}
+
+////////////////////////////////////////////////////////////
+// Fixed-point lookups
+
+void fastSinCos(const Fixed radians, Fixed& s, Fixed& c) {
+	// Arithmetic shifts and masks floor negative positions as well.
+	const std::int64_t position = (static_cast<std::int64_t>(radians.raw()) * stepsPerRawAngle) >> Fixed::fractionBits;
+	const int i = static_cast<int>((position >> Fixed::fractionBits) & fineMask);
+	const std::int64_t f = position & (Fixed::one - 1);
+	s = Fixed::fromRaw(interpolateFixed(tables.fixedSin, i, f, Fixed::fractionBits));
+	c = Fixed::fromRaw(interpolateFixed(tables.fixedSin, (i + quarterTurn) & fineMask, f, Fixed::fractionBits));
+}
+
+Fixed fixedDirection(const Fixed dy, const Fixed dx) {
+	const std::int64_t x = dx.raw(), y = dy.raw();
+	const std::int64_t ax = x < 0 ? -x : x;
+	const std::int64_t ay = y < 0 ? -y : y;
+	if (ax == 0 && ay == 0)
+		return Fixed();
+	// fold into the first octant, look up, and unfold
+	std::int32_t a = ay <= ax ? fixedAtan(ay * Fixed::one / ax)
+	                          : fixedHalfPi - fixedAtan(ax * Fixed::one / ay);
+	if (x < 0)
+		a = fixedPi - a;
+	if (y < 0)
+		a = fixedTwoPi - a;
+	return Fixed::fromRaw(a >= fixedTwoPi ? 0 : a);
+}
+
+} // namespace Geometry
@@ -0,0 +1,60 @@
+// Trig.h
+// Table-driven trigonometry for the physics engine and the robot intrinsic
+// library.  Nothing in here calls libm; the tables are built at compile time.
+
+#ifndef Trig_h__
+#define Trig_h__
+
+#include "Fixed.h"
+
+namespace Geometry {
+
+////////////////////////////////////////////////////////////
+//
+// CROBOTS intrinsics
+//
+// The robot CPU is integer only.  sin(), cos() and tan() take whole degrees,
+// forced into 0-359 by a modulo 360 made positive, and return the value
+// scaled by trigScale.  atan() takes a ratio scaled by trigScale and returns
+// whole degrees between -90 and +90.  Results are truncated toward zero, as
+// an integer cast of the libm result would be.
+
+const int trigScale = 100000;
+
+// Forces any degree value into 0-359.
+int wrapDegrees(const int degrees);
+
+int isin(const int degrees);
+int icos(const int degrees);
+int itan(const int degrees); // clamped to the 32-bit range at 90 and 270
+int iatan(const int ratio);
+
+////////////////////////////////////////////////////////////
+//
+// Radian lookups
+//
+// Used by Entity::move() and friends.  Angles may be any finite value; the
+// result is linearly interpolated between table entries, which keeps the
+// absolute error below 3e-7.
+
+double fastSin(const double radians);
+double fastCos(const double radians);
+void fastSinCos(const double radians, double& sin, double& cos);
+
+////////////////////////////////////////////////////////////
+//
+// Fixed-point lookups
+//
+// The same tables rounded to Fixed and read with integer arithmetic only, so
+// results are bit-identical on every machine.  Errors stay within a few
+// units in the last place of Fixed.
+
+void fastSinCos(const Fixed radians, Fixed& sin, Fixed& cos);
+
+// The direction of the vector (dx, dy), anti-clockwise from the positive x
+// axis, between 0 and 2pi.  Zero for the zero vector.
+Fixed fixedDirection(const Fixed dy, const Fixed dx);
+
+} // namespace Geometry
+
+#endif // Trig_h__
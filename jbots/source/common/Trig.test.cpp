@@ -0,0 +1,93 @@
+#include "Contrib/UnitTest++/src/UnitTest++.h"
+
+#include <cmath>
+
+#include "../Shared/Trig.h"
+
+SUITE(TrigTestSuite) {
+
+TEST(WrapDegrees) {
+	CHECK_EQUAL(0, Geometry::wrapDegrees(0));
+	CHECK_EQUAL(359, Geometry::wrapDegrees(359));
+	CHECK_EQUAL(5, Geometry::wrapDegrees(365));
+	CHECK_EQUAL(355, Geometry::wrapDegrees(-5));
+	CHECK_EQUAL(0, Geometry::wrapDegrees(-720));
+}
+
+TEST(IntegerSinCos) {
+	CHECK_EQUAL(0, Geometry::isin(0));
+	CHECK_EQUAL(100000, Geometry::isin(90));
+	CHECK_EQUAL(0, Geometry::isin(180));
+	CHECK_EQUAL(-100000, Geometry::isin(270));
+	CHECK_EQUAL(100000, Geometry::icos(0));
+	CHECK_EQUAL(-100000, Geometry::icos(180));
+	CHECK_EQUAL(Geometry::isin(45), Geometry::isin(405));
+	CHECK_EQUAL(Geometry::icos(-30), Geometry::icos(330));
+}
+
+TEST(IntegerMatchesLibm) {
+	const double degToRad = 3.14159265358979323846 / 180.0;
+	for (int d = 0; d < 360; ++d) {
+		CHECK_EQUAL(static_cast<int>(sin(d * degToRad) * 100000), Geometry::isin(d));
+		CHECK_EQUAL(static_cast<int>(cos(d * degToRad) * 100000), Geometry::icos(d));
+		if (d % 90 != 0 || d % 180 == 0)
+			CHECK_EQUAL(static_cast<int>(tan(d * degToRad) * 100000), Geometry::itan(d));
+	}
+}
+
+TEST(IntegerTan) {
+	CHECK_EQUAL(0, Geometry::itan(0));
+	CHECK_EQUAL(0, Geometry::itan(180));
+	CHECK(Geometry::itan(90) > 0);
+	CHECK(Geometry::itan(270) < 0);
+}
+
+TEST(IntegerAtan) {
+	const double radToDeg = 180.0 / 3.14159265358979323846;
+	CHECK_EQUAL(0, Geometry::iatan(0));
+	CHECK_EQUAL(45, Geometry::iatan(100000));
+	CHECK_EQUAL(-45, Geometry::iatan(-100000));
+	CHECK_EQUAL(89, Geometry::iatan(2147483647));
+	for (int r = -1000000; r <= 1000000; r += 997)
+		CHECK_EQUAL(static_cast<int>(atan(r / 100000.0) * radToDeg), Geometry::iatan(r));
+}
+
+TEST(FastSinCos) {
+	for (double r = -20.0; r < 20.0; r += 0.0137) {
+		CHECK_CLOSE(sin(r), Geometry::fastSin(r), 3e-7);
+		CHECK_CLOSE(cos(r), Geometry::fastCos(r), 3e-7);
+		double s, c;
+		Geometry::fastSinCos(r, s, c);
+		CHECK_EQUAL(Geometry::fastSin(r), s);
+		CHECK_EQUAL(Geometry::fastCos(r), c);
+	}
+}
+
+TEST(FixedSinCos) {
+	for (double r = -20.0; r < 20.0; r += 0.0137) {
+		Geometry::Fixed s, c;
+		Geometry::fastSinCos(Geometry::Fixed(r), s, c);
+		const double exact = Geometry::Fixed(r).toDouble();
+		CHECK_CLOSE(sin(exact), s.toDouble(), 3.0 / 65536);
+		CHECK_CLOSE(cos(exact), c.toDouble(), 3.0 / 65536);
+	}
+}
+
+TEST(FixedDirection) {
+	const double twopi = 2 * 3.14159265358979323846;
+	CHECK_EQUAL(0, Geometry::fixedDirection(Geometry::Fixed(), Geometry::Fixed()).raw());
+	CHECK_EQUAL(0, Geometry::fixedDirection(Geometry::Fixed(), Geometry::Fixed(5)).raw());
+	for (double a = 0.0; a < twopi; a += 0.0371) {
+		const Geometry::Fixed dy(300.0 * sin(a)), dx(300.0 * cos(a));
+		double expected = atan2(dy.toDouble(), dx.toDouble());
+		if (expected < 0.0)
+			expected += twopi;
+		const double found = Geometry::fixedDirection(dy, dx).toDouble();
+		CHECK(found >= 0.0 && found < twopi);
+		// wrap-around near zero counts as close
+		const double error = fabs(found - expected);
+		CHECK(error < 3.0 / 65536 || twopi - error < 3.0 / 65536);
+	}
+}
+
+} // suite
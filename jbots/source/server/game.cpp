@@ -8,66 +8,35 @@
 //#include <QtCore>
 #include <QtGui>
 
-class Bot {
-public:
-	typedef std::string Name;
-
-	Bot( char const* const name ) : name_( name ) {}
-	Bot( Bot const& other ) : name_( other.name() ) {}
-
-	Name const& name() const { return name_; }
-	void display() const { std::cout << "bot: " << name() << std::endl; }
+// jbots
+#include "../Shared/Arena.h"
+#include "../Shared/Bot.h"
 
-	virtual void run() = 0;
-
-private:
-	Name name_;
-};
-
-class TestBot : public Bot {
+class Match {
 public:
-	TestBot( char const* const name ) : Bot( name ) {}
-	virtual void run() { /* nothing */ }
-};
+	explicit Match( std::size_t const capacity ) : arena_( capacity ) {}
 
-class Arena {
-public:
-	void display() const {
-		std::cout << "arena" << std::endl;
+	Server::Bot add( char const* const name, Geometry::Point const& position ) {
+		Server::Bot const bot( arena_, arena_.enter( position, Geometry::Angle(), name ) );
+		if ( bot.valid() )
+			bots_.push_back( bot );
+		return bot;
 	}
-};
-
-class Match {
-public:
-	void add( Bot* const bot ) { bots_.push_back( bot ); }
-	void add( Arena* const arena ) { arena_ = arena; }
 
 	void display() const { 
 		std::cout << "match" << std::endl;
-		arena_->display();
-		for ( Bots::const_iterator bot = bots_.begin();
+		std::cout << "arena" << std::endl;
+		for ( Server::Bots::const_iterator bot = bots_.begin();
 			  bot != bots_.end();
 			  ++bot )
 		{
-			(*bot)->display();
+			std::cout << "bot: " << bot->name() << std::endl;
 		}
 	}
 
-	~Match() {
-		for ( Bots::iterator bot = bots_.begin();
-			  bot != bots_.end();
-			  ++bot )
-		{
-			delete *bot;
-			*bot = NULL;
-		}
-		delete arena_;
-	}
-	
 private:
-	typedef std::vector<Bot*> Bots;
-	Bots bots_;
-	Arena* arena_;
+	Server::Arena arena_;  // owns every bot's state
+	Server::Bots bots_;    // handles into arena_
 };
 
 class MainWindow : public QWidget {
@@ -99,10 +68,9 @@ int main( int argc, char** argv ) {
 	textEdit.show();
 #endif
 	
-	Match match;
-	match.add( new TestBot( "test1" ) );
-	match.add( new TestBot( "test2" ) );
-	match.add( new Arena() );
+	Match match( 2 );
+	match.add( "test1", Geometry::Point( 250, 250 ) );
+	match.add( "test2", Geometry::Point( 750, 750 ) );
 	match.display();
 	
 	return app.exec();